@@ -0,0 +1,396 @@
+#include <logcoe.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // streambuf that accepts and discards everything, used for the "null" sink
+    class NullBuffer : public std::streambuf
+    {
+    protected:
+        int overflow(int c) override { return traits_type::not_eof(c); }
+        std::streamsize xsputn(const char *, std::streamsize n) override { return n; }
+    };
+
+    enum class Sink
+    {
+        NUL,
+        FILE,
+        MMAP,
+        URING,
+        CONSOLE
+    };
+
+    struct Scenario
+    {
+        Sink sink = Sink::NUL;
+        int threads = 1;
+        bool flush = false;
+        std::size_t messageSize = 128;
+        bool filtered = false;
+        bool async = false;
+    };
+
+    struct Result
+    {
+        Scenario scenario;
+        std::uint64_t messages = 0;
+        double seconds = 0.0;
+        std::uint64_t p50 = 0;
+        std::uint64_t p99 = 0;
+        std::uint64_t p999 = 0;
+        std::uint64_t max = 0;
+    };
+
+    struct Options
+    {
+        std::vector<int> threads;
+        std::vector<Sink> sinks{Sink::NUL, Sink::FILE, Sink::MMAP, Sink::URING, Sink::CONSOLE};
+        std::vector<std::size_t> sizes{16, 128, 1024};
+        int messagesPerThread = 20000;
+        bool includeAsync = false;
+        bool csv = false;
+        std::string outputPath;
+        std::string layout;
+    };
+
+#ifdef _WIN32
+    constexpr const char *nullDevice = "NUL";
+#else
+    constexpr const char *nullDevice = "/dev/null";
+#endif
+
+    const char *sinkName(Sink sink)
+    {
+        switch (sink)
+        {
+        case Sink::FILE:
+            return "file";
+        case Sink::MMAP:
+            return "mmap";
+        case Sink::URING:
+            return "uring";
+        case Sink::CONSOLE:
+            return "console";
+        default:
+            return "null";
+        }
+    }
+
+    std::vector<std::string> split(const std::string &list)
+    {
+        std::vector<std::string> items;
+        std::stringstream stream(list);
+        std::string item;
+        while (std::getline(stream, item, ','))
+        {
+            if (!item.empty())
+                items.push_back(item);
+        }
+        return items;
+    }
+
+    std::vector<int> defaultThreadCounts()
+    {
+        int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        std::vector<int> counts;
+        for (int count = 1; count < cores; count *= 2)
+            counts.push_back(count);
+        counts.push_back(cores);
+        return counts;
+    }
+
+    void printUsage()
+    {
+        std::cerr << "usage: logcoe_bench [options]\n"
+                     "  --threads=1,2,4      thread counts (default: powers of two up to the core count)\n"
+                     "  --sinks=null,file,mmap,uring,console\n"
+                     "  --sizes=16,128,1024  message sizes in bytes\n"
+                     "  --messages=N         messages per thread (default 20000)\n"
+                     "  --async              also run every scenario in async mode\n"
+                     "  --layout=PATTERN     text layout passed to setLayout(), e.g. \"%d %-7L %t %m\"\n"
+                     "  --format=json|csv    output format (default json)\n"
+                     "  --output=FILE        write results to FILE instead of stdout\n";
+    }
+
+    bool parseOptions(int argc, char **argv, Options &options)
+    {
+        options.threads = defaultThreadCounts();
+
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string argument = argv[i];
+            auto separator = argument.find('=');
+            std::string name = argument.substr(0, separator);
+            std::string value = separator == std::string::npos ? "" : argument.substr(separator + 1);
+
+            try
+            {
+                if (name == "--threads")
+                {
+                    options.threads.clear();
+                    for (const auto &item : split(value))
+                        options.threads.push_back(std::max(1, std::stoi(item)));
+                }
+                else if (name == "--sinks")
+                {
+                    options.sinks.clear();
+                    for (const auto &item : split(value))
+                    {
+                        if (item == "null")
+                            options.sinks.push_back(Sink::NUL);
+                        else if (item == "file")
+                            options.sinks.push_back(Sink::FILE);
+                        else if (item == "mmap")
+                            options.sinks.push_back(Sink::MMAP);
+                        else if (item == "uring")
+                            options.sinks.push_back(Sink::URING);
+                        else if (item == "console")
+                            options.sinks.push_back(Sink::CONSOLE);
+                        else
+                            return false;
+                    }
+                }
+                else if (name == "--sizes")
+                {
+                    options.sizes.clear();
+                    for (const auto &item : split(value))
+                        options.sizes.push_back(static_cast<std::size_t>(std::stoul(item)));
+                }
+                else if (name == "--messages")
+                    options.messagesPerThread = std::max(1, std::stoi(value));
+                else if (name == "--async")
+                    options.includeAsync = true;
+                else if (name == "--format" && (value == "json" || value == "csv"))
+                    options.csv = value == "csv";
+                else if (name == "--output" && !value.empty())
+                    options.outputPath = value;
+                else if (name == "--layout" && !value.empty())
+                    options.layout = value;
+                else
+                    return false;
+            }
+            catch (const std::exception &)
+            {
+                return false;
+            }
+        }
+
+        return !options.threads.empty() && !options.sinks.empty() && !options.sizes.empty();
+    }
+
+    std::uint64_t percentile(std::vector<std::uint64_t> &sorted, double fraction)
+    {
+        if (sorted.empty())
+            return 0;
+        auto index = static_cast<std::size_t>(fraction * static_cast<double>(sorted.size() - 1));
+        return sorted[index];
+    }
+
+    Result run(const Scenario &scenario, int messagesPerThread, const std::string &layout)
+    {
+        NullBuffer nullBuffer;
+        std::ostream nullStream(&nullBuffer);
+        std::ofstream consoleTarget;
+        std::streambuf *originalCout = nullptr;
+        std::string filename = "logcoe_bench_" + std::to_string(scenario.threads) + ".log";
+
+        logcoe::AsyncOptions async;
+        async.enabled = scenario.async;
+
+        // console starts disabled so nothing reaches the real stdout, where the results are printed
+        logcoe::LogLevel level = scenario.filtered ? logcoe::LogLevel::WARNING : logcoe::LogLevel::INFO;
+        logcoe::initialize(level, "", false, scenario.sink == Sink::FILE, filename, async);
+        if (!layout.empty())
+            logcoe::setLayout(layout);
+        if (scenario.sink == Sink::NUL)
+            logcoe::setConsoleOutput(nullStream);
+        else if (scenario.sink == Sink::MMAP)
+            logcoe::addSink(logcoe::makeMappedFileSink(filename));
+        else if (scenario.sink == Sink::URING)
+            logcoe::addSink(logcoe::makeUringFileSink(filename));
+        else if (scenario.sink == Sink::CONSOLE)
+        {
+            // the logger keeps writing to std::cout, whose buffer is pointed at the null device
+            consoleTarget.open(nullDevice);
+            originalCout = std::cout.rdbuf(consoleTarget.rdbuf());
+            logcoe::setConsoleOutput(std::cout);
+        }
+
+        const std::string message(scenario.messageSize, 'x');
+        std::vector<std::vector<std::uint64_t>> latencies(scenario.threads);
+        std::atomic<int> ready(0);
+        std::atomic<bool> start(false);
+        std::vector<std::thread> threads;
+
+        for (int t = 0; t < scenario.threads; ++t)
+        {
+            threads.emplace_back([&, t]()
+            {
+                std::vector<std::uint64_t> &samples = latencies[t];
+                samples.reserve(static_cast<std::size_t>(messagesPerThread));
+
+                ready++;
+                while (!start.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+
+                for (int i = 0; i < messagesPerThread; ++i)
+                {
+                    auto before = std::chrono::steady_clock::now();
+                    if (scenario.filtered)
+                        logcoe::debug(message, "Bench", scenario.flush);
+                    else
+                        logcoe::info(message, "Bench", scenario.flush);
+                    auto after = std::chrono::steady_clock::now();
+
+                    samples.push_back(static_cast<std::uint64_t>(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(after - before).count()));
+                }
+            });
+        }
+
+        while (ready.load() < scenario.threads)
+            std::this_thread::yield();
+
+        auto begin = std::chrono::steady_clock::now();
+        start.store(true, std::memory_order_release);
+        for (auto &thread : threads)
+            thread.join();
+        logcoe::flush();
+        auto end = std::chrono::steady_clock::now();
+
+        logcoe::shutdown();
+        if (originalCout)
+            std::cout.rdbuf(originalCout);
+        std::error_code error;
+        std::filesystem::remove(filename, error);
+
+        std::vector<std::uint64_t> all;
+        all.reserve(static_cast<std::size_t>(messagesPerThread) * static_cast<std::size_t>(scenario.threads));
+        for (const auto &samples : latencies)
+            all.insert(all.end(), samples.begin(), samples.end());
+        std::sort(all.begin(), all.end());
+
+        Result result;
+        result.scenario = scenario;
+        result.messages = all.size();
+        result.seconds = std::chrono::duration<double>(end - begin).count();
+        result.p50 = percentile(all, 0.50);
+        result.p99 = percentile(all, 0.99);
+        result.p999 = percentile(all, 0.999);
+        result.max = all.empty() ? 0 : all.back();
+        return result;
+    }
+
+    double messagesPerSecond(const Result &result)
+    {
+        return result.seconds > 0.0 ? static_cast<double>(result.messages) / result.seconds : 0.0;
+    }
+
+    void writeCsv(std::ostream &out, const std::vector<Result> &results)
+    {
+        out << "mode,sink,threads,flush,message_size,filtered,messages,seconds,messages_per_second,"
+               "p50_ns,p99_ns,p999_ns,max_ns\n";
+        for (const auto &result : results)
+        {
+            const Scenario &scenario = result.scenario;
+            out << (scenario.async ? "async" : "sync") << ',' << sinkName(scenario.sink) << ',' << scenario.threads
+                << ',' << (scenario.flush ? "true" : "false") << ',' << scenario.messageSize << ','
+                << (scenario.filtered ? "true" : "false") << ',' << result.messages << ',' << result.seconds << ','
+                << static_cast<std::uint64_t>(messagesPerSecond(result)) << ',' << result.p50 << ',' << result.p99
+                << ',' << result.p999 << ',' << result.max << '\n';
+        }
+    }
+
+    void writeJson(std::ostream &out, const std::vector<Result> &results)
+    {
+        out << "{\n  \"benchmark\": \"logcoe\",\n  \"cores\": " << std::thread::hardware_concurrency()
+            << ",\n  \"results\": [";
+        for (std::size_t i = 0; i < results.size(); ++i)
+        {
+            const Result &result = results[i];
+            const Scenario &scenario = result.scenario;
+            out << (i == 0 ? "\n" : ",\n") << "    {\"mode\": \"" << (scenario.async ? "async" : "sync")
+                << "\", \"sink\": \"" << sinkName(scenario.sink) << "\", \"threads\": " << scenario.threads
+                << ", \"flush\": " << (scenario.flush ? "true" : "false")
+                << ", \"message_size\": " << scenario.messageSize
+                << ", \"filtered\": " << (scenario.filtered ? "true" : "false")
+                << ", \"messages\": " << result.messages << ", \"seconds\": " << result.seconds
+                << ", \"messages_per_second\": " << static_cast<std::uint64_t>(messagesPerSecond(result))
+                << ", \"p50_ns\": " << result.p50 << ", \"p99_ns\": " << result.p99
+                << ", \"p999_ns\": " << result.p999 << ", \"max_ns\": " << result.max << "}";
+        }
+        out << "\n  ]\n}\n";
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 2;
+    }
+
+    std::vector<Scenario> scenarios;
+    for (bool async : {false, true})
+    {
+        if (async && !options.includeAsync)
+            continue;
+
+        for (int threads : options.threads)
+        {
+            for (Sink sink : options.sinks)
+            {
+                for (bool flush : {false, true})
+                {
+                    for (std::size_t size : options.sizes)
+                        scenarios.push_back(Scenario{sink, threads, flush, size, false, async});
+                }
+            }
+
+            // the cost of a call whose level is filtered out, independent of sink and size
+            scenarios.push_back(Scenario{Sink::NUL, threads, false, options.sizes.front(), true, async});
+        }
+    }
+
+    std::vector<Result> results;
+    for (std::size_t i = 0; i < scenarios.size(); ++i)
+    {
+        const Scenario &scenario = scenarios[i];
+        std::cerr << "[" << i + 1 << "/" << scenarios.size() << "] " << (scenario.async ? "async " : "sync ")
+                  << sinkName(scenario.sink) << " threads=" << scenario.threads
+                  << " flush=" << (scenario.flush ? "true" : "false") << " size=" << scenario.messageSize
+                  << (scenario.filtered ? " filtered" : "") << std::endl;
+        results.push_back(run(scenario, options.messagesPerThread, options.layout));
+    }
+
+    std::ofstream file;
+    if (!options.outputPath.empty())
+    {
+        file.open(options.outputPath);
+        if (!file.is_open())
+        {
+            std::cerr << "logcoe_bench: failed to open " << options.outputPath << std::endl;
+            return 1;
+        }
+    }
+    std::ostream &out = file.is_open() ? static_cast<std::ostream &>(file) : std::cout;
+
+    if (options.csv)
+        writeCsv(out, results);
+    else
+        writeJson(out, results);
+
+    return 0;
+}
@@ -1,6 +1,30 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <sstream>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#define LOGCOE_LEVEL_DEBUG 0
+#define LOGCOE_LEVEL_INFO 1
+#define LOGCOE_LEVEL_WARNING 2
+#define LOGCOE_LEVEL_ERROR 3
+#define LOGCOE_LEVEL_NONE 4
+
+// Lowest level compiled in by the LOGCOE_* macros, set through the LOGCOE_ACTIVE_LEVEL CMake cache variable
+#ifndef LOGCOE_ACTIVE_LEVEL
+#define LOGCOE_ACTIVE_LEVEL LOGCOE_LEVEL_DEBUG
+#endif
 
 namespace logcoe
 {
@@ -13,11 +37,400 @@ namespace logcoe
         NONE
     };
 
+    enum class OverflowPolicy
+    {
+        BLOCK,
+        DROP_NEWEST,
+        DROP_OLDEST
+    };
+
+    enum class TimePrecision
+    {
+        SECONDS,
+        MILLISECONDS,
+        MICROSECONDS,
+        NANOSECONDS
+    };
+
+    struct SourceLocation
+    {
+        const char *file;
+        int line;
+        const char *function;
+    };
+
+    struct AsyncOptions
+    {
+        bool enabled = false;
+        std::size_t queueCapacity = 8192;
+        OverflowPolicy overflowPolicy = OverflowPolicy::BLOCK;
+    };
+
+    enum class Compression
+    {
+        NONE,
+        GZIP,
+        ZSTD
+    };
+
+    // File output rotation, every limit is disabled when zero.
+    // Rotated files are named <stem>.<YYYYmmdd-HHMMSS>.<NNN><extension> and are compressed and pruned
+    // on a background thread.
+    struct RotationOptions
+    {
+        std::uint64_t maxBytes = 0;
+        std::chrono::seconds interval{0};
+        std::size_t maxFiles = 0;
+        Compression compression = Compression::NONE;
+    };
+
+    // Line layout of every output: "[time] [LEVEL] [source]: message key=value", one JSON object per line,
+    // or logfmt (time=... level=... msg=... key=value)
+    enum class OutputFormat
+    {
+        TEXT,
+        JSON,
+        LOGFMT
+    };
+
+    // Typed key-value pair attached to a record: info("request done", {{"status", 200}, {"ms", 3.2}}).
+    // Keys and string values are referenced, not copied, and only need to live until the call returns.
+    struct Field
+    {
+        enum class Type : std::uint8_t
+        {
+            BOOL,
+            INT,
+            UINT,
+            DOUBLE,
+            STRING
+        };
+
+        std::string_view key;
+        Type type = Type::STRING;
+        union
+        {
+            bool boolean;
+            long long integer;
+            unsigned long long unsignedInteger;
+            double number;
+        };
+        std::string_view text;
+
+        template <typename T>
+        Field(std::string_view name, const T &value) : key(name), integer(0)
+        {
+            if constexpr (std::is_same_v<T, bool>)
+            {
+                type = Type::BOOL;
+                boolean = value;
+            }
+            else if constexpr (std::is_enum_v<T>)
+            {
+                type = std::is_signed_v<std::underlying_type_t<T>> ? Type::INT : Type::UINT;
+                integer = static_cast<long long>(value);
+            }
+            else if constexpr (std::is_integral_v<T> && std::is_signed_v<T> && !std::is_same_v<T, char>)
+            {
+                type = Type::INT;
+                integer = value;
+            }
+            else if constexpr (std::is_integral_v<T> && !std::is_same_v<T, char>)
+            {
+                type = Type::UINT;
+                unsignedInteger = value;
+            }
+            else if constexpr (std::is_floating_point_v<T>)
+            {
+                type = Type::DOUBLE;
+                number = static_cast<double>(value);
+            }
+            else if constexpr (std::is_convertible_v<const T &, const char *>)
+            {
+                const char *pointer = value;
+                text = pointer ? std::string_view(pointer) : std::string_view();
+            }
+            else
+            {
+                static_assert(std::is_convertible_v<const T &, std::string_view>,
+                              "logcoe: field values are bool, integer, floating point or string");
+                text = std::string_view(value);
+            }
+        }
+    };
+
+    // When the console and file outputs hand buffered lines to the operating system. Lines logged with flush=false
+    // are collected until one of these triggers, a flush=true call or flush().
+    struct FlushPolicy
+    {
+        std::chrono::milliseconds interval{0}; // a background thread flushes everything this often, 0 disables it
+        std::size_t bytes = 64 * 1024;         // written once this much is buffered, 0 writes every chunk
+        LogLevel level = LogLevel::WARNING;    // records at or above this level are written and flushed at once
+    };
+
+    // Destination for formatted lines. write() receives one or more complete lines, each ending in '\n',
+    // the logger never calls one sink from two threads at once. close() is called once, when the sink is
+    // removed or the logger shuts down, and nothing is written to the sink after it.
+    class Sink
+    {
+    public:
+        virtual ~Sink() = default;
+        virtual void write(std::string_view lines) = 0;
+        virtual void flush() {}
+        virtual void close() {}
+        // Lines still buffered by the logger when the crash handler runs, see setCrashHandler(). Called from a
+        // signal handler while other threads may be stopped anywhere, so only async-signal-safe calls such as
+        // write(2) are allowed. The default drops them.
+        virtual void writeOnCrash(std::string_view) {}
+        // Lines the sink discarded itself, e.g. while its destination was too slow, reported in SinkStats
+        virtual std::uint64_t dropped() const { return 0; }
+    };
+
+    class NullSink : public Sink
+    {
+    public:
+        void write(std::string_view) override {}
+    };
+
+    struct SinkOptions
+    {
+        LogLevel level = LogLevel::DEBUG;     // lowest level written to this sink
+        std::size_t bufferSize = 0;           // bytes held back between write() calls, 0 writes every chunk
+        LogLevel flushLevel = LogLevel::NONE; // records at or above this level flush the sink immediately
+    };
+
+    enum class SocketType
+    {
+        DATAGRAM, // one line per datagram, without its '\n'
+        STREAM    // lines as they are, in order
+    };
+
+    // Records from `level` up to the output level are kept unformatted in a ring of `records` per thread instead of
+    // being written. A record at `trigger` or above writes them first, oldest first, see dumpRecent().
+    struct FlightRecorderOptions
+    {
+        LogLevel level = LogLevel::DEBUG;
+        std::size_t records = 256;          // per thread, 0 turns the recorder off
+        LogLevel trigger = LogLevel::ERROR; // NONE leaves dumping to dumpRecent()
+    };
+
+    struct SocketOptions
+    {
+        SocketType type = SocketType::DATAGRAM;
+        std::chrono::milliseconds reconnectInterval{1000}; // wait between attempts while the socket is unreachable
+        std::size_t backlog = 256 * 1024; // STREAM: bytes held while the peer is slow or missing, later lines are dropped
+    };
+
+    // The shared-memory ring of startCollector(), named like shm_open() names: "/myapp-log"
+    struct SharedLogOptions
+    {
+        std::size_t capacity = 4 * 1024 * 1024; // bytes of lines in flight, rounded up to whole pages
+        unsigned int permissions = 0600;        // for workers that run as another user
+    };
+
+    using SinkId = std::uint32_t;
+
+    // Counters of one output since it was added. The console and file outputs have id 0 and their name.
+    struct SinkStats
+    {
+        SinkId id = 0;
+        std::string name;
+        std::uint64_t lines = 0;    // lines at or above the sink's level
+        std::uint64_t filtered = 0; // lines below it
+        std::uint64_t bytes = 0;
+        std::uint64_t writes = 0;   // Sink::write() calls
+        std::uint64_t flushes = 0;
+        std::size_t buffered = 0;   // bytes waiting in the sink's buffer
+        std::uint64_t dropped = 0;  // lines the sink discarded, see Sink::dropped()
+        std::uint64_t lockContentions = 0; // writes and flushes that had to wait for another thread using the sink
+        std::uint64_t lockWaitNanoseconds = 0;
+    };
+
+    // The logger's own work since the process started, summed over per-thread counters by getStats().
+    // Calls rejected by the inline level check are not counted, that check stays a single load.
+    struct LogStats
+    {
+        // bucket i holds calls faster than latencyLimit(i) nanoseconds, the last one everything slower
+        static constexpr std::size_t latencyBuckets = 16;
+        static constexpr std::uint64_t latencyLimit(std::size_t bucket) { return std::uint64_t{64} << bucket; }
+
+        std::uint64_t accepted[4] = {};   // by LogLevel, records that passed the call site and were staged or queued
+        std::uint64_t filtered[4] = {};   // by LogLevel, records the writer dropped for a level raised meanwhile
+        std::uint64_t bytesWritten = 0;
+        std::uint64_t writes = 0;
+        std::uint64_t flushes = 0;
+        std::uint64_t lockContentions = 0; // acquisitions of the output, sink and staging locks that had to wait
+        std::uint64_t lockWaitNanoseconds = 0;
+        std::uint64_t latency[latencyBuckets] = {}; // duration of every 16th log call of each thread
+        std::size_t queueDepth = 0;       // async records not written yet
+        std::size_t queueCapacity = 0;
+        std::uint64_t dropped = 0;        // same as getDroppedMessageCount()
+        std::uint64_t recorded = 0;       // records kept by the flight recorder instead of being written
+        std::vector<SinkStats> sinks;
+
+        // upper bound of the latency bucket holding the given fraction of the samples, 0 without samples
+        std::uint64_t latencyPercentile(double fraction) const
+        {
+            std::uint64_t total = 0;
+            for (std::uint64_t count : latency)
+                total += count;
+            if (total == 0)
+                return 0;
+
+            std::uint64_t seen = 0;
+            for (std::size_t bucket = 0; bucket + 1 < latencyBuckets; ++bucket)
+            {
+                seen += latency[bucket];
+                if (static_cast<double>(seen) >= fraction * static_cast<double>(total))
+                    return latencyLimit(bucket);
+            }
+            return latencyLimit(latencyBuckets - 1);
+        }
+    };
+
+    namespace detail
+    {
+        // One per interned source name, never freed so handles stay valid during static destruction
+        struct SourceState
+        {
+            std::uint32_t id = 0;
+            std::string name;
+            std::string prefix;                             // " [name]", copied as-is into text lines
+            std::atomic<LogLevel> threshold{LogLevel::NONE}; // lowest level logged for this source right now
+            std::atomic<LogLevel> output{LogLevel::NONE};    // lowest level written, threshold minus the recorder
+            bool overridden = false;                        // level replaces the global level (logger mutex)
+            LogLevel level = LogLevel::NONE;
+        };
+    }
+
+    // Interned source: logcoe::source("Network") returns the same handle for the same name. Logging through a
+    // handle skips the per-call source string, and setLevel() filters this source apart from the global level,
+    // e.g. DEBUG for one noisy component while everything else stays at INFO.
+    class Source
+    {
+    public:
+        const std::string &name() const { return m_state->name; }
+        std::uint32_t id() const { return m_state->id; }
+
+        bool isEnabled(LogLevel level) const
+        {
+            return static_cast<int>(level) >= static_cast<int>(m_state->threshold.load(std::memory_order_relaxed));
+        }
+
+        void setLevel(LogLevel level) const;
+        void resetLevel() const; // follow the global level again
+        LogLevel getLevel() const;
+
+        const detail::SourceState &state() const { return *m_state; }
+
+    private:
+        explicit Source(detail::SourceState *state) : m_state(state) {}
+        friend Source source(std::string_view name);
+
+        detail::SourceState *m_state;
+    };
+
+    Source source(std::string_view name);
+
+    // Per-call-site limit for log storms, see LOGCOE_ERROR_LIMITED and friends. A call is logged when it passes
+    // both the sampling (the first `first` calls, then every `everyN`th) and the token bucket (`perSecond`
+    // refill, `burst` capacity, 0 disables it). Calls dropped by the bucket, and identical consecutive messages
+    // when suppressDuplicates is set, are reported in a summary line the next time the site logs.
+    struct LogLimit
+    {
+        std::uint32_t first = 0;
+        std::uint32_t everyN = 1;
+        double perSecond = 0.0;
+        std::uint32_t burst = 1;
+        bool suppressDuplicates = false;
+
+        static constexpr LogLimit every(std::uint32_t n) { return LogLimit{0, n, 0.0, 1, false}; }
+        static constexpr LogLimit firstThenEvery(std::uint32_t first, std::uint32_t n)
+        {
+            return LogLimit{first, n, 0.0, 1, false};
+        }
+        static constexpr LogLimit rate(double perSecond, std::uint32_t burst = 1)
+        {
+            return LogLimit{0, 1, perSecond, burst, false};
+        }
+        static constexpr LogLimit duplicates() { return LogLimit{0, 1, 0.0, 1, true}; }
+    };
+
+    // Lock-free state of one call site, decided before the message is built
+    class LogLimiter
+    {
+    public:
+        explicit LogLimiter(const LogLimit &limit)
+            : m_first(limit.first), m_everyN(limit.everyN == 0 ? 1 : limit.everyN),
+              m_interval(limit.perSecond > 0.0 ? static_cast<std::int64_t>(1e9 / limit.perSecond) : 0),
+              m_tolerance(m_interval * static_cast<std::int64_t>(limit.burst == 0 ? 0 : limit.burst - 1)),
+              m_suppressDuplicates(limit.suppressDuplicates) {}
+
+        LogLimiter(const LogLimiter &) = delete;
+        LogLimiter &operator=(const LogLimiter &) = delete;
+
+        bool allow()
+        {
+            std::uint64_t call = m_calls.fetch_add(1, std::memory_order_relaxed);
+            if (call >= m_first && (call - m_first) % m_everyN != 0)
+                return false;
+            if (m_interval == 0)
+                return true;
+
+            // token bucket as a theoretical arrival time (GCRA), one CAS per admitted call
+            std::int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now().time_since_epoch()).count();
+            std::int64_t arrival = m_arrival.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                std::int64_t next = (arrival > now ? arrival : now) + m_interval;
+                if (next - now > m_tolerance + m_interval)
+                {
+                    m_suppressed.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                if (m_arrival.compare_exchange_weak(arrival, next, std::memory_order_relaxed))
+                    return true;
+            }
+        }
+
+        bool suppressesDuplicates() const { return m_suppressDuplicates; }
+
+        // Dropped by the bucket since the last call, reset to zero
+        std::uint64_t takeSuppressed() { return m_suppressed.exchange(0, std::memory_order_relaxed); }
+
+        // Identical to the previous message of this site: counted and false. Otherwise the number of repeats of
+        // the previous message, reset to zero.
+        bool admitMessage(std::uint64_t hash, std::uint64_t &repeats)
+        {
+            if (m_lastHash.exchange(hash, std::memory_order_relaxed) == hash)
+            {
+                m_repeats.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            repeats = m_repeats.exchange(0, std::memory_order_relaxed);
+            return true;
+        }
+
+    private:
+        const std::uint64_t m_first;
+        const std::uint64_t m_everyN;
+        const std::int64_t m_interval;
+        const std::int64_t m_tolerance;
+        const bool m_suppressDuplicates;
+        std::atomic<std::uint64_t> m_calls{0};
+        std::atomic<std::int64_t> m_arrival{0};
+        std::atomic<std::uint64_t> m_suppressed{0};
+        std::atomic<std::uint64_t> m_lastHash{0};
+        std::atomic<std::uint64_t> m_repeats{0};
+    };
+
     void initialize(LogLevel level = LogLevel::DEBUG,
                     const std::string &defaultSource = "",
                     bool enableConsole = true,
                     bool enableFile = false,
-                    const std::string &filename = "logcoe.log");
+                    const std::string &filename = "logcoe.log",
+                    const AsyncOptions &async = AsyncOptions{});
     void shutdown();
 
     void setLogLevel(LogLevel level);
@@ -25,15 +438,764 @@ namespace logcoe
     bool setFileOutput(const std::string &filename);
     void disableConsoleOutput();
     void disableFileOutput();
-    void setTimeFormat(const std::string &format);
+    void setTimeFormat(const std::string &format, TimePrecision precision = TimePrecision::SECONDS);
+    void setFileRotation(const RotationOptions &options);
+    void setFlushPolicy(const FlushPolicy &policy);
+    void setOutputFormat(OutputFormat format);
+    // Layout of TEXT lines, compiled once here. %d time (setTimeFormat), %L level, %S source, %t thread number,
+    // %n line number (from 1 for each layout set), %m message, %% for '%'. A width pads a value, '-' aligns it
+    // left: "%d %-7L %S: %m".
+    // Fields follow the layout. An empty pattern restores the built-in layout, an invalid one is reported and ignored.
+    void setLayout(const std::string &pattern);
+
+    // Sinks in addition to the console and file outputs, removed by shutdown().
+    // makeFileSink() returns nullptr when the file cannot be opened, syncOnFlush also syncs it to disk on flush.
+    std::shared_ptr<Sink> makeFileSink(const std::string &filename, bool syncOnFlush = false);
+    // Appends into memory-mapped segments of segmentSize bytes, preallocated one at a time, the file is cut to its
+    // real length on close(). syncOnFlush schedules an asynchronous write-back on flush. When a segment cannot be
+    // reserved or mapped (disk full, file size limit) later lines are written with pwrite(), lines that fails for
+    // are counted in dropped(). Falls back to makeFileSink() where memory mapping is not available.
+    std::shared_ptr<Sink> makeMappedFileSink(const std::string &filename, std::size_t segmentSize = 16 * 1024 * 1024,
+                                             bool syncOnFlush = false);
+    // Linux: copies lines into `buffers` registered buffers of bufferSize bytes and writes each full one through
+    // io_uring, so logging goes on while the others are written. flush() submits the partly filled buffer without
+    // waiting for it (a few lines with nothing in flight are written directly), with syncOnFlush followed by an
+    // fdatasync that runs after every earlier write. close() waits for all of them. Falls back to makeFileSink()
+    // where io_uring is not available or not permitted.
+    std::shared_ptr<Sink> makeUringFileSink(const std::string &filename, bool syncOnFlush = false,
+                                            std::size_t bufferSize = 256 * 1024, std::size_t buffers = 4);
+    std::shared_ptr<Sink> makeStreamSink(std::ostream &stream);
+    // Sends lines to a local UNIX domain socket, e.g. a syslog or journald style collector, with non-blocking
+    // batched sends. Lines the collector cannot take right away are dropped and counted in SinkStats::dropped, a
+    // missing collector is reconnected on its own. Returns nullptr for a path that does not fit a socket address
+    // and where UNIX domain sockets are not available.
+    std::shared_ptr<Sink> makeSocketSink(const std::string &path, const SocketOptions &options = SocketOptions{});
+    SinkId addSink(std::shared_ptr<Sink> sink, const SinkOptions &options = SinkOptions{});
+    bool removeSink(SinkId id);
+    bool setSinkLevel(SinkId id, LogLevel level);
 
     bool isInitialized();
     LogLevel getLogLevel();
+    bool isAsync();
+    std::uint64_t getDroppedMessageCount();
+    LogStats getStats();
+    // Opt-in: on SIGSEGV, SIGABRT, SIGBUS, SIGFPE or std::terminate the lines still buffered for each sink, followed
+    // by a "[logcoe] FATAL" marker, are handed to Sink::writeOnCrash() before the previous handler runs. The built-in
+    // console and file sinks write them with write(2), so flush=false loses nothing on a crash. Records still in the
+    // async queue are not formatted there and are lost. Removed by shutdown().
+    void setCrashHandler(bool enabled);
+    // Logs the main counters as an INFO "[logcoe] stats" line with fields every interval, into the sink with the
+    // given id or every output for 0. A zero interval stops the report, shutdown() stops it as well.
+    void setStatsReport(std::chrono::milliseconds interval, SinkId sink = 0);
+    // Opt-in: keeps recent records below the log level in memory, see FlightRecorderOptions. isEnabled() and the
+    // call-site checks pass from options.level on while it records. Removed by shutdown().
+    void setFlightRecorder(const FlightRecorderOptions &options);
+    // Writes the recorded records of every thread in time order, to every output whose level admits an ERROR,
+    // after a "[logcoe] Flight recorder" line. They are written once, a later dump only has newer ones.
+    void dumpRecent();
+    // Multi-process logging, e.g. pre-forked workers writing one log file. The collector process creates the ring
+    // and a thread that writes every line the workers put into it to its own outputs, in the order the lines were
+    // added. stopCollector() and shutdown() write what is left, stop the thread and remove the ring. A collector
+    // that forks keeps the thread, its children can become workers. The child of any fork logs synchronously, without
+    // the flush timer or stats report, until shutdown() and initialize(). See also the logcoe-collector tool.
+    bool startCollector(const std::string &name, const SharedLogOptions &options = SharedLogOptions{});
+    void stopCollector();
+    // Worker: formatted lines go into the collector's ring instead of this process's outputs, which stay configured
+    // and are used again after disableSharedOutput(). Never waits, lines that do not fit a full ring are dropped and
+    // reported by the collector. Returns false when no collector created the ring.
+    bool setSharedOutput(const std::string &name);
+    void disableSharedOutput();
+    bool isCompressionSupported(Compression compression);
+
+    // Records from the LOGCOE_BINARY_* macros are written to this file without text formatting,
+    // decode it with decodeBinaryLog() or the logcoe-decode tool.
+    // Without a binary output they are formatted on a background thread into the regular outputs.
+    bool setBinaryOutput(const std::string &filename);
+    void disableBinaryOutput();
+    bool decodeBinaryLog(const std::string &filename, std::ostream &out);
 
-    void debug(const std::string &message, const std::string &source = "", bool flush = true);
-    void info(const std::string &message, const std::string &source = "", bool flush = true);
-    void warning(const std::string &message, const std::string &source = "", bool flush = true);
-    void error(const std::string &message, const std::string &source = "", bool flush = true);
     void flush();
 
-} // namespace logcoe
\ No newline at end of file
+    namespace detail
+    {
+        // Lowest level that can currently reach an output, NONE while not initialized.
+        // Written by the logger under its mutex, read lock-free by every log call without a Source handle.
+        extern std::atomic<LogLevel> activeLevel;
+        // Lowest level written to an output, above activeLevel while the flight recorder keeps the levels between
+        extern std::atomic<LogLevel> outputLevel;
+
+        void log(LogLevel level, std::string_view message, std::string_view source, bool flush);
+        void logAt(LogLevel level, const SourceLocation &location, std::string_view message, bool flush = true);
+        void logFields(LogLevel level, std::string_view message, const Field *fields, std::size_t count,
+                       std::string_view source, bool flush);
+        void logSource(LogLevel level, const SourceState &source, std::string_view message, bool flush,
+                       const Field *fields = nullptr, std::size_t count = 0);
+
+        // Type-erased "{}" argument, the formatter calls append(out, value) in placeholder order. encode(out, value)
+        // appends the value in the binary log's encoding instead, for the flight recorder to format it later.
+        struct FormatArgument
+        {
+            const void *value;
+            void (*append)(std::string &out, const void *value);
+            void (*encode)(std::string &out, const void *value);
+        };
+
+        void logFormatted(LogLevel level, const SourceLocation *location, std::string_view format,
+                          const FormatArgument *arguments, std::size_t count,
+                          const SourceState *source = nullptr);
+        // false when placeholders and arguments do not line up: unmatched "{}" are kept and extra arguments dropped
+        bool formatTo(std::string &out, std::string_view format, const FormatArgument *arguments, std::size_t count);
+
+        void appendValue(std::string &out, bool value);
+        void appendValue(std::string &out, char value);
+        void appendValue(std::string &out, long long value);
+        void appendValue(std::string &out, unsigned long long value);
+        void appendValue(std::string &out, double value);
+        void appendValue(std::string &out, const void *value);
+        void appendValue(std::string &out, const char *value);
+        void appendValue(std::string &out, std::string_view value);
+
+        template <typename T, typename = void>
+        struct IsStreamable : std::false_type {};
+
+        template <typename T>
+        struct IsStreamable<T, std::void_t<decltype(std::declval<std::ostream &>() << std::declval<const T &>())>>
+            : std::true_type {};
+
+        // Fallback for types without a dedicated formatter, only these go through iostreams
+        template <typename T>
+        void appendStreamed(std::string &out, const T &value);
+
+        template <typename T>
+        void appendFormatted(std::string &out, const T &value)
+        {
+            if constexpr (std::is_same_v<T, bool> || std::is_same_v<T, char>)
+                appendValue(out, value);
+            else if constexpr (std::is_enum_v<T>)
+                appendFormatted(out, static_cast<std::underlying_type_t<T>>(value));
+            else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+                appendValue(out, static_cast<long long>(value));
+            else if constexpr (std::is_integral_v<T>)
+                appendValue(out, static_cast<unsigned long long>(value));
+            else if constexpr (std::is_floating_point_v<T>)
+                appendValue(out, static_cast<double>(value));
+            else if constexpr (std::is_convertible_v<const T &, const char *>)
+                appendValue(out, static_cast<const char *>(value));
+            else if constexpr (std::is_convertible_v<const T &, std::string_view>)
+                appendValue(out, std::string_view(value));
+            else if constexpr (std::is_pointer_v<T> || std::is_null_pointer_v<T>)
+                appendValue(out, static_cast<const void *>(value));
+            else
+            {
+                static_assert(IsStreamable<T>::value, "logcoe: argument type cannot be formatted");
+                appendStreamed(out, value);
+            }
+        }
+
+        template <typename T>
+        void appendArgument(std::string &out, const void *value)
+        {
+            appendFormatted(out, *static_cast<const T *>(value));
+        }
+
+        template <typename T>
+        void encodeArgument(std::string &out, const void *value);
+
+        template <typename T>
+        FormatArgument makeFormatArgument(const T &value)
+        {
+            return FormatArgument{&value, &appendArgument<T>, &encodeArgument<T>};
+        }
+
+        constexpr std::size_t countPlaceholders(std::string_view format)
+        {
+            std::size_t count = 0;
+            for (std::size_t i = 0; i < format.size(); ++i)
+            {
+                if (format[i] == '{' && i + 1 < format.size() && format[i + 1] == '{')
+                    ++i;
+                else if (format[i] == '{' && i + 1 < format.size() && format[i + 1] == '}')
+                {
+                    ++count;
+                    ++i;
+                }
+            }
+            return count;
+        }
+
+        // Format string whose placeholder count is known at compile time, see LOGCOE_FMT
+        template <std::size_t Placeholders>
+        struct CheckedFormat
+        {
+            std::string_view format;
+        };
+
+        // true when the arguments after the message fit the (source, flush) overload
+        template <typename... Args>
+        struct IsSourceAndFlush : std::false_type {};
+
+        template <typename Source>
+        struct IsSourceAndFlush<Source> : std::is_convertible<const Source &, std::string_view> {};
+
+        template <typename Source, typename Flush>
+        struct IsSourceAndFlush<Source, Flush>
+            : std::bool_constant<std::is_convertible_v<const Source &, std::string_view> && std::is_same_v<Flush, bool>> {};
+
+        template <typename... Args>
+        void logFormat(LogLevel level, const SourceLocation *location, std::string_view format, const Args &...args)
+        {
+            if constexpr (sizeof...(Args) == 0)
+                logFormatted(level, location, format, nullptr, 0);
+            else
+            {
+                const FormatArgument arguments[] = {makeFormatArgument(args)...};
+                logFormatted(level, location, format, arguments, sizeof...(Args));
+            }
+        }
+
+        template <typename... Args>
+        void logSourceFormat(LogLevel level, const SourceState &source, std::string_view format, const Args &...args)
+        {
+            if constexpr (sizeof...(Args) == 0)
+                logFormatted(level, nullptr, format, nullptr, 0, &source);
+            else
+            {
+                const FormatArgument arguments[] = {makeFormatArgument(args)...};
+                logFormatted(level, nullptr, format, arguments, sizeof...(Args), &source);
+            }
+        }
+
+        template <typename... Args, typename = std::enable_if_t<(sizeof...(Args) > 0) &&
+                                                                !std::is_same_v<std::tuple<Args...>, std::tuple<bool>>>>
+        void logAt(LogLevel level, const SourceLocation &location, std::string_view format, const Args &...args)
+        {
+            logFormat(level, &location, format, args...);
+        }
+
+        // Summaries of what the limiter dropped, then the message unless it repeats the previous one
+        void logLimited(LogLevel level, const SourceLocation &location, LogLimiter &limiter, std::string_view format,
+                        const FormatArgument *arguments, std::size_t count, bool flush);
+
+        inline void logLimitedAt(LogLevel level, const SourceLocation &location, LogLimiter &limiter,
+                                 std::string_view message, bool flush = true)
+        {
+            logLimited(level, location, limiter, message, nullptr, 0, flush);
+        }
+
+        template <typename... Args, typename = std::enable_if_t<(sizeof...(Args) > 0) &&
+                                                                !std::is_same_v<std::tuple<Args...>, std::tuple<bool>>>>
+        void logLimitedAt(LogLevel level, const SourceLocation &location, LogLimiter &limiter, std::string_view format,
+                          const Args &...args)
+        {
+            const FormatArgument arguments[] = {makeFormatArgument(args)...};
+            logLimited(level, location, limiter, format, arguments, sizeof...(Args), true);
+        }
+
+        template <std::size_t Placeholders, typename... Args>
+        void logLimitedAt(LogLevel level, const SourceLocation &location, LogLimiter &limiter,
+                          const CheckedFormat<Placeholders> &format, const Args &...args)
+        {
+            static_assert(Placeholders == sizeof...(Args),
+                          "logcoe: format string placeholder count does not match the number of arguments");
+            if constexpr (sizeof...(Args) == 0)
+                logLimited(level, location, limiter, format.format, nullptr, 0, true);
+            else
+            {
+                const FormatArgument arguments[] = {makeFormatArgument(args)...};
+                logLimited(level, location, limiter, format.format, arguments, sizeof...(Args), true);
+            }
+        }
+
+        template <std::size_t Placeholders, typename... Args>
+        void logAt(LogLevel level, const SourceLocation &location, const CheckedFormat<Placeholders> &format,
+                   const Args &...args)
+        {
+            static_assert(Placeholders == sizeof...(Args),
+                          "logcoe: format string placeholder count does not match the number of arguments");
+            logFormat(level, &location, format.format, args...);
+        }
+
+        constexpr const char *fileName(const char *path)
+        {
+            const char *name = path;
+            for (const char *it = path; *it; ++it)
+            {
+                if (*it == '/' || *it == '\\')
+                    name = it + 1;
+            }
+            return name;
+        }
+
+        enum class BinaryTag : std::uint8_t
+        {
+            BOOL,
+            CHAR,
+            INT,
+            UINT,
+            DOUBLE,
+            STRING,
+            POINTER
+        };
+
+        std::uint32_t registerBinaryFormat(LogLevel level, const SourceLocation &location, std::string_view format,
+                                           std::size_t argumentCount);
+        // Reserves a record on the calling thread's binary buffer and returns where payloadSize argument bytes
+        // go, or nullptr when the record is dropped. A non-null result must be followed by endBinaryRecord().
+        char *beginBinaryRecord(std::uint32_t formatId, std::size_t payloadSize);
+        void endBinaryRecord();
+
+        template <typename T>
+        std::size_t binarySize(const T &value)
+        {
+            if constexpr (std::is_same_v<T, bool> || std::is_same_v<T, char>)
+                return 1 + sizeof(char);
+            else if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T> || std::is_null_pointer_v<T>)
+                return 1 + sizeof(std::uint64_t);
+            else if constexpr (std::is_convertible_v<const T &, const char *>)
+            {
+                const char *text = value;
+                return 1 + sizeof(std::uint32_t) + (text ? std::strlen(text) : 0);
+            }
+            else if constexpr (std::is_convertible_v<const T &, std::string_view>)
+                return 1 + sizeof(std::uint32_t) + std::string_view(value).size();
+            else
+            {
+                static_assert(std::is_pointer_v<T>,
+                              "logcoe: binary logging supports arithmetic, string and pointer arguments");
+                return 1 + sizeof(std::uint64_t);
+            }
+        }
+
+        template <typename Value>
+        void encodeBinaryValue(char *&cursor, BinaryTag tag, const Value &value)
+        {
+            *cursor++ = static_cast<char>(tag);
+            std::memcpy(cursor, &value, sizeof(Value));
+            cursor += sizeof(Value);
+        }
+
+        inline void encodeBinaryString(char *&cursor, std::string_view text)
+        {
+            *cursor++ = static_cast<char>(BinaryTag::STRING);
+            auto length = static_cast<std::uint32_t>(text.size());
+            std::memcpy(cursor, &length, sizeof(length));
+            cursor += sizeof(length);
+            std::memcpy(cursor, text.data(), text.size());
+            cursor += text.size();
+        }
+
+        template <typename T>
+        void encodeBinary(char *&cursor, const T &value)
+        {
+            if constexpr (std::is_same_v<T, bool>)
+                encodeBinaryValue(cursor, BinaryTag::BOOL, static_cast<char>(value));
+            else if constexpr (std::is_same_v<T, char>)
+                encodeBinaryValue(cursor, BinaryTag::CHAR, value);
+            else if constexpr (std::is_enum_v<T>)
+                encodeBinary(cursor, static_cast<std::underlying_type_t<T>>(value));
+            else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+                encodeBinaryValue(cursor, BinaryTag::INT, static_cast<std::int64_t>(value));
+            else if constexpr (std::is_integral_v<T>)
+                encodeBinaryValue(cursor, BinaryTag::UINT, static_cast<std::uint64_t>(value));
+            else if constexpr (std::is_floating_point_v<T>)
+                encodeBinaryValue(cursor, BinaryTag::DOUBLE, static_cast<double>(value));
+            else if constexpr (std::is_convertible_v<const T &, const char *>)
+            {
+                const char *text = value;
+                encodeBinaryString(cursor, text ? std::string_view(text) : std::string_view());
+            }
+            else if constexpr (std::is_convertible_v<const T &, std::string_view>)
+                encodeBinaryString(cursor, std::string_view(value));
+            else
+                encodeBinaryValue(cursor, BinaryTag::POINTER,
+                                  static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(value)));
+        }
+
+        // Values the binary log cannot hold are formatted now and kept as their text
+        template <typename T>
+        void encodeArgument(std::string &out, const void *value)
+        {
+            const T &argument = *static_cast<const T *>(value);
+            if constexpr (!std::is_null_pointer_v<T> &&
+                          (std::is_arithmetic_v<T> || std::is_enum_v<T> || std::is_pointer_v<T> ||
+                           std::is_convertible_v<const T &, const char *> ||
+                           std::is_convertible_v<const T &, std::string_view>))
+            {
+                // binarySize() is an upper bound for enums of char
+                std::size_t start = out.size();
+                out.resize(start + binarySize(argument));
+                char *cursor = &out[start];
+                encodeBinary(cursor, argument);
+                out.resize(static_cast<std::size_t>(cursor - out.data()));
+            }
+            else
+            {
+                out += static_cast<char>(BinaryTag::STRING);
+                std::size_t lengthAt = out.size();
+                out.append(sizeof(std::uint32_t), '\0');
+                appendFormatted(out, argument);
+                auto length = static_cast<std::uint32_t>(out.size() - lengthAt - sizeof(std::uint32_t));
+                std::memcpy(&out[lengthAt], &length, sizeof(length));
+            }
+        }
+
+        template <std::size_t Placeholders, typename... Args>
+        void logBinary(std::uint32_t formatId, std::string_view, const Args &...args)
+        {
+            static_assert(Placeholders == sizeof...(Args),
+                          "logcoe: format string placeholder count does not match the number of arguments");
+            char *cursor = beginBinaryRecord(formatId, (std::size_t{0} + ... + binarySize(args)));
+            if (!cursor)
+                return;
+            (encodeBinary(cursor, args), ...);
+            endBinaryRecord();
+        }
+    } // namespace detail
+
+    inline bool isEnabled(LogLevel level)
+    {
+        return static_cast<int>(level) >= static_cast<int>(detail::activeLevel.load(std::memory_order_relaxed));
+    }
+
+    namespace detail
+    {
+        template <LogLevel Level>
+        struct LevelLogger
+        {
+            // std::string, string_view and string literals alike, nothing is copied before the level check
+            void operator()(std::string_view message, std::string_view source = {}, bool flush = true) const
+            {
+                if (isEnabled(Level))
+                    log(Level, message, source, flush);
+            }
+
+            // preferred for literals and char buffers, the length is only taken when Level passes, nullptr logs ""
+            void operator()(const char *message, std::string_view source = {}, bool flush = true) const
+            {
+                if (isEnabled(Level))
+                    log(Level, message ? std::string_view(message) : std::string_view(), source, flush);
+            }
+
+            // the producer only runs when Level passes the filter, e.g. debug([&] { return dump(state); })
+            template <typename MessageProducer,
+                      typename = std::enable_if_t<std::is_invocable_r_v<std::string, MessageProducer &>>>
+            void operator()(MessageProducer &&producer, std::string_view source = {}, bool flush = true) const
+            {
+                if (isEnabled(Level))
+                    log(Level, producer(), source, flush);
+            }
+
+            // info("user={} latency={}us", id, us): formatted into a thread-local buffer, no iostreams for
+            // common types. Arguments that look like (source[, flush]) keep the message/source meaning above, so
+            // info("user={}", name) with a string name logs "user={}" from source name, with a one-time warning:
+            // use infof() instead. A placeholder count that does not match the arguments is warned about once too.
+            template <typename... Args,
+                      typename = std::enable_if_t<(sizeof...(Args) > 0) && !IsSourceAndFlush<Args...>::value>>
+            void operator()(std::string_view format, const Args &...args) const
+            {
+                if (isEnabled(Level))
+                    logFormat(Level, nullptr, format, args...);
+            }
+
+            template <std::size_t Placeholders, typename... Args>
+            void operator()(const CheckedFormat<Placeholders> &format, const Args &...args) const
+            {
+                static_assert(Placeholders == sizeof...(Args),
+                              "logcoe: format string placeholder count does not match the number of arguments");
+                if (isEnabled(Level))
+                    logFormat(Level, nullptr, format.format, args...);
+            }
+
+            // info("request done", {{"status", 200}, {"ms", 3.2}}): encoded straight into the line
+            void operator()(std::string_view message, std::initializer_list<Field> fields,
+                            std::string_view source = {}, bool flush = true) const
+            {
+                if (isEnabled(Level))
+                    logFields(Level, message, fields.begin(), fields.size(), source, flush);
+            }
+
+            void operator()(const char *message, std::initializer_list<Field> fields, std::string_view source = {},
+                            bool flush = true) const
+            {
+                if (isEnabled(Level))
+                    logFields(Level, message ? std::string_view(message) : std::string_view(), fields.begin(),
+                              fields.size(), source, flush);
+            }
+
+            // info(network, "connected"): filtered by the source's own level
+            void operator()(const Source &source, std::string_view message, bool flush = true) const
+            {
+                if (source.isEnabled(Level))
+                    logSource(Level, source.state(), message, flush);
+            }
+
+            void operator()(const Source &source, std::string_view message, std::initializer_list<Field> fields,
+                            bool flush = true) const
+            {
+                if (source.isEnabled(Level))
+                    logSource(Level, source.state(), message, flush, fields.begin(), fields.size());
+            }
+
+            template <typename... Args, typename = std::enable_if_t<(sizeof...(Args) > 0) &&
+                                                                    !std::is_same_v<std::tuple<Args...>, std::tuple<bool>>>>
+            void operator()(const Source &source, std::string_view format, const Args &...args) const
+            {
+                if (source.isEnabled(Level))
+                    logSourceFormat(Level, source.state(), format, args...);
+            }
+
+            template <std::size_t Placeholders, typename... Args>
+            void operator()(const Source &source, const CheckedFormat<Placeholders> &format, const Args &...args) const
+            {
+                static_assert(Placeholders == sizeof...(Args),
+                              "logcoe: format string placeholder count does not match the number of arguments");
+                if (source.isEnabled(Level))
+                    logSourceFormat(Level, source.state(), format.format, args...);
+            }
+        };
+
+        // infof("user={}", name): the first argument is always a format string and the rest its arguments, a
+        // string argument is never taken for a source
+        template <LogLevel Level>
+        struct FormatLogger
+        {
+            template <typename... Args>
+            void operator()(std::string_view format, const Args &...args) const
+            {
+                if (isEnabled(Level))
+                    logFormat(Level, nullptr, format, args...);
+            }
+
+            template <std::size_t Placeholders, typename... Args>
+            void operator()(const CheckedFormat<Placeholders> &format, const Args &...args) const
+            {
+                static_assert(Placeholders == sizeof...(Args),
+                              "logcoe: format string placeholder count does not match the number of arguments");
+                if (isEnabled(Level))
+                    logFormat(Level, nullptr, format.format, args...);
+            }
+
+            template <typename... Args>
+            void operator()(const Source &source, std::string_view format, const Args &...args) const
+            {
+                if (source.isEnabled(Level))
+                    logSourceFormat(Level, source.state(), format, args...);
+            }
+
+            template <std::size_t Placeholders, typename... Args>
+            void operator()(const Source &source, const CheckedFormat<Placeholders> &format, const Args &...args) const
+            {
+                static_assert(Placeholders == sizeof...(Args),
+                              "logcoe: format string placeholder count does not match the number of arguments");
+                if (source.isEnabled(Level))
+                    logSourceFormat(Level, source.state(), format.format, args...);
+            }
+        };
+
+        template <typename T>
+        void appendStreamed(std::string &out, const T &value)
+        {
+            std::ostringstream stream;
+            stream << value;
+            out += stream.str();
+        }
+
+        std::string &streamBuffer();
+        void logStream(LogLevel level, const SourceLocation &location, std::size_t start);
+
+        // Built by LOGCOE_STREAM, appends every value to the thread's stream buffer with the "{}" rules and logs
+        // the line when the statement ends. A stream opened while another one is building (a value whose
+        // formatting logs) takes the rest of the buffer and leaves it as it found it.
+        class LogStream
+        {
+        public:
+            LogStream(LogLevel level, const SourceLocation &location)
+                : m_level(level), m_location(location), m_buffer(streamBuffer()), m_start(m_buffer.size()) {}
+
+            ~LogStream() { logStream(m_level, m_location, m_start); }
+
+            LogStream(const LogStream &) = delete;
+            LogStream &operator=(const LogStream &) = delete;
+
+            template <typename T>
+            LogStream &operator<<(const T &value)
+            {
+                appendFormatted(m_buffer, value);
+                return *this;
+            }
+
+        private:
+            LogLevel m_level;
+            const SourceLocation &m_location;
+            std::string &m_buffer;
+            std::size_t m_start;
+        };
+    } // namespace detail
+
+    inline constexpr detail::LevelLogger<LogLevel::DEBUG> debug{};
+    inline constexpr detail::LevelLogger<LogLevel::INFO> info{};
+    inline constexpr detail::LevelLogger<LogLevel::WARNING> warning{};
+    inline constexpr detail::LevelLogger<LogLevel::ERROR> error{};
+
+    inline constexpr detail::FormatLogger<LogLevel::DEBUG> debugf{};
+    inline constexpr detail::FormatLogger<LogLevel::INFO> infof{};
+    inline constexpr detail::FormatLogger<LogLevel::WARNING> warningf{};
+    inline constexpr detail::FormatLogger<LogLevel::ERROR> errorf{};
+
+    // Formats into a new string with the same rules as the logging calls
+    template <typename... Args>
+    std::string format(std::string_view pattern, const Args &...args)
+    {
+        std::string out;
+        if constexpr (sizeof...(Args) == 0)
+            detail::formatTo(out, pattern, nullptr, 0);
+        else
+        {
+            const detail::FormatArgument arguments[] = {detail::makeFormatArgument(args)...};
+            detail::formatTo(out, pattern, arguments, sizeof...(Args));
+        }
+        return out;
+    }
+
+} // namespace logcoe
+
+// Checks the placeholder count of a string literal against the arguments at compile time:
+// logcoe::info(LOGCOE_FMT("user={} latency={}us"), id, us)
+#define LOGCOE_FMT(literal) \
+    (::logcoe::detail::CheckedFormat<::logcoe::detail::countPlaceholders(literal)>{literal})
+
+// The call site is captured in a static constexpr SourceLocation and printed as the record's source.
+// Arguments are evaluated only when the level is enabled at runtime.
+#define LOGCOE_LOG_AT(level, ...)                                                                         \
+    do                                                                                                    \
+    {                                                                                                     \
+        if (::logcoe::isEnabled(level))                                                                   \
+        {                                                                                                 \
+            static constexpr ::logcoe::SourceLocation logcoeLocation{                                     \
+                ::logcoe::detail::fileName(__FILE__), __LINE__, __func__};                                \
+            ::logcoe::detail::logAt(level, logcoeLocation, __VA_ARGS__);                                  \
+        }                                                                                                 \
+    } while (false)
+
+// The limiter is a static of the call site, sampling and rate decisions happen before any argument is formatted:
+// LOGCOE_ERROR_LIMITED(logcoe::LogLimit::rate(10, 20), "upstream {} unavailable", host)
+#define LOGCOE_LIMITED_AT(level, limit, ...)                                                              \
+    do                                                                                                    \
+    {                                                                                                     \
+        if (::logcoe::isEnabled(level))                                                                   \
+        {                                                                                                 \
+            static constexpr ::logcoe::SourceLocation logcoeLocation{                                     \
+                ::logcoe::detail::fileName(__FILE__), __LINE__, __func__};                                \
+            static ::logcoe::LogLimiter logcoeLimiter(limit);                                             \
+            if (logcoeLimiter.allow())                                                                    \
+                ::logcoe::detail::logLimitedAt(level, logcoeLocation, logcoeLimiter, __VA_ARGS__);        \
+        }                                                                                                 \
+    } while (false)
+
+// Stream-style record without a format string: LOGCOE_STREAM(INFO) << "user " << id << " took " << ms << "ms";
+// Nothing right of the macro is evaluated unless the level is enabled, levels below LOGCOE_ACTIVE_LEVEL are a
+// constant false. Values are formatted like "{}" arguments, so stream manipulators are not supported.
+#define LOGCOE_STREAM(level)                                                                              \
+    if (static constexpr ::logcoe::SourceLocation logcoeLocation{                                         \
+            ::logcoe::detail::fileName(__FILE__), __LINE__, __func__};                                    \
+        !(LOGCOE_LEVEL_##level >= LOGCOE_ACTIVE_LEVEL && ::logcoe::isEnabled(::logcoe::LogLevel::level))) \
+    {                                                                                                     \
+    }                                                                                                     \
+    else                                                                                                  \
+        ::logcoe::detail::LogStream(::logcoe::LogLevel::level, logcoeLocation)
+
+#define LOGCOE_EXPAND(x) x
+#define LOGCOE_FIRST_ARG_(first, ...) first
+#define LOGCOE_FIRST_ARG(...) LOGCOE_EXPAND(LOGCOE_FIRST_ARG_(__VA_ARGS__, unused))
+
+// Deferred binary logging: the format string literal is registered once per call site, every call then only
+// copies the format id, a timestamp and the raw argument bytes. Formatting happens on a background thread
+// or offline with logcoe-decode.
+#define LOGCOE_BINARY_AT(level, ...)                                                                      \
+    do                                                                                                    \
+    {                                                                                                     \
+        if (static_cast<int>(level) >=                                                                    \
+            static_cast<int>(::logcoe::detail::outputLevel.load(std::memory_order_relaxed)))              \
+        {                                                                                                 \
+            static constexpr ::logcoe::SourceLocation logcoeLocation{                                     \
+                ::logcoe::detail::fileName(__FILE__), __LINE__, __func__};                                \
+            static constexpr std::size_t logcoePlaceholders =                                             \
+                ::logcoe::detail::countPlaceholders(LOGCOE_FIRST_ARG(__VA_ARGS__));                       \
+            static const std::uint32_t logcoeFormatId = ::logcoe::detail::registerBinaryFormat(           \
+                level, logcoeLocation, LOGCOE_FIRST_ARG(__VA_ARGS__), logcoePlaceholders);                \
+            ::logcoe::detail::logBinary<logcoePlaceholders>(logcoeFormatId, __VA_ARGS__);                 \
+        }                                                                                                 \
+    } while (false)
+
+// Levels below LOGCOE_ACTIVE_LEVEL expand to nothing, so neither the call nor its arguments are compiled in
+#if LOGCOE_ACTIVE_LEVEL <= LOGCOE_LEVEL_DEBUG
+#define LOGCOE_DEBUG(...) LOGCOE_LOG_AT(::logcoe::LogLevel::DEBUG, __VA_ARGS__)
+#else
+#define LOGCOE_DEBUG(...) static_cast<void>(0)
+#endif
+
+#if LOGCOE_ACTIVE_LEVEL <= LOGCOE_LEVEL_INFO
+#define LOGCOE_INFO(...) LOGCOE_LOG_AT(::logcoe::LogLevel::INFO, __VA_ARGS__)
+#else
+#define LOGCOE_INFO(...) static_cast<void>(0)
+#endif
+
+#if LOGCOE_ACTIVE_LEVEL <= LOGCOE_LEVEL_WARNING
+#define LOGCOE_WARNING(...) LOGCOE_LOG_AT(::logcoe::LogLevel::WARNING, __VA_ARGS__)
+#else
+#define LOGCOE_WARNING(...) static_cast<void>(0)
+#endif
+
+#if LOGCOE_ACTIVE_LEVEL <= LOGCOE_LEVEL_ERROR
+#define LOGCOE_ERROR(...) LOGCOE_LOG_AT(::logcoe::LogLevel::ERROR, __VA_ARGS__)
+#else
+#define LOGCOE_ERROR(...) static_cast<void>(0)
+#endif
+
+#if LOGCOE_ACTIVE_LEVEL <= LOGCOE_LEVEL_DEBUG
+#define LOGCOE_DEBUG_LIMITED(limit, ...) LOGCOE_LIMITED_AT(::logcoe::LogLevel::DEBUG, limit, __VA_ARGS__)
+#else
+#define LOGCOE_DEBUG_LIMITED(limit, ...) static_cast<void>(0)
+#endif
+
+#if LOGCOE_ACTIVE_LEVEL <= LOGCOE_LEVEL_INFO
+#define LOGCOE_INFO_LIMITED(limit, ...) LOGCOE_LIMITED_AT(::logcoe::LogLevel::INFO, limit, __VA_ARGS__)
+#else
+#define LOGCOE_INFO_LIMITED(limit, ...) static_cast<void>(0)
+#endif
+
+#if LOGCOE_ACTIVE_LEVEL <= LOGCOE_LEVEL_WARNING
+#define LOGCOE_WARNING_LIMITED(limit, ...) LOGCOE_LIMITED_AT(::logcoe::LogLevel::WARNING, limit, __VA_ARGS__)
+#else
+#define LOGCOE_WARNING_LIMITED(limit, ...) static_cast<void>(0)
+#endif
+
+#if LOGCOE_ACTIVE_LEVEL <= LOGCOE_LEVEL_ERROR
+#define LOGCOE_ERROR_LIMITED(limit, ...) LOGCOE_LIMITED_AT(::logcoe::LogLevel::ERROR, limit, __VA_ARGS__)
+#else
+#define LOGCOE_ERROR_LIMITED(limit, ...) static_cast<void>(0)
+#endif
+
+#if LOGCOE_ACTIVE_LEVEL <= LOGCOE_LEVEL_DEBUG
+#define LOGCOE_BINARY_DEBUG(...) LOGCOE_BINARY_AT(::logcoe::LogLevel::DEBUG, __VA_ARGS__)
+#else
+#define LOGCOE_BINARY_DEBUG(...) static_cast<void>(0)
+#endif
+
+#if LOGCOE_ACTIVE_LEVEL <= LOGCOE_LEVEL_INFO
+#define LOGCOE_BINARY_INFO(...) LOGCOE_BINARY_AT(::logcoe::LogLevel::INFO, __VA_ARGS__)
+#else
+#define LOGCOE_BINARY_INFO(...) static_cast<void>(0)
+#endif
+
+#if LOGCOE_ACTIVE_LEVEL <= LOGCOE_LEVEL_WARNING
+#define LOGCOE_BINARY_WARNING(...) LOGCOE_BINARY_AT(::logcoe::LogLevel::WARNING, __VA_ARGS__)
+#else
+#define LOGCOE_BINARY_WARNING(...) static_cast<void>(0)
+#endif
+
+#if LOGCOE_ACTIVE_LEVEL <= LOGCOE_LEVEL_ERROR
+#define LOGCOE_BINARY_ERROR(...) LOGCOE_BINARY_AT(::logcoe::LogLevel::ERROR, __VA_ARGS__)
+#else
+#define LOGCOE_BINARY_ERROR(...) static_cast<void>(0)
+#endif
@@ -1,96 +1,318 @@
 #include <logcoe.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
 #include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iterator>
 #include <exception>
 #include <sstream>
+#include <memory>
 #include <mutex>
+#include <new>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include <iostream>
 #include <fstream>
 #include <filesystem>
 
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LOGCOE_HAS_SSE2
+#endif
+
+#ifdef LOGCOE_HAS_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef LOGCOE_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+// raw system calls on the kernel's own header, IORING_FEAT_RW_CUR_POS marks the 5.6 header with IORING_OP_WRITE
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(IORING_FEAT_RW_CUR_POS)
+#define LOGCOE_HAS_IO_URING
+#endif
+#endif
+#endif
+
+using logcoe::AsyncOptions;
+using logcoe::Compression;
+using logcoe::Field;
+using logcoe::FlushPolicy;
 using logcoe::LogLevel;
+using logcoe::OutputFormat;
+using logcoe::OverflowPolicy;
+using logcoe::RotationOptions;
+using logcoe::SourceLocation;
+using logcoe::detail::SourceState;
+using logcoe::TimePrecision;
 
 namespace
 {
-    class LoggerImpl
+    struct LogRecord
     {
-        static unsigned int s_initCounter;
-        static LogLevel s_logLevel;
-        static std::string s_defaultSource;
-        static std::mutex s_mutex;
-        static std::string s_filename;
-        static std::ofstream s_fileStream;
-        static std::ostream *s_consoleStream;
-        static bool s_useFile;
-        static bool s_useConsole;
-        static std::string s_timeFormat;
+        LogLevel level = LogLevel::INFO;
+        std::chrono::system_clock::time_point time;
+        std::string source;
+        std::string message;
+        bool flush = true;
+        const SourceLocation *location = nullptr;
+        std::string fields; // already encoded for the output format, see appendFields()
+        const SourceState *interned = nullptr;
+        std::uint32_t thread = 0; // threadNumber() of the producer, for the %t layout item
+        bool dump = false;        // the writer thread dumps the flight recorder before this record
 
-        static std::string getCurrentTimestamp();
-        static std::string getLogLevelAsString(LogLevel level);
-        static void writeToOutputs(const std::string &formattedMessage,
-                                   LogLevel level = LogLevel::INFO,
-                                   bool flush = true);
-        static void log(LogLevel level, const std::string &message, const std::string &source, bool flush);
+        // Records are recycled rather than freed, storage reserved up front covers typical lines from the start
+        void reserve()
+        {
+            message.reserve(128);
+            fields.reserve(64);
+        }
+    };
+
+    // Bounded ring of log records (Dmitry Vyukov's sequence-numbered array queue).
+    // The writer thread is the only regular consumer, producers only pop to evict
+    // the oldest record under OverflowPolicy::DROP_OLDEST.
+    // Records are swapped in and out rather than moved, so the strings of consumed records travel back to the
+    // producers with their capacity and a warmed-up queue allocates nothing.
+    class RecordQueue
+    {
+        struct Cell
+        {
+            std::atomic<std::size_t> sequence{0};
+            LogRecord record;
+        };
+
+        std::unique_ptr<Cell[]> m_cells;
+        std::size_t m_mask;
+        alignas(64) std::atomic<std::size_t> m_enqueuePos{0};
+        alignas(64) std::atomic<std::size_t> m_dequeuePos{0};
 
     public:
-        static void initialize(LogLevel level = LogLevel::INFO,
-                               const std::string &defaultSource = "",
-                               bool enableConsole = true,
-                               bool enableFile = false,
-                               const std::string &filename = "logcoe.log");
-        static void shutdown();
+        // requested capacities are rounded up to a power of two
+        static std::size_t sizeFor(std::size_t capacity)
+        {
+            std::size_t size = 2;
+            while (size < capacity)
+                size <<= 1;
+            return size;
+        }
 
-        static void setLogLevel(LogLevel level);
-        static void setConsoleOutput(std::ostream &stream);
-        static bool setFileOutput(const std::string &filename);
-        static void disableConsoleOutput();
-        static void disableFileOutput();
-        static void setTimeFormat(const std::string &format);
+        explicit RecordQueue(std::size_t capacity)
+        {
+            std::size_t size = sizeFor(capacity);
+            m_cells.reset(new Cell[size]);
+            m_mask = size - 1;
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                m_cells[i].sequence.store(i, std::memory_order_relaxed);
+                m_cells[i].record.reserve();
+            }
+        }
 
-        static bool isInitialized();
-        static LogLevel getLogLevel();
+        std::size_t capacity() const { return m_mask + 1; }
 
-        static void debug(const std::string &message, const std::string &source = "", bool flush = true);
-        static void info(const std::string &message, const std::string &source = "", bool flush = true);
-        static void warning(const std::string &message, const std::string &source = "", bool flush = true);
-        static void error(const std::string &message, const std::string &source = "", bool flush = true);
-        static void flush();
-    };
+        bool tryPush(LogRecord &record)
+        {
+            Cell *cell;
+            std::size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                cell = &m_cells[pos & m_mask];
+                std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+                if (diff == 0)
+                {
+                    if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                    return false;
+                else
+                    pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
 
-    unsigned int LoggerImpl::s_initCounter = 0;
-    LogLevel LoggerImpl::s_logLevel = LogLevel::INFO;
-    std::string LoggerImpl::s_defaultSource = "";
-    std::mutex LoggerImpl::s_mutex;
-    std::string LoggerImpl::s_filename = "logcoe.log";
-    std::ofstream LoggerImpl::s_fileStream;
-    std::ostream *LoggerImpl::s_consoleStream = &std::cout;
-    bool LoggerImpl::s_useFile = false;
-    bool LoggerImpl::s_useConsole = true;
-    std::string LoggerImpl::s_timeFormat = "%d/%m/%Y__%H:%M:%S";
+            std::swap(cell->record, record);
+            cell->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
 
-    std::string LoggerImpl::getCurrentTimestamp()
-    {
-        if(s_initCounter == 0) return "";
+        bool tryPop(LogRecord &record)
+        {
+            Cell *cell;
+            std::size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                cell = &m_cells[pos & m_mask];
+                std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+                if (diff == 0)
+                {
+                    if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                    return false;
+                else
+                    pos = m_dequeuePos.load(std::memory_order_relaxed);
+            }
+
+            std::swap(record, cell->record);
+            cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool empty() const
+        {
+            std::size_t pos = m_dequeuePos.load(std::memory_order_acquire);
+            return m_cells[pos & m_mask].sequence.load(std::memory_order_acquire) != pos + 1;
+        }
+    };
 
-        auto now = std::chrono::system_clock::now();
-        std::time_t time_t_now = std::chrono::system_clock::to_time_t(now);
+    // Formats timestamps with a strftime pattern plus an optional sub-second fraction.
+    // The strftime part only changes once per second, so it is cached and rebuilt when the second changes,
+    // which keeps localtime_r (and its timezone lock) off the per-message path.
+    class TimestampFormatter
+    {
+        std::string m_format;
+        TimePrecision m_precision = TimePrecision::SECONDS;
+        std::time_t m_cachedSecond = 0;
+        bool m_cacheValid = false;
+        std::string m_cachedPrefix;
 
-        std::tm tm_now;
+        static std::tm toLocalTime(std::time_t time)
+        {
+            std::tm tm_now;
 #ifdef _WIN32
-        localtime_s(&tm_now, &time_t_now);
+            localtime_s(&tm_now, &time);
 #else
-        localtime_r(&time_t_now, &tm_now);
+            localtime_r(&time, &tm_now);
 #endif
+            return tm_now;
+        }
+
+        static std::size_t fractionDigits(TimePrecision precision)
+        {
+            switch (precision)
+            {
+            case TimePrecision::MILLISECONDS:
+                return 3;
+            case TimePrecision::MICROSECONDS:
+                return 6;
+            case TimePrecision::NANOSECONDS:
+                return 9;
+            default:
+                return 0;
+            }
+        }
 
-        char buffer[256];
-        std::strftime(buffer, sizeof(buffer), s_timeFormat.c_str(), &tm_now);
+    public:
+        explicit TimestampFormatter(std::string format) : m_format(std::move(format)) {}
 
-        return std::string(buffer);
-    }
+        const std::string &pattern() const { return m_format; }
+        TimePrecision precision() const { return m_precision; }
 
-    std::string LoggerImpl::getLogLevelAsString(LogLevel level)
-    {
-        if(s_initCounter == 0) return "";
+        void setFormat(const std::string &format, TimePrecision precision)
+        {
+            m_format = format;
+            m_precision = precision;
+            m_cacheValid = false;
+        }
+
+        static std::string formatUncached(std::chrono::system_clock::time_point time, const std::string &format)
+        {
+            std::tm tm_now = toLocalTime(std::chrono::system_clock::to_time_t(time));
+
+            char buffer[256];
+            std::size_t length = std::strftime(buffer, sizeof(buffer), format.c_str(), &tm_now);
+
+            return std::string(buffer, length);
+        }
+
+        void append(std::string &out, std::chrono::system_clock::time_point time)
+        {
+            auto sinceEpoch = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch());
+            auto seconds = std::chrono::duration_cast<std::chrono::seconds>(sinceEpoch);
+            auto nanoseconds = sinceEpoch - seconds;
+            if (nanoseconds.count() < 0)
+            {
+                seconds -= std::chrono::seconds(1);
+                nanoseconds += std::chrono::seconds(1);
+            }
+
+            std::time_t second = static_cast<std::time_t>(seconds.count());
+            if (!m_cacheValid || second != m_cachedSecond)
+            {
+                // assigned into the cached string, so a new second reuses its capacity instead of allocating
+                std::tm tm_now = toLocalTime(second);
+                char buffer[256];
+                m_cachedPrefix.assign(buffer, std::strftime(buffer, sizeof(buffer), m_format.c_str(), &tm_now));
+                m_cachedSecond = second;
+                m_cacheValid = true;
+            }
+            out += m_cachedPrefix;
+
+            std::size_t digits = fractionDigits(m_precision);
+            if (digits == 0)
+                return;
+
+            auto fraction = static_cast<std::uint64_t>(nanoseconds.count());
+            for (std::size_t i = digits; i < 9; ++i)
+                fraction /= 10;
+
+            char buffer[10];
+            buffer[0] = '.';
+            for (std::size_t i = digits; i > 0; --i)
+            {
+                buffer[i] = static_cast<char>('0' + fraction % 10);
+                fraction /= 10;
+            }
+            out.append(buffer, digits + 1);
+        }
+
+        std::string format(std::chrono::system_clock::time_point time)
+        {
+            std::string timestamp;
+            append(timestamp, time);
+            return timestamp;
+        }
+    };
 
+    const char *levelName(LogLevel level)
+    {
         switch (level)
         {
         case LogLevel::DEBUG:
@@ -106,257 +328,5335 @@ namespace
         }
     }
 
-    void LoggerImpl::writeToOutputs(const std::string &formattedMessage, LogLevel level, bool flush)
+    bool needsJsonEscape(unsigned char c) { return c < 0x20 || c == '"' || c == '\\'; }
+
+    // Bytes before the first character JSON needs escaped, 16 at a time where SSE2 is available
+    std::size_t plainJsonPrefix(const char *text, std::size_t size)
+    {
+        std::size_t i = 0;
+#ifdef LOGCOE_HAS_SSE2
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i control = _mm_set1_epi8(0x1F);
+        for (; i + 16 <= size; i += 16)
+        {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i));
+            // max(c, 0x1F) == 0x1F is an unsigned c <= 0x1F
+            __m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash)),
+                                           _mm_cmpeq_epi8(_mm_max_epu8(block, control), control));
+            int mask = _mm_movemask_epi8(special);
+            if (mask != 0)
+            {
+                while ((mask & 1) == 0)
+                {
+                    mask >>= 1;
+                    ++i;
+                }
+                return i;
+            }
+        }
+#endif
+        while (i < size && !needsJsonEscape(static_cast<unsigned char>(text[i])))
+            ++i;
+        return i;
+    }
+
+    // Contents of a JSON string, without the quotes
+    void appendJsonEscaped(std::string &out, std::string_view text)
+    {
+        while (!text.empty())
+        {
+            std::size_t plain = plainJsonPrefix(text.data(), text.size());
+            out.append(text.data(), plain);
+            if (plain == text.size())
+                return;
+
+            char c = text[plain];
+            switch (c)
+            {
+            case '"':
+                out += "\\\"";
+                break;
+            case '\\':
+                out += "\\\\";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            case '\r':
+                out += "\\r";
+                break;
+            case '\t':
+                out += "\\t";
+                break;
+            default:
+            {
+                static constexpr char hex[] = "0123456789abcdef";
+                char escaped[6] = {'\\', 'u', '0', '0', hex[(c >> 4) & 0xF], hex[c & 0xF]};
+                out.append(escaped, sizeof(escaped));
+                break;
+            }
+            }
+            text.remove_prefix(plain + 1);
+        }
+    }
+
+    void appendJsonString(std::string &out, std::string_view text)
+    {
+        out += '"';
+        appendJsonEscaped(out, text);
+        out += '"';
+    }
+
+    // logfmt values are bare unless they are empty or hold spaces, '=', quotes or control characters
+    bool isBareLogfmtValue(std::string_view text)
+    {
+        for (char c : text)
+        {
+            auto byte = static_cast<unsigned char>(c);
+            if (byte <= ' ' || byte == '=' || byte == '"' || byte == '\\')
+                return false;
+        }
+        return !text.empty();
+    }
+
+    void appendLogfmtValue(std::string &out, std::string_view text)
+    {
+        if (isBareLogfmtValue(text))
+            out.append(text.data(), text.size());
+        else
+            appendJsonString(out, text);
+    }
+
+    // " key=value ..." for TEXT and LOGFMT, ",\"key\":value ..." for JSON, appended inside the open line
+    void appendFields(std::string &out, OutputFormat format, const Field *fields, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const Field &field = fields[i];
+            if (format == OutputFormat::JSON)
+            {
+                out += ',';
+                appendJsonString(out, field.key);
+                out += ':';
+            }
+            else
+            {
+                out += ' ';
+                out.append(field.key.data(), field.key.size());
+                out += '=';
+            }
+
+            switch (field.type)
+            {
+            case Field::Type::BOOL:
+                out += field.boolean ? "true" : "false";
+                break;
+            case Field::Type::INT:
+                logcoe::detail::appendValue(out, field.integer);
+                break;
+            case Field::Type::UINT:
+                logcoe::detail::appendValue(out, field.unsignedInteger);
+                break;
+            case Field::Type::DOUBLE:
+                // JSON has no literal for infinities and NaN
+                if (format == OutputFormat::JSON && !std::isfinite(field.number))
+                    out += "null";
+                else
+                    logcoe::detail::appendValue(out, field.number);
+                break;
+            default:
+                if (format == OutputFormat::JSON)
+                    appendJsonString(out, field.text);
+                else
+                    appendLogfmtValue(out, field.text);
+                break;
+            }
+        }
+    }
+
+    void appendSource(std::string &out, std::string_view source, const SourceLocation *location,
+                      const SourceState *interned)
+    {
+        if (interned)
+        {
+            out += interned->name;
+            return;
+        }
+        if (!location)
+        {
+            out += source;
+            return;
+        }
+
+        char lineNumber[16];
+        auto result = std::to_chars(lineNumber, lineNumber + sizeof(lineNumber), location->line);
+        out += location->file;
+        out += ':';
+        out.append(lineNumber, result.ptr);
+    }
+
+    // Small per-process number of the calling thread, taken on its first log call
+    std::uint32_t threadNumber()
+    {
+        static std::atomic<std::uint32_t> next{1};
+        thread_local std::uint32_t number = next.fetch_add(1, std::memory_order_relaxed);
+        return number;
+    }
+
+    // A setLayout() pattern compiled into a flat list of operations, adjacent literal text joined into one.
+    // Rendering runs the list into the caller's line buffer, only %n touches shared state.
+    class Layout
+    {
+        enum class Item : std::uint8_t
+        {
+            TEXT,
+            TIME,
+            LEVEL,
+            SOURCE,
+            THREAD,
+            SEQUENCE,
+            MESSAGE
+        };
+
+        struct Operation
+        {
+            Item item = Item::TEXT;
+            bool leftAlign = false;
+            std::uint16_t width = 0;
+            std::string text;
+        };
+
+        std::vector<Operation> m_operations;
+        std::string m_pattern;
+        mutable std::atomic<std::uint64_t> m_sequence{0}; // lines rendered so far, for %n
+
+        static void pad(std::string &line, std::size_t start, const Operation &operation)
+        {
+            std::size_t length = line.size() - start;
+            if (length >= operation.width)
+                return;
+            if (operation.leftAlign)
+                line.append(operation.width - length, ' ');
+            else
+                line.insert(start, operation.width - length, ' ');
+        }
+
+        static void appendNumber(std::string &line, std::uint64_t value)
+        {
+            char digits[24];
+            auto result = std::to_chars(digits, digits + sizeof(digits), value);
+            line.append(digits, result.ptr);
+        }
+
+    public:
+        const std::string &pattern() const { return m_pattern; }
+
+        // %d time (setTimeFormat), %L level, %S source, %t thread number, %n line number, %m message, %% a '%'.
+        // A width between '%' and the letter pads the value, '-' aligns it left: "%-7L".
+        static std::shared_ptr<const Layout> compile(std::string_view pattern, std::string &error)
+        {
+            auto layout = std::make_shared<Layout>();
+            layout->m_pattern.assign(pattern.data(), pattern.size());
+
+            auto appendText = [&layout](std::string_view text)
+            {
+                if (layout->m_operations.empty() || layout->m_operations.back().item != Item::TEXT)
+                {
+                    Operation literal;
+                    literal.item = Item::TEXT;
+                    layout->m_operations.push_back(std::move(literal));
+                }
+                layout->m_operations.back().text.append(text.data(), text.size());
+            };
+
+            for (std::size_t i = 0; i < pattern.size(); ++i)
+            {
+                if (pattern[i] != '%')
+                {
+                    std::size_t end = std::min(pattern.find('%', i), pattern.size());
+                    appendText(pattern.substr(i, end - i));
+                    i = end - 1;
+                    continue;
+                }
+
+                Operation operation;
+                std::size_t at = i++;
+                if (i < pattern.size() && pattern[i] == '-')
+                {
+                    operation.leftAlign = true;
+                    ++i;
+                }
+                unsigned width = 0;
+                while (i < pattern.size() && pattern[i] >= '0' && pattern[i] <= '9' && width < 1000)
+                    width = width * 10 + static_cast<unsigned>(pattern[i++] - '0');
+                operation.width = static_cast<std::uint16_t>(width);
+
+                char letter = i < pattern.size() ? pattern[i] : '\0';
+                switch (letter)
+                {
+                case '%':
+                    appendText("%");
+                    continue;
+                case 'd':
+                    operation.item = Item::TIME;
+                    break;
+                case 'L':
+                    operation.item = Item::LEVEL;
+                    break;
+                case 'S':
+                    operation.item = Item::SOURCE;
+                    break;
+                case 't':
+                    operation.item = Item::THREAD;
+                    break;
+                case 'n':
+                    operation.item = Item::SEQUENCE;
+                    break;
+                case 'm':
+                    operation.item = Item::MESSAGE;
+                    break;
+                default:
+                    error = "unknown placeholder \"" + std::string(pattern.substr(at, i + 1 - at)) + "\"";
+                    return nullptr;
+                }
+                layout->m_operations.push_back(std::move(operation));
+            }
+            return layout;
+        }
+
+        void render(std::string &line, TimestampFormatter &timestamps, LogLevel level,
+                    std::chrono::system_clock::time_point time, std::string_view source,
+                    const SourceLocation *location, std::string_view message, const SourceState *interned,
+                    std::uint32_t thread) const
+        {
+            for (const Operation &operation : m_operations)
+            {
+                std::size_t start = line.size();
+                switch (operation.item)
+                {
+                case Item::TEXT:
+                    line += operation.text;
+                    continue;
+                case Item::TIME:
+                    timestamps.append(line, time);
+                    break;
+                case Item::LEVEL:
+                    line += levelName(level);
+                    break;
+                case Item::SOURCE:
+                    appendSource(line, source, location, interned);
+                    break;
+                case Item::THREAD:
+                    appendNumber(line, thread);
+                    break;
+                case Item::SEQUENCE:
+                    appendNumber(line, m_sequence.fetch_add(1, std::memory_order_relaxed) + 1);
+                    break;
+                case Item::MESSAGE:
+                    line.append(message.data(), message.size());
+                    break;
+                }
+                pad(line, start, operation);
+            }
+        }
+    };
+
+    // Everything up to and including the message, fields follow and endLine() closes the record.
+    // TEXT:   [timestamp] [LEVEL] [source]: message, the call-site location replaces the source when present,
+    //         or the setLayout() pattern
+    // JSON:   {"time":"...","level":"...","source":"...","message":"..."
+    // LOGFMT: time=... level=... source=... msg=...
+    void beginLine(std::string &line, TimestampFormatter &timestamps, OutputFormat format, LogLevel level,
+                   std::chrono::system_clock::time_point time, std::string_view source,
+                   const SourceLocation *location, std::string_view message, const SourceState *interned = nullptr,
+                   const Layout *layout = nullptr, std::uint32_t thread = 0)
+    {
+        line.clear();
+        bool hasSource = interned || location || !source.empty();
+
+        if (format == OutputFormat::TEXT && layout)
+        {
+            layout->render(line, timestamps, level, time, source, location, message, interned, thread);
+            return;
+        }
+
+        if (format == OutputFormat::TEXT)
+        {
+            line += '[';
+            timestamps.append(line, time);
+            line += "] [";
+            line += levelName(level);
+            line += ']';
+            if (interned)
+                line += interned->prefix;
+            else if (hasSource)
+            {
+                line += " [";
+                appendSource(line, source, location, nullptr);
+                line += ']';
+            }
+            line += ": ";
+            line.append(message.data(), message.size());
+            return;
+        }
+
+        // the timestamp and source are rendered in place, only the rare value that needs escaping is copied
+        thread_local std::string scratch;
+        bool json = format == OutputFormat::JSON;
+        auto appendRendered = [&](std::size_t start)
+        {
+            std::string_view rendered(line.data() + start, line.size() - start);
+            if (json && plainJsonPrefix(rendered.data(), rendered.size()) == rendered.size())
+            {
+                line.insert(start, 1, '"');
+                line += '"';
+                return;
+            }
+            if (!json && isBareLogfmtValue(rendered))
+                return;
+
+            scratch.assign(rendered.data(), rendered.size());
+            line.resize(start);
+            if (json)
+                appendJsonString(line, scratch);
+            else
+                appendLogfmtValue(line, scratch);
+        };
+
+        line += json ? "{\"time\":" : "time=";
+        std::size_t start = line.size();
+        timestamps.append(line, time);
+        appendRendered(start);
+
+        line += json ? ",\"level\":\"" : " level=";
+        line += levelName(level);
+        if (json)
+            line += '"';
+
+        if (hasSource)
+        {
+            line += json ? ",\"source\":" : " source=";
+            start = line.size();
+            appendSource(line, source, location, interned);
+            appendRendered(start);
+        }
+
+        if (json)
+        {
+            line += ",\"message\":";
+            appendJsonString(line, message);
+        }
+        else
+        {
+            line += " msg=";
+            appendLogfmtValue(line, message);
+        }
+    }
+
+    void endLine(std::string &line, OutputFormat format)
+    {
+        if (format == OutputFormat::JSON)
+            line += '}';
+    }
+
+    void formatLine(std::string &line, TimestampFormatter &timestamps, OutputFormat format, LogLevel level,
+                    std::chrono::system_clock::time_point time, std::string_view source,
+                    const SourceLocation *location, std::string_view message, std::string_view fields = {},
+                    const SourceState *interned = nullptr, const Layout *layout = nullptr, std::uint32_t thread = 0)
+    {
+        beginLine(line, timestamps, format, level, time, source, location, message, interned, layout, thread);
+        line.append(fields.data(), fields.size());
+        endLine(line, format);
+    }
+
+    struct LineMark
+    {
+        std::size_t end;
+        LogLevel level;
+    };
+
+    // Formatted lines plus the level of each, so every sink can take just the lines it accepts
+    struct LineChunk
+    {
+        std::string text;
+        std::vector<LineMark> lines;
+        LogLevel lowest = LogLevel::NONE;
+        LogLevel highest = LogLevel::DEBUG;
+
+        void append(std::string_view line, LogLevel level)
+        {
+            text.append(line.data(), line.size());
+            text += '\n';
+            lines.push_back(LineMark{text.size(), level});
+            lowest = std::min(lowest, level);
+            highest = std::max(highest, level);
+        }
+
+        void clear()
+        {
+            text.clear();
+            lines.clear();
+            lowest = LogLevel::NONE;
+            highest = LogLevel::DEBUG;
+        }
+
+        bool empty() const { return lines.empty(); }
+    };
+
+    // Lines formatted by one thread in synchronous mode, handed to the sinks as a single chunk. The owning
+    // thread appends under its own mutex, so shared locks are only taken once per chunk instead of once per line.
+    struct StagingBuffer
+    {
+        std::mutex mutex;
+        LineChunk chunk;
+    };
+
+    // A registered sink with its own lock, level and buffer, writing to one sink never holds another sink's lock.
+    // Closed slots were removed from the logger and ignore late writes from threads that still hold them.
+    struct SinkSlot
+    {
+        logcoe::SinkId id = 0;
+        std::shared_ptr<logcoe::Sink> sink;
+        std::string name;
+        logcoe::SinkOptions options;
+        std::mutex mutex;
+        std::string buffer;
+        bool closed = false;
+        logcoe::SinkStats stats;
+
+        bool write(const LineChunk &chunk, bool flush);
+        void flush();
+        void close();
+
+    private:
+        void writeBuffer();
+        void writeLines(std::string_view lines);
+        void flushSink();
+    };
+
+    // Loops over write(2) until everything is written or it fails, usable from a signal handler
+    void writeAll(int fd, std::string_view data)
+    {
+        while (!data.empty())
+        {
+#ifdef _WIN32
+            int written = _write(fd, data.data(), static_cast<unsigned int>(data.size()));
+#else
+            ssize_t written = ::write(fd, data.data(), data.size());
+            if (written < 0 && errno == EINTR)
+                continue;
+#endif
+            if (written <= 0)
+                return;
+            data.remove_prefix(static_cast<std::size_t>(written));
+        }
+    }
+
+    class StreamSink : public logcoe::Sink
+    {
+        std::ostream &m_stream;
+
+    public:
+        explicit StreamSink(std::ostream &stream) : m_stream(stream) {}
+
+        void write(std::string_view lines) override
+        {
+            m_stream.write(lines.data(), static_cast<std::streamsize>(lines.size()));
+        }
+
+        void flush() override { m_stream.flush(); }
+
+        // only the standard streams have a known descriptor, lines already in their own buffer come first
+        void writeOnCrash(std::string_view lines) override
+        {
+            if (&m_stream == &std::cout)
+                writeAll(1, lines);
+            else if (&m_stream == &std::cerr || &m_stream == &std::clog)
+                writeAll(2, lines);
+        }
+    };
+
+    // Written through stdio so that flush() can also sync the file to disk. Unbuffered, the logger's own buffers
+    // batch the writes and the crash handler can append to the file directly.
+    class FileSink : public logcoe::Sink
+    {
+        std::FILE *m_file;
+        bool m_sync;
+
+    public:
+        FileSink(const std::string &filename, bool syncOnFlush)
+            : m_file(std::fopen(filename.c_str(), "w")), m_sync(syncOnFlush)
+        {
+            if (m_file)
+                std::setvbuf(m_file, nullptr, _IONBF, 0);
+        }
+        ~FileSink() override
+        {
+            if (m_file)
+                std::fclose(m_file);
+        }
+
+        FileSink(const FileSink &) = delete;
+        FileSink &operator=(const FileSink &) = delete;
+
+        bool isOpen() const { return m_file != nullptr; }
+
+        void write(std::string_view lines) override
+        {
+            if (m_file)
+                std::fwrite(lines.data(), 1, lines.size(), m_file);
+        }
+
+        void flush() override;
+
+        void writeOnCrash(std::string_view lines) override
+        {
+            if (!m_file)
+                return;
+#ifdef _WIN32
+            writeAll(_fileno(m_file), lines);
+#else
+            writeAll(fileno(m_file), lines);
+#endif
+        }
+    };
+
+#ifndef _WIN32
+    // Lines are copied straight into a shared mapping of the file, the kernel writes them back on its own schedule.
+    // Once a segment cannot be reserved or mapped the rest is written with pwrite(), what that cannot write either
+    // is counted in dropped().
+    class MappedFileSink : public logcoe::Sink
+    {
+        int m_fd;
+        std::size_t m_segmentSize;
+        bool m_sync;
+        char *m_segment = nullptr;
+        std::uint64_t m_segmentOffset = 0;
+        std::size_t m_used = 0;
+        std::size_t m_synced = 0;
+        std::uint64_t m_spilled = 0; // bytes written with pwrite() after the mapped ones
+        bool m_unmappable = false;
+        std::uint64_t m_dropped = 0;
+
+        bool mapNextSegment();
+        void unmapSegment();
+        std::size_t spill(std::string_view lines);
+
+    public:
+        MappedFileSink(const std::string &filename, std::size_t segmentSize, bool syncOnFlush);
+        ~MappedFileSink() override { close(); }
+
+        MappedFileSink(const MappedFileSink &) = delete;
+        MappedFileSink &operator=(const MappedFileSink &) = delete;
+
+        bool isOpen() const { return m_fd >= 0; }
+
+        void write(std::string_view lines) override;
+        void flush() override;
+        void close() override;
+        void writeOnCrash(std::string_view lines) override;
+        std::uint64_t dropped() const override { return m_dropped; }
+    };
+
+#ifdef LOGCOE_HAS_IO_URING
+    // Lines are copied into a ring of registered buffers, a full buffer is submitted as one write at its own file
+    // offset while the next one fills. A write only waits when the buffer it needs next is still in flight.
+    class UringFileSink : public logcoe::Sink
+    {
+        struct Buffer
+        {
+            char *data = nullptr;
+            std::size_t used = 0;
+            std::size_t length = 0; // bytes submitted, while in flight
+            std::uint64_t offset = 0;
+            bool inFlight = false;
+        };
+
+        static constexpr std::uint64_t syncTag = ~std::uint64_t{0};
+
+        int m_fd;
+        bool m_sync;
+        std::size_t m_bufferSize;
+        std::unique_ptr<char[]> m_memory;
+        std::vector<Buffer> m_buffers;
+        std::size_t m_current = 0;  // buffer being filled, the oldest one in flight once all are
+        std::uint64_t m_offset = 0; // file offset of the next submitted write
+        bool m_unsynced = false;
+
+        int m_ring = -1;
+        bool m_fixed = false;      // the buffers are registered, writes use IORING_OP_WRITE_FIXED
+        unsigned m_entries = 0;
+        unsigned m_pending = 0;    // operations not completed yet
+        unsigned m_unsubmitted = 0;
+        void *m_sqRing = MAP_FAILED;
+        void *m_cqRing = MAP_FAILED;
+        std::size_t m_sqRingSize = 0;
+        std::size_t m_cqRingSize = 0;
+        io_uring_sqe *m_sqes = nullptr;
+        unsigned *m_sqTail = nullptr;
+        unsigned *m_sqMask = nullptr;
+        unsigned *m_sqArray = nullptr;
+        unsigned *m_cqHead = nullptr;
+        unsigned *m_cqTail = nullptr;
+        unsigned *m_cqMask = nullptr;
+        io_uring_cqe *m_cqes = nullptr;
+
+        bool setupRing(std::size_t buffers);
+        void closeRing();
+        void push(const io_uring_sqe &entry);
+        bool enter(unsigned wait);
+        void reap();
+        void waitAll();
+        Buffer &fillBuffer();
+        void submitBuffer(bool sync);
+        void writeAt(const char *data, std::size_t size, std::uint64_t offset);
+
+    public:
+        UringFileSink(const std::string &filename, bool syncOnFlush, std::size_t bufferSize, std::size_t buffers);
+        ~UringFileSink() override
+        {
+            close();
+            closeRing();
+        }
+
+        UringFileSink(const UringFileSink &) = delete;
+        UringFileSink &operator=(const UringFileSink &) = delete;
+
+        bool isOpen() const { return m_fd >= 0; }
+
+        void write(std::string_view lines) override;
+        void flush() override;
+        void close() override;
+        void writeOnCrash(std::string_view lines) override;
+    };
+#endif
+
+    // Never waits for the peer: sends are non-blocking, what a datagram socket cannot take is dropped, a stream
+    // socket keeps up to the backlog limit and drops whole lines beyond it. A lost peer is reconnected at most
+    // once per reconnect interval, the lines written meanwhile are dropped or held like for a slow peer.
+    class SocketSink : public logcoe::Sink
+    {
+        static constexpr std::size_t batchSize = 64; // datagrams per sendmmsg() call
+
+        sockaddr_un m_address{};
+        logcoe::SocketOptions m_options;
+        int m_fd = -1;
+        std::chrono::steady_clock::time_point m_nextConnect;
+        std::string m_backlog;   // STREAM: bytes not sent yet
+        bool m_partial = false;  // STREAM: the backlog starts in the middle of a line
+        std::uint64_t m_dropped = 0;
+        iovec m_vectors[batchSize];
+#ifdef __linux__
+        mmsghdr m_messages[batchSize];
+#endif
+
+        bool connected();
+        void disconnect();
+        void sendDatagrams(std::string_view lines);
+        void sendStream(std::string_view lines);
+        void hold(std::string_view lines);
+
+    public:
+        SocketSink(const sockaddr_un &address, const logcoe::SocketOptions &options);
+        ~SocketSink() override { close(); }
+
+        SocketSink(const SocketSink &) = delete;
+        SocketSink &operator=(const SocketSink &) = delete;
+
+        void write(std::string_view lines) override;
+        void flush() override;
+        void close() override;
+        void writeOnCrash(std::string_view lines) override;
+        std::uint64_t dropped() const override { return m_dropped; }
+    };
+#endif
+
+    // Layout of a shared-memory ring, the same in every process that maps it. Positions only grow, a record starts
+    // at position % capacity and one that would cross the end is placed at the start, after padding up to the end.
+    struct SharedRingHeader
+    {
+        static constexpr std::uint32_t magicValue = 0x6c6f6773; // "logs"
+        static constexpr std::uint32_t currentVersion = 2;
+
+        std::atomic<std::uint32_t> magic; // stored last by the collector, once the rest is set
+        std::uint32_t version;
+        std::uint64_t capacity;
+        alignas(64) std::atomic<std::uint64_t> head; // next position a worker reserves
+        alignas(64) std::atomic<std::uint64_t> tail; // next position the collector reads
+        std::atomic<std::uint64_t> dropped;          // lines the workers found no room for
+        std::atomic<std::uint32_t> sleeping;         // futex word, 1 while the collector waits
+    };
+
+    // One line in the ring, 16-byte aligned. A worker claims the bytes it reserves by a compare-and-swap on the claim
+    // word at head, from the free value of that lap to its pid and the size, and only then moves head past them. The
+    // line's own header follows the padding if there is any. Storing state publishes the line. Before moving tail
+    // past what it read, the collector marks every 16-byte unit free for the next lap: the lap number (position /
+    // capacity) as claim and a zero state, so the zero filled ring starts out free for lap 0. A claim whose owner
+    // exited without publishing is skipped.
+    struct SharedRecord
+    {
+        static constexpr std::uint32_t publishedState = 1u << 31;
+        static constexpr std::uint32_t flushState = 1u << 8;
+        static constexpr std::uint64_t firstClaim = std::uint64_t{1} << 32; // smaller claim words are free laps
+
+        std::atomic<std::uint64_t> claim; // owner pid << 32 | bytes reserved from here, padding included
+        std::atomic<std::uint32_t> state; // publishedState | flushState | level
+        std::uint32_t length;             // bytes of the line, without its '\n'
+    };
+
+    static_assert(sizeof(SharedRecord) == 16, "shared records are 16-byte aligned");
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "shared positions must work across processes");
+
+    // Multi-producer ring in shared memory: worker processes reserve space with a compare-and-swap on head and never
+    // wait, a line that does not fit is dropped and counted. The single collector reads in reservation order.
+    class SharedRing
+    {
+        std::string m_name;
+        SharedRingHeader *m_header = nullptr;
+        char *m_data = nullptr;
+        std::size_t m_mapped = 0;
+        std::int64_t m_owner = 0;      // the creating process, which removes the name again
+        std::uint64_t m_abandoned = 0; // collector: lines skipped because their worker exited while writing them
+
+        SharedRing() = default;
+        static std::shared_ptr<SharedRing> map(const std::string &name, int fd, std::size_t size);
+
+        SharedRecord &recordAt(std::uint64_t position)
+        {
+            return *reinterpret_cast<SharedRecord *>(m_data + position % m_header->capacity);
+        }
+        std::uint64_t paddingAt(std::uint64_t position, std::uint64_t size) const
+        {
+            std::uint64_t room = m_header->capacity - position % m_header->capacity;
+            return size > room ? room : 0;
+        }
+        std::uint64_t lapAt(std::uint64_t position) const { return position / m_header->capacity; }
+        bool reserve(std::uint64_t claim, std::uint64_t size, std::uint64_t &position, std::uint64_t &padding);
+        bool published(std::uint64_t position);
+        void release(std::uint64_t position, std::uint64_t size, std::uint64_t lap);
+
+    public:
+        static std::shared_ptr<SharedRing> create(const std::string &name, const logcoe::SharedLogOptions &options);
+        static std::shared_ptr<SharedRing> open(const std::string &name);
+        ~SharedRing();
+
+        SharedRing(const SharedRing &) = delete;
+        SharedRing &operator=(const SharedRing &) = delete;
+
+        void write(const LineChunk &chunk, bool flush);
+        // appends lines until the chunk holds `limit` bytes or the next line is not written yet, returns the
+        // number of records read, abandoned ones included
+        std::size_t read(LineChunk &chunk, bool &flush, std::size_t limit);
+        void wait(std::chrono::milliseconds timeout);
+        void wake();
+        std::uint64_t dropped() const { return m_header->dropped.load(std::memory_order_relaxed); }
+        std::uint64_t abandoned() const { return m_abandoned; }
+    };
+
+    // The file output of initialize() and setFileOutput(), rotated according to setFileRotation()
+    class RotatingFileSink : public logcoe::Sink
+    {
+        std::string m_filename;
+        std::ofstream m_stream;
+        RotationOptions m_rotation;
+        std::uint64_t m_bytes = 0;
+        std::chrono::system_clock::time_point m_nextRotation;
+
+        void scheduleRotation();
+        void rotate();
+
+    public:
+        RotatingFileSink(std::string filename, const RotationOptions &rotation);
+
+        bool isOpen() const { return m_stream.is_open(); }
+        void setRotation(const RotationOptions &rotation);
+
+        void write(std::string_view lines) override;
+        void flush() override;
+        void writeOnCrash(std::string_view lines) override;
+    };
+
+    // Interned sources by name, leaked on purpose so Source handles outlive static destruction
+    struct SourceRegistry
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<SourceState>> sources;
+        std::unordered_map<std::string, SourceState *> byName;
+    };
+
+    SourceRegistry &sourceRegistry()
+    {
+        static SourceRegistry *registry = new SourceRegistry();
+        return *registry;
+    }
+
+    // Per-thread records that are leaked and leased to the next new thread once their owner exits, so they can be
+    // read by other threads at any time. T has an atomic<bool> leased member.
+    template <typename T>
+    struct LeasePool
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<T>> items;
+
+        T *lease()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const auto &item : items)
+            {
+                bool leased = false;
+                if (item->leased.compare_exchange_strong(leased, true, std::memory_order_acq_rel))
+                    return item.get();
+            }
+
+            items.push_back(std::make_unique<T>());
+            items.back()->leased.store(true, std::memory_order_relaxed);
+            return items.back().get();
+        }
+    };
+
+    // Counters of one thread, written only by it and summed by getStats(). A shard keeps its totals when it is
+    // leased again, so they never go back.
+    struct StatsShard
+    {
+        std::atomic<bool> leased{false};
+        std::atomic<std::uint64_t> calls{0};
+        std::atomic<std::uint64_t> accepted[4] = {};
+        std::atomic<std::uint64_t> filtered[4] = {};
+        std::atomic<std::uint64_t> bytes{0};
+        std::atomic<std::uint64_t> writes{0};
+        std::atomic<std::uint64_t> flushes{0};
+        std::atomic<std::uint64_t> contentions{0};
+        std::atomic<std::uint64_t> waitNanoseconds{0};
+        std::atomic<std::uint64_t> recorded{0};
+        std::atomic<std::uint64_t> latency[logcoe::LogStats::latencyBuckets] = {};
+    };
+
+    LeasePool<StatsShard> &statsShards()
+    {
+        static LeasePool<StatsShard> *pool = new LeasePool<StatsShard>();
+        return *pool;
+    }
+
+    struct StatsLease
+    {
+        StatsShard *shard;
+        ~StatsLease() { shard->leased.store(false, std::memory_order_release); }
+    };
+
+    // The pointer outlives the lease, a thread logging from a later thread_local destructor still has a shard
+    StatsShard &statsShard()
+    {
+        thread_local StatsShard *shard = statsShards().lease();
+        thread_local StatsLease lease{shard};
+        return *shard;
+    }
+
+    template <typename T>
+    void appendBinary(std::string &out, const T &value)
+    {
+        out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    bool readBinary(const char *&cursor, const char *end, T &value)
+    {
+        if (static_cast<std::size_t>(end - cursor) < sizeof(T))
+            return false;
+        std::memcpy(&value, cursor, sizeof(T));
+        cursor += sizeof(T);
+        return true;
+    }
+
+    bool readBinaryString(const char *&cursor, const char *end, std::size_t length, std::string_view &text)
+    {
+        if (static_cast<std::size_t>(end - cursor) < length)
+            return false;
+        text = std::string_view(cursor, length);
+        cursor += length;
+        return true;
+    }
+
+    struct DecodedArgument
+    {
+        logcoe::detail::BinaryTag tag = logcoe::detail::BinaryTag::INT;
+        std::int64_t signedValue = 0;
+        std::uint64_t unsignedValue = 0;
+        double doubleValue = 0.0;
+        std::string_view text;
+    };
+
+    void appendDecoded(std::string &out, const void *value)
+    {
+        using logcoe::detail::appendValue;
+        using logcoe::detail::BinaryTag;
+
+        const auto &argument = *static_cast<const DecodedArgument *>(value);
+        switch (argument.tag)
+        {
+        case BinaryTag::BOOL:
+            return appendValue(out, argument.unsignedValue != 0);
+        case BinaryTag::CHAR:
+            return appendValue(out, static_cast<char>(argument.signedValue));
+        case BinaryTag::INT:
+            return appendValue(out, static_cast<long long>(argument.signedValue));
+        case BinaryTag::UINT:
+            return appendValue(out, static_cast<unsigned long long>(argument.unsignedValue));
+        case BinaryTag::DOUBLE:
+            return appendValue(out, argument.doubleValue);
+        case BinaryTag::STRING:
+            return appendValue(out, argument.text);
+        default:
+        {
+            auto address = static_cast<std::uintptr_t>(argument.unsignedValue);
+            return appendValue(out, reinterpret_cast<const void *>(address));
+        }
+        }
+    }
+
+    bool decodeArgument(const char *&cursor, const char *end, DecodedArgument &argument)
+    {
+        using logcoe::detail::BinaryTag;
+
+        std::uint8_t tag;
+        if (!readBinary(cursor, end, tag))
+            return false;
+        argument.tag = static_cast<BinaryTag>(tag);
+
+        switch (argument.tag)
+        {
+        case BinaryTag::BOOL:
+        case BinaryTag::CHAR:
+        {
+            char value;
+            if (!readBinary(cursor, end, value))
+                return false;
+            argument.signedValue = value;
+            argument.unsignedValue = static_cast<unsigned char>(value);
+            return true;
+        }
+        case BinaryTag::INT:
+            return readBinary(cursor, end, argument.signedValue);
+        case BinaryTag::UINT:
+        case BinaryTag::POINTER:
+            return readBinary(cursor, end, argument.unsignedValue);
+        case BinaryTag::DOUBLE:
+            return readBinary(cursor, end, argument.doubleValue);
+        case BinaryTag::STRING:
+        {
+            std::uint32_t length;
+            return readBinary(cursor, end, length) && readBinaryString(cursor, end, length, argument.text);
+        }
+        default:
+            return false;
+        }
+    }
+
+    void appendBinaryString(std::string &out, std::string_view text)
+    {
+        out += static_cast<char>(logcoe::detail::BinaryTag::STRING);
+        appendBinary(out, static_cast<std::uint32_t>(text.size()));
+        out.append(text.data(), text.size());
+    }
+
+    // Key, then the value tagged like a binary log argument
+    void encodeFields(std::string &out, const Field *fields, std::size_t count)
+    {
+        using logcoe::detail::BinaryTag;
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const Field &field = fields[i];
+            appendBinaryString(out, field.key);
+            switch (field.type)
+            {
+            case Field::Type::BOOL:
+                out += static_cast<char>(BinaryTag::BOOL);
+                out += static_cast<char>(field.boolean);
+                break;
+            case Field::Type::INT:
+                out += static_cast<char>(BinaryTag::INT);
+                appendBinary(out, static_cast<std::int64_t>(field.integer));
+                break;
+            case Field::Type::UINT:
+                out += static_cast<char>(BinaryTag::UINT);
+                appendBinary(out, static_cast<std::uint64_t>(field.unsignedInteger));
+                break;
+            case Field::Type::DOUBLE:
+                out += static_cast<char>(BinaryTag::DOUBLE);
+                appendBinary(out, field.number);
+                break;
+            default:
+                appendBinaryString(out, field.text);
+                break;
+            }
+        }
+    }
+
+    // The fields reference the encoded text
+    bool decodeFields(std::string_view encoded, std::size_t count, std::vector<Field> &fields)
+    {
+        using logcoe::detail::BinaryTag;
+
+        fields.clear();
+        const char *cursor = encoded.data();
+        const char *end = cursor + encoded.size();
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            DecodedArgument key;
+            DecodedArgument value;
+            if (!decodeArgument(cursor, end, key) || !decodeArgument(cursor, end, value))
+                return false;
+
+            switch (value.tag)
+            {
+            case BinaryTag::BOOL:
+                fields.emplace_back(key.text, value.unsignedValue != 0);
+                break;
+            case BinaryTag::INT:
+                fields.emplace_back(key.text, static_cast<long long>(value.signedValue));
+                break;
+            case BinaryTag::UINT:
+                fields.emplace_back(key.text, static_cast<unsigned long long>(value.unsignedValue));
+                break;
+            case BinaryTag::DOUBLE:
+                fields.emplace_back(key.text, value.doubleValue);
+                break;
+            default:
+                fields.emplace_back(key.text, value.text);
+                break;
+            }
+        }
+        return true;
+    }
+
+    // "{}" arguments for formatTo(), pointing into `decoded`
+    bool decodeArguments(const char *&cursor, const char *end, std::size_t count,
+                         std::vector<DecodedArgument> &decoded, std::vector<logcoe::detail::FormatArgument> &arguments)
+    {
+        decoded.resize(count);
+        arguments.resize(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (!decodeArgument(cursor, end, decoded[i]))
+                return false;
+            arguments[i] = logcoe::detail::FormatArgument{&decoded[i], &appendDecoded, nullptr};
+        }
+        return true;
+    }
+
+    // One recorded record, kept as the call made it: the message or format string, the "{}" arguments and fields in
+    // the binary log's encoding. The strings keep their storage from lap to lap.
+    struct FlightSlot
+    {
+        // record number * 2, 0 before the first one; odd while the owner writes it or a dump reads it
+        std::atomic<std::uint64_t> sequence{0};
+        LogLevel level = LogLevel::DEBUG;
+        std::chrono::system_clock::time_point time;
+        std::string source;
+        std::string text;
+        std::string arguments;
+        std::string fields;
+        bool formatted = false; // text is a format string for `argumentCount` arguments
+        std::size_t argumentCount = 0;
+        std::size_t fieldCount = 0;
+        const SourceLocation *location = nullptr;
+        const SourceState *interned = nullptr;
+        std::uint32_t thread = 0;
+    };
+
+    // The flight recorder's ring of one thread, overwritten oldest first. Only the owner writes and a dump claims
+    // each slot through its sequence, so neither waits for the other: the owner drops a record whose slot is being
+    // read. Rings outlive their thread and are leased to the next one, a dump still finds the history of a thread
+    // that has exited.
+    struct FlightRing
+    {
+        std::atomic<bool> leased{false};
+        // -1 while the owner replaces the slots, 1 while a dump reads them
+        std::atomic<int> state{0};
+        std::unique_ptr<FlightSlot[]> slots;
+        std::size_t capacity = 0;
+        std::uint64_t generation = 0;
+        std::uint64_t written = 0; // owner only, the last record number
+        std::uint64_t dumped = 0;  // dumps only, records up to this number are written
+    };
+
+    LeasePool<FlightRing> &flightRings()
+    {
+        static LeasePool<FlightRing> *pool = new LeasePool<FlightRing>();
+        return *pool;
+    }
+
+    struct FlightLease
+    {
+        FlightRing *ring;
+        ~FlightLease() { ring->leased.store(false, std::memory_order_release); }
+    };
+
+    FlightRing &flightRing()
+    {
+        thread_local FlightRing *ring = flightRings().lease();
+        thread_local FlightLease lease{ring};
+        return *ring;
+    }
+
+    // single writer, so a plain load and store instead of a locked read-modify-write
+    void bump(std::atomic<std::uint64_t> &counter, std::uint64_t amount = 1)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    std::uint64_t elapsedNanoseconds(std::chrono::steady_clock::time_point start)
+    {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    // lock_guard that records how long the thread had to wait for the mutex in its stats shard, and for a sink slot
+    // in the slot's counters, which the caller's slot mutex guards
+    class TimedLock
+    {
+        std::mutex &m_mutex;
+
+    public:
+        explicit TimedLock(std::mutex &mutex, logcoe::SinkStats *sink = nullptr) : m_mutex(mutex)
+        {
+            if (m_mutex.try_lock())
+                return;
+
+            auto start = std::chrono::steady_clock::now();
+            m_mutex.lock();
+            std::uint64_t waited = elapsedNanoseconds(start);
+            StatsShard &stats = statsShard();
+            bump(stats.contentions);
+            bump(stats.waitNanoseconds, waited);
+            if (sink)
+            {
+                ++sink->lockContentions;
+                sink->lockWaitNanoseconds += waited;
+            }
+        }
+
+        ~TimedLock() { m_mutex.unlock(); }
+
+        TimedLock(const TimedLock &) = delete;
+        TimedLock &operator=(const TimedLock &) = delete;
+    };
+
+    // Times every 16th log call of the thread into the latency histogram
+    class LatencySample
+    {
+        StatsShard &m_stats;
+        std::chrono::steady_clock::time_point m_start;
+        bool m_active;
+
+    public:
+        explicit LatencySample(StatsShard &stats)
+            : m_stats(stats), m_active(stats.calls.load(std::memory_order_relaxed) % 16 == 0)
+        {
+            bump(m_stats.calls);
+            if (m_active)
+                m_start = std::chrono::steady_clock::now();
+        }
+
+        ~LatencySample()
+        {
+            if (!m_active)
+                return;
+
+            std::uint64_t elapsed = elapsedNanoseconds(m_start);
+            std::size_t bucket = 0;
+            while (bucket + 1 < logcoe::LogStats::latencyBuckets && elapsed >= logcoe::LogStats::latencyLimit(bucket))
+                ++bucket;
+            bump(m_stats.latency[bucket]);
+        }
+    };
+
+    // Everything a logging thread reads from the configuration, immutable once published. The setters change the
+    // LoggerImpl statics under s_mutex and publish a new snapshot, loggers read the current one without the mutex.
+    struct ConfigSnapshot
+    {
+        std::uint64_t version = 0;
+        bool initialized = false;
+        LogLevel level = LogLevel::NONE;
+        std::string defaultSource;
+        std::string timeFormat;
+        TimePrecision precision = TimePrecision::SECONDS;
+        OutputFormat format = OutputFormat::TEXT;
+        std::shared_ptr<const Layout> layout; // null for the built-in text layout
+        LogLevel flushLevel = LogLevel::WARNING;
+        std::vector<std::shared_ptr<SinkSlot>> sinks;
+        std::shared_ptr<SharedRing> shared; // setSharedOutput(): lines go there instead of the sinks
+    };
+
+    // The epoch a thread entered its current snapshot read in, 0 while it reads none
+    struct EpochSlot
+    {
+        std::atomic<bool> leased{false};
+        std::atomic<std::uint64_t> epoch{0};
+    };
+
+    LeasePool<EpochSlot> &epochSlots()
+    {
+        static LeasePool<EpochSlot> *pool = new LeasePool<EpochSlot>();
+        return *pool;
+    }
+
+    // Trivially destructible, so a thread_local destructor that logs after the lease is gone still finds it
+    struct ConfigReaderState
+    {
+        EpochSlot *slot = nullptr;
+        bool released = false;
+        bool locked = false;
+        unsigned depth = 0;
+        const ConfigSnapshot *config = nullptr;
+    };
+
+    thread_local ConfigReaderState t_configReader;
+
+    struct EpochLease
+    {
+        ~EpochLease()
+        {
+            t_configReader.slot->leased.store(false, std::memory_order_release);
+            t_configReader.slot = nullptr;
+            t_configReader.released = true;
+        }
+    };
+
+    constexpr int crashSignals[] = {SIGSEGV, SIGABRT, SIGFPE,
+#ifdef SIGBUS
+                                    SIGBUS,
+#endif
+    };
+
+    const char *crashSignalName(int signal)
+    {
+        switch (signal)
+        {
+        case SIGSEGV:
+            return "SIGSEGV";
+        case SIGABRT:
+            return "SIGABRT";
+        case SIGFPE:
+            return "SIGFPE";
+#ifdef SIGBUS
+        case SIGBUS:
+            return "SIGBUS";
+#endif
+        default:
+            return "signal";
+        }
+    }
+
+    // A line built on the stack, the crash handler cannot allocate
+    struct CrashLine
+    {
+        char text[256];
+        std::size_t size = 0;
+
+        void append(std::string_view part)
+        {
+            std::size_t count = std::min(part.size(), sizeof(text) - size);
+            std::memcpy(text + size, part.data(), count);
+            size += count;
+        }
+
+        std::string_view view() const { return std::string_view(text, size); }
+    };
+
+    class LoggerImpl
+    {
+        static unsigned int s_initCounter;
+        static LogLevel s_logLevel;
+        static std::string s_defaultSource;
+        static std::mutex s_mutex;
+        static std::string s_filename;
+        static TimestampFormatter s_timestampFormatter;
+        static std::string s_lineBuffer;
+        static LineChunk s_messageChunk;
+        static RotationOptions s_rotation;
+        static FlushPolicy s_flushPolicy;
+        static std::atomic<OutputFormat> s_outputFormat;
+        static std::shared_ptr<const Layout> s_layout;
+
+        static std::vector<std::shared_ptr<SinkSlot>> s_sinks;
+        static std::shared_ptr<SinkSlot> s_consoleSlot;
+        static std::shared_ptr<SinkSlot> s_fileSlot;
+        static logcoe::SinkId s_nextSinkId;
+
+        static std::unique_ptr<RecordQueue> s_queue;
+        static OverflowPolicy s_overflowPolicy;
+        static std::thread s_worker;
+        static std::mutex s_workerMutex;
+        static std::condition_variable s_workerCondition;
+        static std::condition_variable s_progressCondition;
+        static std::atomic<bool> s_asyncEnabled;
+        static std::atomic<std::uint32_t> s_producers; // threads between the async check and their push
+        static std::atomic<bool> s_workerStop;
+        static std::atomic<bool> s_workerSleeping;
+        static std::atomic<std::uint64_t> s_enqueuedCount;
+        static std::atomic<std::uint64_t> s_completedCount;
+        static std::atomic<std::uint64_t> s_droppedCount;
+
+        static std::mutex s_stagingMutex;
+        static std::vector<std::shared_ptr<StagingBuffer>> s_stagingBuffers;
+        static std::atomic<std::uint64_t> s_configVersion;
+        static std::atomic<const ConfigSnapshot *> s_config;
+        static std::atomic<std::uint64_t> s_configEpoch;
+        static std::vector<std::pair<const ConfigSnapshot *, std::uint64_t>> s_retiredConfigs;
+
+        static std::thread s_flushThread;
+        static std::mutex s_flushMutex;
+        static std::condition_variable s_flushCondition;
+        static std::chrono::milliseconds s_flushInterval;
+        static bool s_flushStop;
+
+        static std::thread s_reportThread;
+        static std::mutex s_reportMutex;
+        static std::condition_variable s_reportCondition;
+        static std::chrono::milliseconds s_reportInterval;
+        static logcoe::SinkId s_reportSink;
+        static bool s_reportStop;
+
+        static bool s_crashHandler;
+        static std::atomic<bool> s_crashing;
+
+        static logcoe::FlightRecorderOptions s_recorder;
+        static std::atomic<std::size_t> s_recorderCapacity;
+        static std::atomic<LogLevel> s_recorderTrigger;
+        static std::atomic<std::uint64_t> s_recorderGeneration;
+        static std::shared_ptr<SharedRing> s_sharedOutput;
+        static std::shared_ptr<SharedRing> s_collectorRing;
+        static std::thread s_collectorThread;
+        static std::mutex s_collectorMutex; // held by the collector for each batch, and across fork()
+        static std::atomic<bool> s_collectorStop;
+        static std::terminate_handler s_previousTerminate;
+
+        static std::mutex s_formatWarningsMutex;
+        static std::unordered_set<std::string> s_formatWarnings;
+#ifdef _WIN32
+        static void (*s_previousSignalHandlers[std::size(crashSignals)])(int);
+#else
+        static struct sigaction s_previousSignalActions[std::size(crashSignals)];
+#endif
+
+        static std::string formatTimestamp(std::chrono::system_clock::time_point time);
+        static std::string getCurrentTimestamp();
+        static std::string getLogLevelAsString(LogLevel level);
+        static void writeToOutputs(const std::string &formattedMessage,
+                                   LogLevel level = LogLevel::INFO,
+                                   bool flush = true);
+        static void flushOutputs();
+        static void publishActiveLevel();
+        static void publishConfig();
+        static void reclaimConfigs();
+        struct ConfigReader;
+        static LogLevel outputThreshold(LogLevel level);
+        static LogLevel recorderThreshold(LogLevel output);
+
+        static void attachSink(const std::shared_ptr<SinkSlot> &slot);
+        static void detachSink(std::shared_ptr<SinkSlot> &slot);
+        static void applyFlushPolicy(SinkSlot &slot);
+        static void attachConsole(std::ostream &stream);
+        static bool openFileOutput();
+        static void dispatch(const LineChunk &chunk, bool flush, bool local = false);
+        static void dispatchLocked(const LineChunk &chunk, bool flush);
+
+        static bool enqueue(LogRecord &record);
+        static void wakeWorker();
+        static void writeBatch(const LogRecord *records, std::size_t count);
+        static void workerLoop();
+        static void startWorker(const AsyncOptions &options);
+        static void stopWorker();
+        static void drainQueue();
+
+        struct StagingThread;
+        static StagingThread &stagingThread();
+        static void refreshStaging(StagingThread &staging);
+        static void publishStaged(StagingBuffer &buffer, bool flush);
+        static void drainStaging();
+
+        static void setFlushInterval(std::chrono::milliseconds interval);
+        static void stopFlushTimer();
+        static void flushTimerLoop();
+
+        static void stopStatsReport();
+        static void statsReportLoop();
+        static void writeStatsReport(logcoe::SinkId target);
+
+        static LogLevel outputLevel(const SourceState *interned);
+        static void recordRecent(LogLevel level, std::string_view text, bool formatted,
+                                 const logcoe::detail::FormatArgument *arguments, std::size_t argumentCount,
+                                 std::string_view source, const SourceLocation *location, const Field *fields,
+                                 std::size_t fieldCount, const SourceState *interned);
+        static void dumpRecorded(LogLevel level, std::chrono::system_clock::time_point until);
+
+        static void collectorLoop();
+        static void beforeFork();
+        static void afterForkParent();
+        static void afterForkChild();
+
+        static void installCrashHandler(bool enabled);
+        static void drainOnCrash(std::string_view reason);
+        static void onCrashSignal(int signal);
+        static void onTerminate();
+
+    public:
+        static constexpr std::size_t stagingCapacity = 16 * 1024;
+        static constexpr std::size_t maxBatchSize = 256;
+
+        static void initialize(LogLevel level = LogLevel::INFO,
+                               const std::string &defaultSource = "",
+                               bool enableConsole = true,
+                               bool enableFile = false,
+                               const std::string &filename = "logcoe.log",
+                               const AsyncOptions &async = AsyncOptions{});
+        static void shutdown();
+
+        static void setLogLevel(LogLevel level);
+        static void setConsoleOutput(std::ostream &stream);
+        static bool setFileOutput(const std::string &filename);
+        static void disableConsoleOutput();
+        static void disableFileOutput();
+        static void setTimeFormat(const std::string &format, TimePrecision precision);
+        static void setFileRotation(const RotationOptions &options);
+        static void setFlushPolicy(const FlushPolicy &policy);
+        static void setOutputFormat(OutputFormat format);
+        static void setLayout(const std::string &pattern);
+
+        static logcoe::SinkId addSink(std::shared_ptr<logcoe::Sink> sink, const logcoe::SinkOptions &options);
+        static bool removeSink(logcoe::SinkId id);
+        static bool setSinkLevel(logcoe::SinkId id, LogLevel level);
+
+        static SourceState *internSource(std::string_view name);
+        static void setSourceLevel(SourceState &source, bool overridden, LogLevel level);
+        static LogLevel getSourceLevel(const SourceState &source);
+
+        static bool isInitialized();
+        static LogLevel getLogLevel();
+        static bool isAsync();
+        static std::uint64_t getDroppedMessageCount();
+        static logcoe::LogStats getStats();
+        static void setStatsReport(std::chrono::milliseconds interval, logcoe::SinkId sink);
+        static void setCrashHandler(bool enabled);
+        static void setFlightRecorder(const logcoe::FlightRecorderOptions &options);
+        static void dumpRecent();
+        static bool startCollector(const std::string &name, const logcoe::SharedLogOptions &options);
+        static void stopCollector();
+        static bool setSharedOutput(const std::string &name);
+        static void disableSharedOutput();
+
+        static void log(LogLevel level, std::string_view message, std::string_view source, bool flush,
+                        const SourceLocation *location = nullptr, const Field *fields = nullptr,
+                        std::size_t fieldCount = 0, const SourceState *interned = nullptr);
+        // Keeps a "{}" call the flight recorder takes without formatting it, false when it is written instead
+        static bool recordFormatted(LogLevel level, const SourceLocation *location, std::string_view format,
+                                    const logcoe::detail::FormatArgument *arguments, std::size_t count,
+                                    const SourceState *interned);
+        static void flush();
+        // One "[logcoe] WARNING" per distinct format text, for calls whose "{}" and arguments do not line up
+        static void warnFormatMismatch(std::string_view format, std::size_t count);
+        static void warnUnformattedMessage(std::string_view message, std::string_view source);
+        static bool firstFormatWarning(std::string_view format);
+
+        static void writeRecords(const LogRecord *records, std::size_t count);
+        static void getTimeFormat(std::string &format, TimePrecision &precision);
+    };
+
+    struct BinaryFormat
+    {
+        LogLevel level = LogLevel::INFO;
+        SourceLocation location{"", 0, ""};
+        std::string file;
+        std::string format;
+        std::size_t argumentCount = 0;
+    };
+
+    // Per-thread record buffer for deferred binary logging. The owning thread appends under its own mutex,
+    // the drainer swaps data with spare (which only the drainer touches), so neither side allocates in steady state.
+    struct BinaryThreadBuffer
+    {
+        std::mutex mutex;
+        std::vector<char> data;
+        std::vector<char> spare;
+        bool orphaned = false;
+    };
+
+    class BinaryLogger
+    {
+        static std::mutex s_formatsMutex;
+        static std::vector<std::unique_ptr<BinaryFormat>> s_formats;
+
+        static std::mutex s_buffersMutex;
+        static std::vector<std::shared_ptr<BinaryThreadBuffer>> s_buffers;
+
+        static std::mutex s_drainMutex;
+        static std::ofstream s_file;
+        static std::size_t s_formatsWritten;
+        static std::vector<LogRecord> s_decoded;
+
+        static std::mutex s_threadMutex;
+        static std::condition_variable s_threadCondition;
+        static std::thread s_thread;
+        static std::atomic<bool> s_running;
+        static bool s_stop;
+        static std::atomic<std::uint64_t> s_droppedCount;
+
+        static BinaryThreadBuffer &threadBuffer();
+        static void threadLoop();
+        static void start();
+        static void writeFormats(std::size_t end);
+        static void decodeChunk(const std::vector<char> &chunk);
+
+    public:
+        static constexpr std::size_t recordHeaderSize = 1 + sizeof(std::uint32_t) + sizeof(std::int64_t);
+        static constexpr std::size_t wakeThreshold = 64 * 1024;
+        static constexpr std::size_t maxBufferSize = 8 * 1024 * 1024;
+
+        static std::uint32_t registerFormat(LogLevel level, const SourceLocation &location, std::string_view format,
+                                            std::size_t argumentCount);
+        static char *beginRecord(std::uint32_t formatId, std::size_t payloadSize);
+        static void endRecord();
+
+        static bool setOutput(const std::string &filename);
+        static void disableOutput();
+        static void drain();
+        static void stop();
+        static std::uint64_t droppedCount();
+
+        static void beforeFork();
+        static void afterForkParent();
+        static void afterForkChild();
+    };
+
+    struct ArchiveJob
+    {
+        std::string rotatedFile;
+        std::string activeFile;
+        Compression compression = Compression::NONE;
+        std::size_t maxFiles = 0;
+    };
+
+    // Compresses rotated log files and removes the oldest ones, always on its own thread
+    class FileArchiver
+    {
+        static std::mutex s_mutex;
+        static std::condition_variable s_condition;
+        static std::deque<ArchiveJob> s_jobs;
+        static std::thread s_thread;
+        static bool s_stop;
+
+        static void threadLoop();
+        static void compress(const std::string &file, Compression compression);
+        static void prune(const std::string &activeFile, std::size_t maxFiles);
+
+    public:
+        static bool supports(Compression compression);
+        static void submit(ArchiveJob job);
+        static void stop();
+    };
+
+    bool SinkSlot::write(const LineChunk &chunk, bool flush)
+    {
+        TimedLock lock(mutex, &stats);
+        if (closed)
+            return false;
+
+        int level = static_cast<int>(options.level);
+        if (chunk.empty() || static_cast<int>(chunk.highest) < level)
+        {
+            stats.filtered += chunk.lines.size();
+            return true;
+        }
+
+        bool flushNow = flush || static_cast<int>(chunk.highest) >= static_cast<int>(options.flushLevel);
+        bool whole = static_cast<int>(chunk.lowest) >= level;
+        if (whole)
+            stats.lines += chunk.lines.size();
+
+        if (whole && buffer.empty() && (options.bufferSize == 0 || flushNow))
+            writeLines(chunk.text);
+        else
+        {
+            if (whole)
+                buffer += chunk.text;
+            else
+            {
+                std::size_t begin = 0;
+                for (const auto &line : chunk.lines)
+                {
+                    if (static_cast<int>(line.level) >= level)
+                    {
+                        buffer.append(chunk.text, begin, line.end - begin);
+                        stats.lines++;
+                    }
+                    else
+                        stats.filtered++;
+                    begin = line.end;
+                }
+            }
+
+            if (flushNow || buffer.size() >= options.bufferSize)
+                writeBuffer();
+        }
+
+        if (flushNow)
+            flushSink();
+        return true;
+    }
+
+    void SinkSlot::flush()
+    {
+        TimedLock lock(mutex, &stats);
+        if (closed)
+            return;
+
+        writeBuffer();
+        flushSink();
+    }
+
+    void SinkSlot::close()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (closed)
+            return;
+
+        writeBuffer();
+        flushSink();
+        sink->close();
+        closed = true;
+    }
+
+    void SinkSlot::writeBuffer()
+    {
+        if (buffer.empty())
+            return;
+
+        writeLines(buffer);
+        buffer.clear();
+    }
+
+    void SinkSlot::writeLines(std::string_view lines)
+    {
+        sink->write(lines);
+        stats.bytes += lines.size();
+        stats.writes++;
+
+        StatsShard &shard = statsShard();
+        bump(shard.bytes, lines.size());
+        bump(shard.writes);
+    }
+
+    void SinkSlot::flushSink()
+    {
+        sink->flush();
+        stats.flushes++;
+        bump(statsShard().flushes);
+    }
+
+    void FileSink::flush()
+    {
+        if (!m_file)
+            return;
+
+        std::fflush(m_file);
+        if (m_sync)
+        {
+#ifdef _WIN32
+            _commit(_fileno(m_file));
+#else
+            fsync(fileno(m_file));
+#endif
+        }
+    }
+
+#ifndef _WIN32
+    MappedFileSink::MappedFileSink(const std::string &filename, std::size_t segmentSize, bool syncOnFlush)
+        : m_fd(::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644)), m_sync(syncOnFlush)
+    {
+        // mapping offsets must be page aligned, so segments are whole pages
+        auto page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        m_segmentSize = std::max(page, (segmentSize + page - 1) / page * page);
+    }
+
+    bool MappedFileSink::mapNextSegment()
+    {
+        if (m_segment)
+        {
+            unmapSegment();
+            m_segmentOffset += m_segmentSize;
+            m_used = 0;
+            m_synced = 0;
+        }
+
+#ifdef __linux__
+        // reserve the blocks up front, a full disk then fails here instead of as SIGBUS inside memcpy
+        if (posix_fallocate(m_fd, static_cast<off_t>(m_segmentOffset), static_cast<off_t>(m_segmentSize)) != 0)
+            return false;
+#else
+        if (ftruncate(m_fd, static_cast<off_t>(m_segmentOffset + m_segmentSize)) != 0)
+            return false;
+#endif
+
+        void *segment = mmap(nullptr, m_segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd,
+                             static_cast<off_t>(m_segmentOffset));
+        if (segment == MAP_FAILED)
+            return false;
+
+        m_segment = static_cast<char *>(segment);
+        m_used = 0;
+        m_synced = 0;
+        return true;
+    }
+
+    void MappedFileSink::unmapSegment()
+    {
+        if (m_sync && m_used > m_synced)
+            msync(m_segment, m_used, MS_ASYNC);
+        munmap(m_segment, m_segmentSize);
+        m_segment = nullptr;
+    }
+
+    void MappedFileSink::write(std::string_view lines)
+    {
+        if (m_fd < 0)
+            return;
+
+        while (!lines.empty())
+        {
+            if (!m_unmappable && (!m_segment || m_used == m_segmentSize) && !mapNextSegment())
+                m_unmappable = true;
+            if (m_unmappable)
+            {
+                // lines cut off by a failed write count as dropped
+                lines.remove_prefix(spill(lines));
+                m_dropped += static_cast<std::uint64_t>(std::count(lines.begin(), lines.end(), '\n'));
+                return;
+            }
+
+            std::size_t count = std::min(lines.size(), m_segmentSize - m_used);
+            std::memcpy(m_segment + m_used, lines.data(), count);
+            m_used += count;
+            lines.remove_prefix(count);
+        }
+    }
+
+    // Writes past the mapped bytes, returns how many were written before an error
+    std::size_t MappedFileSink::spill(std::string_view lines)
+    {
+        std::size_t total = 0;
+        while (total < lines.size())
+        {
+            ssize_t written = pwrite(m_fd, lines.data() + total, lines.size() - total,
+                                     static_cast<off_t>(m_segmentOffset + m_used + m_spilled));
+            if (written < 0 && errno == EINTR)
+                continue;
+            if (written <= 0)
+                break;
+            m_spilled += static_cast<std::uint64_t>(written);
+            total += static_cast<std::size_t>(written);
+        }
+        return total;
+    }
+
+    void MappedFileSink::flush()
+    {
+        if (!m_sync || !m_segment || m_used == m_synced)
+            return;
+
+        // msync takes a page aligned start, the pages before the last synced one are already scheduled
+        auto page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        std::size_t begin = m_synced / page * page;
+        msync(m_segment + begin, m_used - begin, MS_ASYNC);
+        m_synced = m_used;
+    }
+
+    void MappedFileSink::close()
+    {
+        if (m_fd < 0)
+            return;
+
+        std::uint64_t length = m_segmentOffset + m_used + m_spilled;
+        if (m_segment)
+            unmapSegment();
+        // drop the unused tail of the last segment
+        static_cast<void>(ftruncate(m_fd, static_cast<off_t>(length)));
+        ::close(m_fd);
+        m_fd = -1;
+    }
+
+    // Fills the mapped segment, writes the rest past it and cuts the preallocated tail, the process dies next
+    void MappedFileSink::writeOnCrash(std::string_view lines)
+    {
+        if (m_fd < 0)
+            return;
+
+        if (m_segment && m_spilled == 0)
+        {
+            std::size_t count = std::min(lines.size(), m_segmentSize - m_used);
+            std::memcpy(m_segment + m_used, lines.data(), count);
+            m_used += count;
+            lines.remove_prefix(count);
+        }
+
+        spill(lines);
+        static_cast<void>(ftruncate(m_fd, static_cast<off_t>(m_segmentOffset + m_used + m_spilled)));
+    }
+
+#ifdef LOGCOE_HAS_IO_URING
+    UringFileSink::UringFileSink(const std::string &filename, bool syncOnFlush, std::size_t bufferSize,
+                                 std::size_t buffers)
+        : m_fd(::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)), m_sync(syncOnFlush),
+          m_bufferSize(std::max<std::size_t>(bufferSize, 4096))
+    {
+        buffers = std::max<std::size_t>(buffers, 1);
+        m_memory.reset(new char[buffers * m_bufferSize]);
+        m_buffers.resize(buffers);
+        for (std::size_t i = 0; i < buffers; ++i)
+            m_buffers[i].data = m_memory.get() + i * m_bufferSize;
+
+        if (m_fd >= 0 && !setupRing(buffers))
+        {
+            closeRing();
+            ::close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+    // io_uring_setup fails with ENOSYS on old kernels and EPERM where it is disabled or filtered by seccomp
+    bool UringFileSink::setupRing(std::size_t buffers)
+    {
+        io_uring_params params{};
+        // a write and a sync per buffer, the completion queue is twice as large
+        auto entries = static_cast<unsigned>(std::min<std::size_t>(buffers * 2, 4096));
+        int ring = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (ring < 0)
+            return false;
+        m_ring = ring;
+        m_entries = params.sq_entries;
+
+        m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single)
+            m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+
+        m_sqRing = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring,
+                        IORING_OFF_SQ_RING);
+        if (m_sqRing == MAP_FAILED)
+            return false;
+        m_cqRing = single ? m_sqRing
+                          : mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring,
+                                 IORING_OFF_CQ_RING);
+        if (m_cqRing == MAP_FAILED)
+            return false;
+        void *sqes = mmap(nullptr, params.sq_entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED)
+            return false;
+        m_sqes = static_cast<io_uring_sqe *>(sqes);
+
+        char *sq = static_cast<char *>(m_sqRing);
+        char *cq = static_cast<char *>(m_cqRing);
+        m_sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        m_sqMask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        m_sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        m_cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        m_cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        m_cqMask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        m_cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+        // registration counts against RLIMIT_MEMLOCK on older kernels, without it writes pass plain addresses
+        std::vector<iovec> vectors(m_buffers.size());
+        for (std::size_t i = 0; i < m_buffers.size(); ++i)
+            vectors[i] = {m_buffers[i].data, m_bufferSize};
+        m_fixed = syscall(__NR_io_uring_register, ring, IORING_REGISTER_BUFFERS, vectors.data(),
+                          static_cast<unsigned>(vectors.size())) == 0;
+        return true;
+    }
+
+    void UringFileSink::closeRing()
+    {
+        if (m_sqes)
+            munmap(m_sqes, m_entries * sizeof(io_uring_sqe));
+        if (m_cqRing != MAP_FAILED && m_cqRing != m_sqRing)
+            munmap(m_cqRing, m_cqRingSize);
+        if (m_sqRing != MAP_FAILED)
+            munmap(m_sqRing, m_sqRingSize);
+        if (m_ring >= 0)
+            ::close(m_ring);
+        m_sqes = nullptr;
+        m_sqRing = m_cqRing = MAP_FAILED;
+        m_ring = -1;
+    }
+
+    // Only this thread fills the submission queue, the kernel reads the tail once the entry is complete
+    void UringFileSink::push(const io_uring_sqe &entry)
+    {
+        while (m_pending >= m_entries)
+        {
+            enter(1);
+            reap();
+        }
+
+        unsigned tail = *m_sqTail;
+        unsigned index = tail & *m_sqMask;
+        m_sqes[index] = entry;
+        m_sqArray[index] = index;
+        __atomic_store_n(m_sqTail, tail + 1, __ATOMIC_RELEASE);
+        m_unsubmitted++;
+        m_pending++;
+    }
+
+    // Submits what was pushed and waits for at least `wait` completions, no allocation so it is usable on a crash
+    bool UringFileSink::enter(unsigned wait)
+    {
+        for (;;)
+        {
+            long submitted = syscall(__NR_io_uring_enter, m_ring, m_unsubmitted, wait,
+                                     wait > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+            if (submitted >= 0)
+            {
+                m_unsubmitted -= static_cast<unsigned>(submitted);
+                return true;
+            }
+            if (errno == EINTR)
+                continue;
+            // a full completion queue has to be emptied first
+            if ((errno == EAGAIN || errno == EBUSY) && m_pending > 0)
+            {
+                reap();
+                continue;
+            }
+            return false;
+        }
+    }
+
+    void UringFileSink::reap()
+    {
+        unsigned head = *m_cqHead;
+        unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head)
+        {
+            const io_uring_cqe &completion = m_cqes[head & *m_cqMask];
+            m_pending--;
+            if (completion.user_data == syncTag)
+                continue;
+
+            // a short or failed write is finished with pwrite
+            Buffer &buffer = m_buffers[completion.user_data];
+            std::size_t written = completion.res > 0 ? static_cast<std::size_t>(completion.res) : 0;
+            if (written < buffer.length)
+                writeAt(buffer.data + written, buffer.length - written, buffer.offset + written);
+            buffer.used = 0;
+            buffer.inFlight = false;
+        }
+        __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+    }
+
+    void UringFileSink::waitAll()
+    {
+        while (m_pending > 0 && enter(1))
+            reap();
+    }
+
+    // buffers are submitted in turn, so the current one is also the first to complete
+    UringFileSink::Buffer &UringFileSink::fillBuffer()
+    {
+        Buffer &buffer = m_buffers[m_current];
+        if (buffer.inFlight)
+            reap();
+        while (buffer.inFlight && enter(1))
+            reap();
+        return buffer;
+    }
+
+    void UringFileSink::submitBuffer(bool sync)
+    {
+        Buffer &buffer = m_buffers[m_current];
+        if (buffer.used > 0 && !buffer.inFlight)
+        {
+            io_uring_sqe entry{};
+            entry.opcode = m_fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+            entry.fd = m_fd;
+            entry.addr = reinterpret_cast<std::uint64_t>(buffer.data);
+            entry.len = static_cast<std::uint32_t>(buffer.used);
+            entry.off = m_offset;
+            entry.buf_index = static_cast<std::uint16_t>(m_current);
+            entry.user_data = m_current;
+
+            buffer.length = buffer.used;
+            buffer.offset = m_offset;
+            buffer.inFlight = true;
+            m_offset += buffer.used;
+            m_unsynced = true;
+            m_current = (m_current + 1) % m_buffers.size();
+            push(entry);
+        }
+
+        // drained, so the sync covers every write submitted before it and not just the last one
+        if (sync && m_unsynced)
+        {
+            io_uring_sqe entry{};
+            entry.opcode = IORING_OP_FSYNC;
+            entry.flags = IOSQE_IO_DRAIN;
+            entry.fd = m_fd;
+            entry.fsync_flags = IORING_FSYNC_DATASYNC;
+            entry.user_data = syncTag;
+            m_unsynced = false;
+            push(entry);
+        }
+
+        if (m_unsubmitted > 0)
+            enter(0);
+    }
+
+    void UringFileSink::writeAt(const char *data, std::size_t size, std::uint64_t offset)
+    {
+        while (size > 0)
+        {
+            ssize_t written = pwrite(m_fd, data, size, static_cast<off_t>(offset));
+            if (written < 0 && errno == EINTR)
+                continue;
+            if (written <= 0)
+                return;
+            data += written;
+            size -= static_cast<std::size_t>(written);
+            offset += static_cast<std::uint64_t>(written);
+        }
+    }
+
+    void UringFileSink::write(std::string_view lines)
+    {
+        if (m_fd < 0)
+            return;
+
+        while (!lines.empty())
+        {
+            Buffer &buffer = fillBuffer();
+            if (buffer.inFlight)
+            {
+                // the ring stopped working, write synchronously at the offsets it would have used
+                writeAt(lines.data(), lines.size(), m_offset);
+                m_offset += lines.size();
+                return;
+            }
+
+            std::size_t count = std::min(lines.size(), m_bufferSize - buffer.used);
+            std::memcpy(buffer.data + buffer.used, lines.data(), count);
+            buffer.used += count;
+            lines.remove_prefix(count);
+
+            if (buffer.used == m_bufferSize)
+                submitBuffer(false);
+        }
+    }
+
+    void UringFileSink::flush()
+    {
+        if (m_fd < 0)
+            return;
+
+        // a few lines with the ring idle are cheaper as one pwrite than as a submission and a buffer in flight
+        reap();
+        Buffer &buffer = m_buffers[m_current];
+        if (m_pending == 0 && !buffer.inFlight && buffer.used > 0 && buffer.used <= m_bufferSize / 8)
+        {
+            writeAt(buffer.data, buffer.used, m_offset);
+            m_offset += buffer.used;
+            buffer.used = 0;
+            m_unsynced = true;
+        }
+        submitBuffer(m_sync);
+    }
+
+    void UringFileSink::close()
+    {
+        if (m_fd < 0)
+            return;
+
+        submitBuffer(false);
+        waitAll();
+        if (m_sync)
+            fdatasync(m_fd);
+        ::close(m_fd);
+        m_fd = -1;
+    }
+
+    // Lets the writes in flight finish, then appends the filling buffer and the lines with pwrite
+    void UringFileSink::writeOnCrash(std::string_view lines)
+    {
+        if (m_fd < 0)
+            return;
+
+        waitAll();
+        Buffer &buffer = m_buffers[m_current];
+        if (!buffer.inFlight)
+        {
+            writeAt(buffer.data, buffer.used, m_offset);
+            m_offset += buffer.used;
+            buffer.used = 0;
+        }
+        writeAt(lines.data(), lines.size(), m_offset);
+        m_offset += lines.size();
+    }
+#endif
+
+#ifdef MSG_NOSIGNAL
+    constexpr int sendFlags = MSG_DONTWAIT | MSG_NOSIGNAL;
+#else
+    constexpr int sendFlags = MSG_DONTWAIT; // SO_NOSIGPIPE is set on the socket instead
+#endif
+
+    std::size_t countLines(std::string_view lines)
+    {
+        return static_cast<std::size_t>(std::count(lines.begin(), lines.end(), '\n'));
+    }
+
+    bool isPeerGone(int error)
+    {
+        return error == ECONNREFUSED || error == ECONNRESET || error == ENOTCONN || error == EPIPE ||
+               error == ENOENT || error == EDESTADDRREQ;
+    }
+
+    SocketSink::SocketSink(const sockaddr_un &address, const logcoe::SocketOptions &options)
+        : m_address(address), m_options(options), m_nextConnect(std::chrono::steady_clock::now())
+    {
+#ifdef __linux__
+        std::memset(m_messages, 0, sizeof(m_messages));
+        for (std::size_t i = 0; i < batchSize; ++i)
+        {
+            m_messages[i].msg_hdr.msg_iov = &m_vectors[i];
+            m_messages[i].msg_hdr.msg_iovlen = 1;
+        }
+#endif
+        connected();
+    }
+
+    bool SocketSink::connected()
+    {
+        if (m_fd >= 0)
+            return true;
+
+        auto now = std::chrono::steady_clock::now();
+        if (now < m_nextConnect)
+            return false;
+        m_nextConnect = now + m_options.reconnectInterval;
+
+        int type = m_options.type == logcoe::SocketType::STREAM ? SOCK_STREAM : SOCK_DGRAM;
+        int fd = ::socket(AF_UNIX, type, 0);
+        if (fd < 0)
+            return false;
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+#ifdef SO_NOSIGPIPE
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+
+        // a stream connection still in progress behaves like a slow peer until it completes
+        if (::connect(fd, reinterpret_cast<const sockaddr *>(&m_address), sizeof(m_address)) != 0 &&
+            errno != EINPROGRESS)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        m_fd = fd;
+        return true;
+    }
+
+    // a line cut off on the old connection cannot be finished on the new one
+    void SocketSink::disconnect()
+    {
+        ::close(m_fd);
+        m_fd = -1;
+        if (m_partial)
+        {
+            std::size_t end = m_backlog.find('\n');
+            m_backlog.erase(0, end == std::string::npos ? m_backlog.size() : end + 1);
+            m_partial = false;
+            m_dropped++;
+        }
+    }
+
+    void SocketSink::write(std::string_view lines)
+    {
+        if (m_options.type == logcoe::SocketType::STREAM)
+            sendStream(lines);
+        else
+            sendDatagrams(lines);
+    }
+
+    void SocketSink::sendDatagrams(std::string_view lines)
+    {
+        if (!connected())
+        {
+            m_dropped += countLines(lines);
+            return;
+        }
+
+        while (!lines.empty())
+        {
+            std::size_t count = 0;
+            std::string_view rest = lines;
+            while (!rest.empty() && count < batchSize)
+            {
+                std::size_t end = rest.find('\n');
+                std::size_t length = end == std::string_view::npos ? rest.size() : end;
+                m_vectors[count].iov_base = const_cast<char *>(rest.data());
+                m_vectors[count].iov_len = length;
+                rest.remove_prefix(std::min(rest.size(), length + 1));
+                count++;
+            }
+
+#ifdef __linux__
+            int sent = ::sendmmsg(m_fd, m_messages, static_cast<unsigned int>(count), sendFlags);
+#else
+            int sent = 0;
+            while (static_cast<std::size_t>(sent) < count &&
+                   ::send(m_fd, m_vectors[sent].iov_base, m_vectors[sent].iov_len, sendFlags) >= 0)
+                sent++;
+            if (sent == 0)
+                sent = -1;
+#endif
+            // after a partial batch the error is lost, the next call starts with the failed datagram and reports it
+            if (sent >= 0)
+            {
+                auto done = static_cast<std::size_t>(sent);
+                if (done == count)
+                    lines = rest;
+                else
+                    lines.remove_prefix(static_cast<std::size_t>(static_cast<const char *>(m_vectors[done].iov_base) -
+                                                                 lines.data()));
+                continue;
+            }
+
+            int error = errno;
+            if (error == EINTR)
+                continue;
+            if (error == EMSGSIZE)
+            {
+                m_dropped++;
+                lines.remove_prefix(std::min(lines.size(), m_vectors[0].iov_len + 1));
+                continue;
+            }
+
+            if (isPeerGone(error))
+                disconnect();
+            m_dropped += countLines(lines);
+            return;
+        }
+    }
+
+    void SocketSink::sendStream(std::string_view lines)
+    {
+        if (!connected())
+            return hold(lines);
+
+        iovec vectors[2] = {{m_backlog.data(), m_backlog.size()}, {const_cast<char *>(lines.data()), lines.size()}};
+        msghdr message{};
+        message.msg_iov = vectors;
+        message.msg_iovlen = 2;
+
+        ssize_t sent;
+        do
+            sent = ::sendmsg(m_fd, &message, sendFlags);
+        while (sent < 0 && errno == EINTR);
+
+        if (sent < 0)
+        {
+            if (isPeerGone(errno))
+                disconnect();
+            return hold(lines);
+        }
+
+        auto done = static_cast<std::size_t>(sent);
+        std::size_t fromBacklog = std::min(done, m_backlog.size());
+        if (fromBacklog > 0)
+        {
+            m_partial = fromBacklog < m_backlog.size() && m_backlog[fromBacklog - 1] != '\n';
+            m_backlog.erase(0, fromBacklog);
+            done -= fromBacklog;
+        }
+        if (!m_backlog.empty() || done == lines.size())
+            return hold(lines.substr(done));
+
+        // the rest of a line that was sent in part is always kept, the stream would be corrupt without it
+        lines.remove_prefix(done);
+        if (done > 0 && lines.data()[-1] != '\n')
+        {
+            std::size_t end = lines.find('\n');
+            std::size_t length = end == std::string_view::npos ? lines.size() : end + 1;
+            m_backlog.append(lines.data(), length);
+            m_partial = true;
+            lines.remove_prefix(length);
+        }
+        hold(lines);
+    }
+
+    // keeps whole lines while they fit the backlog limit
+    void SocketSink::hold(std::string_view lines)
+    {
+        if (m_backlog.size() + lines.size() <= m_options.backlog)
+        {
+            m_backlog.append(lines.data(), lines.size());
+            return;
+        }
+
+        while (!lines.empty())
+        {
+            std::size_t end = lines.find('\n');
+            std::size_t length = end == std::string_view::npos ? lines.size() : end + 1;
+            if (m_backlog.size() + length <= m_options.backlog)
+                m_backlog.append(lines.data(), length);
+            else
+                m_dropped++;
+            lines.remove_prefix(length);
+        }
+    }
+
+    void SocketSink::flush()
+    {
+        if (m_options.type == logcoe::SocketType::STREAM && !m_backlog.empty())
+            sendStream({});
+    }
+
+    void SocketSink::close()
+    {
+        if (m_fd < 0)
+            return;
+
+        flush();
+        ::close(m_fd);
+        m_fd = -1;
+    }
+
+    // One attempt with plain sends, the process dies next
+    void SocketSink::writeOnCrash(std::string_view lines)
+    {
+        if (m_fd < 0)
+            return;
+
+        if (m_options.type == logcoe::SocketType::STREAM)
+        {
+            if (!m_backlog.empty())
+                ::send(m_fd, m_backlog.data(), m_backlog.size(), sendFlags);
+            ::send(m_fd, lines.data(), lines.size(), sendFlags);
+            return;
+        }
+
+        while (!lines.empty())
+        {
+            const char *end = static_cast<const char *>(std::memchr(lines.data(), '\n', lines.size()));
+            std::size_t length = end ? static_cast<std::size_t>(end - lines.data()) : lines.size();
+            ::send(m_fd, lines.data(), length, sendFlags);
+            lines.remove_prefix(std::min(lines.size(), length + 1));
+        }
+    }
+#endif
+
+    std::shared_ptr<SharedRing> SharedRing::map(const std::string &name, int fd, std::size_t size)
+    {
+#ifdef _WIN32
+        static_cast<void>(name);
+        static_cast<void>(fd);
+        static_cast<void>(size);
+        return nullptr;
+#else
+        void *memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (memory == MAP_FAILED)
+            return nullptr;
+
+        std::shared_ptr<SharedRing> ring(new SharedRing);
+        ring->m_name = name;
+        ring->m_header = static_cast<SharedRingHeader *>(memory);
+        ring->m_data = static_cast<char *>(memory) + sizeof(SharedRingHeader);
+        ring->m_mapped = size;
+        return ring;
+#endif
+    }
+
+    std::shared_ptr<SharedRing> SharedRing::create(const std::string &name, const logcoe::SharedLogOptions &options)
+    {
+#ifdef _WIN32
+        static_cast<void>(name);
+        static_cast<void>(options);
+        return nullptr;
+#else
+        std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        std::size_t capacity = std::max(page, (options.capacity + page - 1) / page * page);
+        std::size_t size = sizeof(SharedRingHeader) + capacity;
+
+        // a ring left behind by a collector that did not stop is replaced, its workers attach to the new one
+        ::shm_unlink(name.c_str());
+        int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd < 0)
+            return nullptr;
+        if (::fchmod(fd, static_cast<mode_t>(options.permissions)) != 0 ||
+            ::ftruncate(fd, static_cast<off_t>(size)) != 0)
+        {
+            ::close(fd);
+            ::shm_unlink(name.c_str());
+            return nullptr;
+        }
+
+        std::shared_ptr<SharedRing> ring = map(name, fd, size);
+        if (!ring)
+        {
+            ::shm_unlink(name.c_str());
+            return nullptr;
+        }
+
+        // the new object is zero filled, which is every position and record starting out empty
+        ring->m_owner = ::getpid();
+        ring->m_header->version = SharedRingHeader::currentVersion;
+        ring->m_header->capacity = capacity;
+        ring->m_header->magic.store(SharedRingHeader::magicValue, std::memory_order_release);
+        return ring;
+#endif
+    }
+
+    std::shared_ptr<SharedRing> SharedRing::open(const std::string &name)
+    {
+#ifdef _WIN32
+        static_cast<void>(name);
+        return nullptr;
+#else
+        int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0)
+            return nullptr;
+
+        struct stat status{};
+        if (::fstat(fd, &status) != 0 || static_cast<std::size_t>(status.st_size) <= sizeof(SharedRingHeader))
+        {
+            ::close(fd);
+            return nullptr;
+        }
+
+        std::size_t size = static_cast<std::size_t>(status.st_size);
+        std::shared_ptr<SharedRing> ring = map(name, fd, size);
+        if (!ring)
+            return nullptr;
+
+        const SharedRingHeader &header = *ring->m_header;
+        if (header.magic.load(std::memory_order_acquire) != SharedRingHeader::magicValue ||
+            header.version != SharedRingHeader::currentVersion || header.capacity == 0 ||
+            header.capacity % sizeof(SharedRecord) != 0 || header.capacity > size - sizeof(SharedRingHeader))
+            return nullptr;
+        return ring;
+#endif
+    }
+
+    SharedRing::~SharedRing()
+    {
+#ifndef _WIN32
+        ::munmap(m_header, m_mapped);
+        // a forked child holds the collector's ring as well, only the collector itself removes it
+        if (m_owner == ::getpid())
+            ::shm_unlink(m_name.c_str());
+#endif
+    }
+
+    // padding is the room left before the end of the ring when the record does not fit in it. The claim is stored
+    // before head moves, so a worker killed at any point leaves either nothing or a claim the collector can skip.
+    bool SharedRing::reserve(std::uint64_t claim, std::uint64_t size, std::uint64_t &position, std::uint64_t &padding)
+    {
+        std::uint64_t capacity = m_header->capacity;
+        position = m_header->head.load(std::memory_order_acquire);
+        for (;;)
+        {
+            padding = paddingAt(position, size);
+            std::uint64_t tail = m_header->tail.load(std::memory_order_acquire);
+            if (position < tail)
+            {
+                // read long ago, head has moved past it and the collector too
+                position = m_header->head.load(std::memory_order_acquire);
+                continue;
+            }
+            if (position + padding + size - tail > capacity)
+                return false;
+
+            std::uint64_t found = lapAt(position);
+            if (recordAt(position).claim.compare_exchange_strong(found, claim | (padding + size),
+                                                                 std::memory_order_acq_rel))
+            {
+                // a worker that found the claim may have moved head already
+                std::uint64_t expected = position;
+                m_header->head.compare_exchange_strong(expected, position + padding + size,
+                                                       std::memory_order_acq_rel);
+                return true;
+            }
+
+            // another worker claimed this position but has not moved head past it yet, and may never if it was
+            // killed, so move it for them. Any other value means position is stale, head moved on meanwhile.
+            std::uint64_t expected = position;
+            if (found >= SharedRecord::firstClaim &&
+                m_header->head.compare_exchange_strong(expected, position + (found & 0xffffffffu),
+                                                       std::memory_order_acq_rel))
+                position += found & 0xffffffffu;
+            else
+                position = m_header->head.load(std::memory_order_acquire);
+        }
+    }
+
+    void SharedRing::write(const LineChunk &chunk, bool flush)
+    {
+#ifdef _WIN32
+        std::uint64_t owner = SharedRecord::firstClaim;
+#else
+        std::uint64_t owner = static_cast<std::uint64_t>(::getpid()) << 32;
+#endif
+        std::size_t begin = 0;
+        bool written = false;
+        for (std::size_t i = 0; i < chunk.lines.size(); ++i)
+        {
+            const LineMark &mark = chunk.lines[i];
+            std::size_t length = mark.end - 1 - begin;
+            const char *line = chunk.text.data() + begin;
+            begin = mark.end;
+
+            std::uint64_t size = (sizeof(SharedRecord) + length + 15) & ~std::uint64_t{15};
+            std::uint64_t position = 0;
+            std::uint64_t padding = 0;
+            if (size > m_header->capacity / 2 || !reserve(owner, size, position, padding))
+            {
+                m_header->dropped.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+
+            SharedRecord &record = recordAt(position + padding);
+            record.length = static_cast<std::uint32_t>(length);
+            std::memcpy(reinterpret_cast<char *>(&record) + sizeof(SharedRecord), line, length);
+            std::uint32_t flushed = flush && i + 1 == chunk.lines.size() ? SharedRecord::flushState : 0;
+            record.state.store(SharedRecord::publishedState | flushed | static_cast<std::uint32_t>(mark.level),
+                               std::memory_order_release);
+            written = true;
+        }
+
+        // pairs with the fence in wait(): either the collector sees the record or this sees it sleeping
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (written && m_header->sleeping.load(std::memory_order_relaxed) != 0)
+            wake();
+    }
+
+    bool SharedRing::published(std::uint64_t position)
+    {
+        std::uint64_t claim = recordAt(position).claim.load(std::memory_order_acquire);
+        if (claim < SharedRecord::firstClaim)
+            return false;
+        std::uint64_t size = claim & 0xffffffffu;
+        return recordAt(position + paddingAt(position, size)).state.load(std::memory_order_acquire) != 0;
+    }
+
+    std::size_t SharedRing::read(LineChunk &chunk, bool &flush, std::size_t limit)
+    {
+        std::uint64_t position = m_header->tail.load(std::memory_order_relaxed);
+        std::size_t count = 0;
+        while (chunk.text.size() < limit)
+        {
+            std::uint64_t claim = recordAt(position).claim.load(std::memory_order_acquire);
+            if (claim < SharedRecord::firstClaim)
+                break;
+
+            std::uint64_t size = claim & 0xffffffffu;
+            std::uint64_t padding = paddingAt(position, size);
+            SharedRecord &record = recordAt(position + padding);
+            std::uint32_t state = record.state.load(std::memory_order_acquire);
+            if (state != 0)
+            {
+                std::size_t length = std::min<std::size_t>(record.length, size - padding - sizeof(SharedRecord));
+                int level = std::min<int>(state & 0xff, static_cast<int>(LogLevel::ERROR));
+                chunk.append(std::string_view(reinterpret_cast<const char *>(&record) + sizeof(SharedRecord), length),
+                             static_cast<LogLevel>(level));
+                flush = flush || (state & SharedRecord::flushState) != 0;
+            }
+            else
+            {
+#ifndef _WIN32
+                // still being written, unless its worker is gone and never will
+                pid_t owner = static_cast<pid_t>(claim >> 32);
+                if (::kill(owner, 0) == 0 || errno != ESRCH)
+                    break;
+#endif
+                m_abandoned++;
+            }
+
+            if (padding != 0)
+                release(position, padding, lapAt(position) + 1);
+            release(position + padding, size - padding, lapAt(position + padding) + 1);
+            position += size;
+            count++;
+        }
+
+        m_header->tail.store(position, std::memory_order_release);
+        return count;
+    }
+
+    // The bytes from position on, which stay within one lap, become free for `lap`
+    void SharedRing::release(std::uint64_t position, std::uint64_t size, std::uint64_t lap)
+    {
+        for (std::uint64_t offset = 0; offset < size; offset += sizeof(SharedRecord))
+        {
+            SharedRecord &unit = recordAt(position + offset);
+            unit.claim.store(lap, std::memory_order_relaxed);
+            unit.state.store(0, std::memory_order_relaxed);
+            unit.length = 0;
+        }
+    }
+
+    void SharedRing::wait(std::chrono::milliseconds timeout)
+    {
+        m_header->sleeping.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!published(m_header->tail.load(std::memory_order_relaxed)))
+        {
+#ifdef __linux__
+            timespec time{};
+            time.tv_sec = static_cast<time_t>(timeout.count() / 1000);
+            time.tv_nsec = static_cast<long>(timeout.count() % 1000 * 1000000);
+            ::syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&m_header->sleeping), FUTEX_WAIT, 1, &time,
+                      nullptr, 0);
+#else
+            std::this_thread::sleep_for(std::min(timeout, std::chrono::milliseconds(1)));
+#endif
+        }
+        m_header->sleeping.store(0, std::memory_order_relaxed);
+    }
+
+    void SharedRing::wake()
+    {
+        m_header->sleeping.store(0, std::memory_order_relaxed);
+#ifdef __linux__
+        ::syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&m_header->sleeping), FUTEX_WAKE, 1, nullptr, nullptr,
+                  0);
+#endif
+    }
+
+    RotatingFileSink::RotatingFileSink(std::string filename, const RotationOptions &rotation)
+        : m_filename(std::move(filename)), m_rotation(rotation)
+    {
+        // unbuffered, the logger's own buffers batch the writes and the crash handler can append to the file
+        m_stream.rdbuf()->pubsetbuf(nullptr, 0);
+        m_stream.open(m_filename);
+        scheduleRotation();
+    }
+
+    void RotatingFileSink::setRotation(const RotationOptions &rotation)
+    {
+        m_rotation = rotation;
+        scheduleRotation();
+    }
+
+    // interval rotations happen on multiples of the interval since the epoch, e.g. on the hour for 3600s
+    void RotatingFileSink::scheduleRotation()
+    {
+        if (m_rotation.interval.count() <= 0)
+            return;
+
+        auto now = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch());
+        m_nextRotation = std::chrono::system_clock::time_point(now - now % m_rotation.interval + m_rotation.interval);
+    }
+
+    void RotatingFileSink::write(std::string_view lines)
+    {
+        bool sizeReached = m_rotation.maxBytes > 0 && m_bytes > 0 && m_bytes + lines.size() > m_rotation.maxBytes;
+        bool intervalReached = m_rotation.interval.count() > 0 && std::chrono::system_clock::now() >= m_nextRotation;
+        if (sizeReached || intervalReached)
+        {
+            if (m_bytes == 0)
+                scheduleRotation();
+            else
+                rotate();
+        }
+
+        if (!m_stream.is_open())
+            return;
+
+        m_stream.write(lines.data(), static_cast<std::streamsize>(lines.size()));
+        m_bytes += lines.size();
+    }
+
+    void RotatingFileSink::flush()
+    {
+        if (m_stream.is_open())
+            m_stream.flush();
+    }
+
+    // the stream has no buffer of its own, so appending through a second descriptor keeps the lines in order
+    void RotatingFileSink::writeOnCrash(std::string_view lines)
+    {
+#ifdef _WIN32
+        int fd = _open(m_filename.c_str(), _O_WRONLY | _O_APPEND | _O_BINARY);
+        if (fd < 0)
+            return;
+        writeAll(fd, lines);
+        _close(fd);
+#else
+        int fd = ::open(m_filename.c_str(), O_WRONLY | O_APPEND);
+        if (fd < 0)
+            return;
+        writeAll(fd, lines);
+        ::close(fd);
+#endif
+    }
+
+    // Only a close, a rename and an open happen on the logging thread, compression and pruning are queued.
+    // Errors are reported in the reopened file, this runs under the sink's lock and cannot reach the other outputs.
+    void RotatingFileSink::rotate()
+    {
+        m_stream.close();
+
+        std::filesystem::path active(m_filename);
+        std::string stamp = TimestampFormatter::formatUncached(std::chrono::system_clock::now(), "%Y%m%d-%H%M%S");
+        std::filesystem::path rotated;
+        for (int sequence = 0; sequence < 1000; ++sequence)
+        {
+            char suffix[8];
+            std::snprintf(suffix, sizeof(suffix), ".%03d", sequence);
+            rotated = active.parent_path() /
+                      (active.stem().string() + "." + stamp + suffix + active.extension().string());
+            if (!std::filesystem::exists(rotated) && !std::filesystem::exists(rotated.string() + ".gz") &&
+                !std::filesystem::exists(rotated.string() + ".zst"))
+                break;
+        }
+
+        std::error_code error;
+        std::filesystem::rename(active, rotated, error);
+
+        m_stream.open(m_filename, error ? std::ios::app : std::ios::trunc);
+        m_bytes = 0;
+        scheduleRotation();
+        if (!m_stream.is_open())
+            return;
+
+        if (error)
+            m_stream << "[logcoe] ERROR: Failed to rotate log file " << m_filename << ": " << error.message() << '\n';
+        else
+            FileArchiver::submit(ArchiveJob{rotated.string(), m_filename, m_rotation.compression, m_rotation.maxFiles});
+    }
+
+    unsigned int LoggerImpl::s_initCounter = 0;
+    LogLevel LoggerImpl::s_logLevel = LogLevel::INFO;
+    std::string LoggerImpl::s_defaultSource = "";
+    std::mutex LoggerImpl::s_mutex;
+    std::string LoggerImpl::s_filename = "logcoe.log";
+    TimestampFormatter LoggerImpl::s_timestampFormatter("%d/%m/%Y__%H:%M:%S");
+    std::string LoggerImpl::s_lineBuffer;
+    LineChunk LoggerImpl::s_messageChunk;
+    RotationOptions LoggerImpl::s_rotation;
+    FlushPolicy LoggerImpl::s_flushPolicy;
+    std::atomic<OutputFormat> LoggerImpl::s_outputFormat{OutputFormat::TEXT};
+    std::shared_ptr<const Layout> LoggerImpl::s_layout;
+
+    std::vector<std::shared_ptr<SinkSlot>> LoggerImpl::s_sinks;
+    std::shared_ptr<SinkSlot> LoggerImpl::s_consoleSlot;
+    std::shared_ptr<SinkSlot> LoggerImpl::s_fileSlot;
+    logcoe::SinkId LoggerImpl::s_nextSinkId = 1;
+
+    std::unique_ptr<RecordQueue> LoggerImpl::s_queue;
+    OverflowPolicy LoggerImpl::s_overflowPolicy = OverflowPolicy::BLOCK;
+    std::thread LoggerImpl::s_worker;
+    std::mutex LoggerImpl::s_workerMutex;
+    std::condition_variable LoggerImpl::s_workerCondition;
+    std::condition_variable LoggerImpl::s_progressCondition;
+    std::atomic<bool> LoggerImpl::s_asyncEnabled{false};
+    std::atomic<std::uint32_t> LoggerImpl::s_producers{0};
+    std::atomic<bool> LoggerImpl::s_workerStop{false};
+    std::atomic<bool> LoggerImpl::s_workerSleeping{false};
+    std::atomic<std::uint64_t> LoggerImpl::s_enqueuedCount{0};
+    std::atomic<std::uint64_t> LoggerImpl::s_completedCount{0};
+    std::atomic<std::uint64_t> LoggerImpl::s_droppedCount{0};
+
+    std::mutex LoggerImpl::s_stagingMutex;
+    std::vector<std::shared_ptr<StagingBuffer>> LoggerImpl::s_stagingBuffers;
+    std::atomic<std::uint64_t> LoggerImpl::s_configVersion{0};
+    std::atomic<const ConfigSnapshot *> LoggerImpl::s_config{nullptr};
+    std::atomic<std::uint64_t> LoggerImpl::s_configEpoch{1};
+    std::vector<std::pair<const ConfigSnapshot *, std::uint64_t>> LoggerImpl::s_retiredConfigs;
+
+    // Pins the current ConfigSnapshot for its lifetime, nested readers on one thread share the outer one. A reader
+    // announces the epoch it started in, then loads the snapshot; a replaced snapshot is freed only once every
+    // announced epoch is at least the one it was retired in. After the thread's lease is gone it reads under s_mutex.
+    struct LoggerImpl::ConfigReader
+    {
+        const ConfigSnapshot *config;
+
+        ConfigReader()
+        {
+            ConfigReaderState &state = t_configReader;
+            if (state.depth++ > 0)
+            {
+                config = state.config;
+                return;
+            }
+
+            if (!state.slot && !state.released)
+            {
+                state.slot = epochSlots().lease();
+                thread_local EpochLease lease;
+            }
+
+            if (state.slot)
+            {
+                state.slot->epoch.store(s_configEpoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+                state.config = s_config.load(std::memory_order_seq_cst);
+            }
+            else
+            {
+                s_mutex.lock();
+                state.locked = true;
+                state.config = s_config.load(std::memory_order_relaxed);
+            }
+            config = state.config;
+        }
+
+        ~ConfigReader()
+        {
+            ConfigReaderState &state = t_configReader;
+            if (--state.depth > 0)
+                return;
+
+            if (state.locked)
+            {
+                state.locked = false;
+                s_mutex.unlock();
+            }
+            else
+                state.slot->epoch.store(0, std::memory_order_release);
+        }
+
+        ConfigReader(const ConfigReader &) = delete;
+        ConfigReader &operator=(const ConfigReader &) = delete;
+
+        bool active() const { return config && config->initialized; }
+    };
+
+    std::thread LoggerImpl::s_flushThread;
+    std::mutex LoggerImpl::s_flushMutex;
+    std::condition_variable LoggerImpl::s_flushCondition;
+    std::chrono::milliseconds LoggerImpl::s_flushInterval{0};
+    bool LoggerImpl::s_flushStop = false;
+
+    std::thread LoggerImpl::s_reportThread;
+    std::mutex LoggerImpl::s_reportMutex;
+    std::condition_variable LoggerImpl::s_reportCondition;
+    std::chrono::milliseconds LoggerImpl::s_reportInterval{0};
+    logcoe::SinkId LoggerImpl::s_reportSink = 0;
+    bool LoggerImpl::s_reportStop = false;
+
+    bool LoggerImpl::s_crashHandler = false;
+    logcoe::FlightRecorderOptions LoggerImpl::s_recorder{LogLevel::DEBUG, 0, LogLevel::NONE};
+    std::atomic<std::size_t> LoggerImpl::s_recorderCapacity{0};
+    std::atomic<LogLevel> LoggerImpl::s_recorderTrigger{LogLevel::NONE};
+    std::atomic<std::uint64_t> LoggerImpl::s_recorderGeneration{0};
+    std::atomic<bool> LoggerImpl::s_crashing{false};
+    std::shared_ptr<SharedRing> LoggerImpl::s_sharedOutput;
+    std::shared_ptr<SharedRing> LoggerImpl::s_collectorRing;
+    std::thread LoggerImpl::s_collectorThread;
+    std::mutex LoggerImpl::s_collectorMutex;
+    std::atomic<bool> LoggerImpl::s_collectorStop{false};
+    std::terminate_handler LoggerImpl::s_previousTerminate = nullptr;
+    std::mutex LoggerImpl::s_formatWarningsMutex;
+    std::unordered_set<std::string> LoggerImpl::s_formatWarnings;
+#ifdef _WIN32
+    void (*LoggerImpl::s_previousSignalHandlers[std::size(crashSignals)])(int) = {};
+#else
+    struct sigaction LoggerImpl::s_previousSignalActions[std::size(crashSignals)];
+#endif
+
+    // Formatting state private to one logging thread, refreshed from the shared configuration when it changes
+    struct LoggerImpl::StagingThread
+    {
+        std::shared_ptr<StagingBuffer> buffer = std::make_shared<StagingBuffer>();
+        TimestampFormatter timestamps{""};
+        std::string defaultSource;
+        LogLevel flushLevel = LogLevel::WARNING;
+        OutputFormat format = OutputFormat::TEXT;
+        std::shared_ptr<const Layout> layout;
+        std::uint64_t configVersion = ~std::uint64_t{0};
+        std::string line;
+
+        StagingThread()
+        {
+            buffer->chunk.text.reserve(stagingCapacity);
+            std::lock_guard<std::mutex> lock(s_stagingMutex);
+            s_stagingBuffers.push_back(buffer);
+        }
+
+        ~StagingThread()
+        {
+            {
+                std::lock_guard<std::mutex> lock(buffer->mutex);
+                if (!buffer->chunk.empty())
+                    publishStaged(*buffer, true);
+            }
+
+            std::lock_guard<std::mutex> lock(s_stagingMutex);
+            s_stagingBuffers.erase(std::find(s_stagingBuffers.begin(), s_stagingBuffers.end(), buffer));
+        }
+    };
+
+    std::string LoggerImpl::formatTimestamp(std::chrono::system_clock::time_point time)
+    {
+        return s_timestampFormatter.format(time);
+    }
+
+    std::string LoggerImpl::getCurrentTimestamp()
+    {
+        if(s_initCounter == 0) return "";
+
+        return formatTimestamp(std::chrono::system_clock::now());
+    }
+
+    std::string LoggerImpl::getLogLevelAsString(LogLevel level)
+    {
+        if(s_initCounter == 0) return "";
+
+        return levelName(level);
+    }
+
+    void LoggerImpl::writeToOutputs(const std::string &formattedMessage, LogLevel level, bool flush)
+    {
+        if (s_initCounter == 0 || static_cast<int>(level) < static_cast<int>(s_logLevel))
+            return;
+
+        // the logger's own messages carry no timestamp, but structured outputs still get one record per line
+        OutputFormat format = s_outputFormat.load(std::memory_order_relaxed);
+        std::string_view line = formattedMessage;
+        if (format != OutputFormat::TEXT)
+        {
+            bool json = format == OutputFormat::JSON;
+            s_lineBuffer.assign(json ? "{\"level\":\"" : "level=");
+            s_lineBuffer += levelName(level);
+            s_lineBuffer += json ? "\",\"message\":" : " msg=";
+            if (json)
+                appendJsonString(s_lineBuffer, formattedMessage);
+            else
+                appendLogfmtValue(s_lineBuffer, formattedMessage);
+            endLine(s_lineBuffer, format);
+            line = s_lineBuffer;
+        }
+
+        s_messageChunk.clear();
+        s_messageChunk.append(line, level);
+        dispatchLocked(s_messageChunk, flush);
+    }
+
+    void LoggerImpl::flushOutputs()
+    {
+        if(s_initCounter == 0) return;
+        for (const auto &slot : s_sinks)
+            slot->flush();
+    }
+
+    // A requested level raised to the lowest sink level, so records no sink accepts are never formatted
+    LogLevel LoggerImpl::outputThreshold(LogLevel level)
+    {
+        if (s_initCounter == 0)
+            return LogLevel::NONE;
+        if (s_sinks.empty() || s_sharedOutput)
+            return level;
+
+        LogLevel lowestSink = LogLevel::NONE;
+        for (const auto &slot : s_sinks)
+            lowestSink = std::min(lowestSink, slot->options.level);
+        return std::max(level, lowestSink);
+    }
+
+    // While the flight recorder is on, records from its level up pass the call site and are recorded below output
+    LogLevel LoggerImpl::recorderThreshold(LogLevel output)
+    {
+        if (s_initCounter == 0 || s_recorder.records == 0)
+            return output;
+        return std::min(output, s_recorder.level);
+    }
+
+    // The call-site gates and output levels: the global ones and one pair per interned source
+    void LoggerImpl::publishActiveLevel()
+    {
+        publishConfig();
+
+        LogLevel level = outputThreshold(s_logLevel);
+        logcoe::detail::outputLevel.store(level, std::memory_order_relaxed);
+        logcoe::detail::activeLevel.store(recorderThreshold(level), std::memory_order_relaxed);
+
+        SourceRegistry &registry = sourceRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (const auto &source : registry.sources)
+        {
+            LogLevel output = source->overridden ? outputThreshold(source->level) : level;
+            source->output.store(output, std::memory_order_relaxed);
+            source->threshold.store(recorderThreshold(output), std::memory_order_relaxed);
+        }
+    }
+
+    // Called with s_mutex held after any change a logging thread reads, the replaced snapshot is retired
+    void LoggerImpl::publishConfig()
+    {
+        auto config = std::make_unique<ConfigSnapshot>();
+        config->version = s_configVersion.load(std::memory_order_relaxed) + 1;
+        config->initialized = s_initCounter > 0;
+        config->level = s_logLevel;
+        config->defaultSource = s_defaultSource;
+        config->timeFormat = s_timestampFormatter.pattern();
+        config->precision = s_timestampFormatter.precision();
+        config->format = s_outputFormat.load(std::memory_order_relaxed);
+        config->layout = s_layout;
+        config->flushLevel = s_flushPolicy.level;
+        config->sinks = s_sinks;
+        config->shared = s_sharedOutput;
+
+        const ConfigSnapshot *previous = s_config.exchange(config.release(), std::memory_order_seq_cst);
+        std::uint64_t retired = s_configEpoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+        s_configVersion.fetch_add(1, std::memory_order_release);
+
+        if (previous)
+            s_retiredConfigs.emplace_back(previous, retired);
+        reclaimConfigs();
+    }
+
+    // A snapshot retired in epoch R is unreachable once every thread either reads nothing or entered at R or later
+    void LoggerImpl::reclaimConfigs()
+    {
+        if (s_retiredConfigs.empty())
+            return;
+
+        std::uint64_t oldest = ~std::uint64_t{0};
+        {
+            LeasePool<EpochSlot> &slots = epochSlots();
+            std::lock_guard<std::mutex> lock(slots.mutex);
+            for (const auto &slot : slots.items)
+            {
+                std::uint64_t epoch = slot->epoch.load(std::memory_order_seq_cst);
+                if (epoch != 0)
+                    oldest = std::min(oldest, epoch);
+            }
+        }
+
+        auto reclaimable = [oldest](const std::pair<const ConfigSnapshot *, std::uint64_t> &retired) {
+            return retired.second <= oldest;
+        };
+        for (const auto &retired : s_retiredConfigs)
+        {
+            if (reclaimable(retired))
+                delete retired.first;
+        }
+        s_retiredConfigs.erase(std::remove_if(s_retiredConfigs.begin(), s_retiredConfigs.end(), reclaimable),
+                               s_retiredConfigs.end());
+    }
+
+    void LoggerImpl::attachSink(const std::shared_ptr<SinkSlot> &slot)
+    {
+        s_sinks.push_back(slot);
+        publishActiveLevel();
+    }
+
+    void LoggerImpl::detachSink(std::shared_ptr<SinkSlot> &slot)
+    {
+        if (!slot)
+            return;
+
+        slot->close();
+        s_sinks.erase(std::remove(s_sinks.begin(), s_sinks.end(), slot), s_sinks.end());
+        slot.reset();
+        publishActiveLevel();
+    }
+
+    // the built-in outputs buffer and flush according to setFlushPolicy(), user sinks keep their own SinkOptions
+    void LoggerImpl::applyFlushPolicy(SinkSlot &slot)
+    {
+        slot.options.bufferSize = s_flushPolicy.bytes;
+        slot.options.flushLevel = s_flushPolicy.level;
+    }
+
+    void LoggerImpl::attachConsole(std::ostream &stream)
+    {
+        s_consoleSlot = std::make_shared<SinkSlot>();
+        s_consoleSlot->name = "console";
+        s_consoleSlot->sink = std::make_shared<StreamSink>(stream);
+        applyFlushPolicy(*s_consoleSlot);
+        attachSink(s_consoleSlot);
+    }
+
+    bool LoggerImpl::openFileOutput()
+    {
+        auto file = std::make_shared<RotatingFileSink>(s_filename, s_rotation);
+        if (!file->isOpen())
+        {
+            writeToOutputs("[logcoe] ERROR: Failed to open log file: " + s_filename);
+            return false;
+        }
+
+        s_fileSlot = std::make_shared<SinkSlot>();
+        s_fileSlot->name = "file";
+        s_fileSlot->sink = std::move(file);
+        applyFlushPolicy(*s_fileSlot);
+        attachSink(s_fileSlot);
+        return true;
+    }
+
+    // Reads the sink list from the current snapshot without s_mutex, the writes happen under each sink's own lock.
+    // A worker's lines go to the shared ring instead, local writes the collected ones to this process's sinks.
+    void LoggerImpl::dispatch(const LineChunk &chunk, bool flush, bool local)
+    {
+        ConfigReader reader;
+        if (!reader.active())
+            return;
+        if (reader.config->shared && !local)
+            return reader.config->shared->write(chunk, flush);
+
+        const std::vector<std::shared_ptr<SinkSlot>> &sinks = reader.config->sinks;
+        bool replaced = false;
+        for (const auto &slot : sinks)
+            replaced = !slot->write(chunk, flush) || replaced;
+
+        // an output was swapped while writing, give the chunk to the sinks that replaced it. The swap holds s_mutex
+        // until the new sink is attached, so this rare path waits for it
+        if (replaced)
+        {
+            std::vector<std::shared_ptr<SinkSlot>> current;
+            if (t_configReader.locked)
+                current = s_sinks;
+            else
+            {
+                TimedLock lock(s_mutex);
+                current = s_sinks;
+            }
+            for (const auto &slot : current)
+            {
+                if (std::find(sinks.begin(), sinks.end(), slot) == sinks.end())
+                    slot->write(chunk, flush);
+            }
+        }
+    }
+
+    void LoggerImpl::dispatchLocked(const LineChunk &chunk, bool flush)
+    {
+        if (s_sharedOutput)
+            return s_sharedOutput->write(chunk, flush);
+        for (const auto &slot : s_sinks)
+            slot->write(chunk, flush);
+    }
+
+    void LoggerImpl::log(LogLevel level, std::string_view message, std::string_view source, bool flush,
+                         const SourceLocation *location, const Field *fields, std::size_t fieldCount,
+                         const SourceState *interned)
+    {
+        // past the call-site gate but below the output only while the flight recorder keeps it
+        if (static_cast<int>(level) < static_cast<int>(outputLevel(interned)))
+            return recordRecent(level, message, false, nullptr, 0, source, location, fields, fieldCount, interned);
+        bool dump = static_cast<int>(level) >= static_cast<int>(s_recorderTrigger.load(std::memory_order_relaxed));
+
+        StatsShard &stats = statsShard();
+        LatencySample sample(stats);
+        if (static_cast<int>(level) < static_cast<int>(LogLevel::NONE))
+            bump(stats.accepted[static_cast<int>(level)]);
+
+        if (s_asyncEnabled.load(std::memory_order_acquire))
+        {
+            // counted until the push is done, stopWorker() waits for every producer that got past the check again
+            s_producers.fetch_add(1, std::memory_order_seq_cst);
+            bool queued = false;
+            if (s_asyncEnabled.load(std::memory_order_seq_cst))
+            {
+                // fields only reference the caller's values, so they are encoded before the call returns.
+                // An empty source is replaced by the default source on the writer thread, from its snapshot.
+                // The strings are assigned, not built, each push hands back a consumed record's storage.
+                thread_local LogRecord record = [] {
+                    LogRecord reserved;
+                    reserved.reserve();
+                    return reserved;
+                }();
+                record.level = level;
+                record.time = std::chrono::system_clock::now();
+                record.source.assign(source);
+                record.message.assign(message);
+                record.flush = flush;
+                record.location = location;
+                record.fields.clear();
+                record.interned = interned;
+                record.thread = threadNumber();
+                record.dump = dump;
+                appendFields(record.fields, s_outputFormat.load(std::memory_order_relaxed), fields, fieldCount);
+                queued = enqueue(record);
+            }
+            s_producers.fetch_sub(1, std::memory_order_release);
+            if (queued)
+                return;
+        }
+
+        if (dump)
+        {
+            // what this and other threads staged goes out before the history
+            drainStaging();
+            dumpRecorded(level, std::chrono::system_clock::time_point::max());
+        }
+
+        StagingThread &staging = stagingThread();
+        if (staging.configVersion != s_configVersion.load(std::memory_order_acquire))
+            refreshStaging(staging);
+
+        std::string_view recordSource = interned || location || !source.empty() ? source : staging.defaultSource;
+        beginLine(staging.line, staging.timestamps, staging.format, level, std::chrono::system_clock::now(),
+                  recordSource, location, message, interned, staging.layout.get(), threadNumber());
+        appendFields(staging.line, staging.format, fields, fieldCount);
+        endLine(staging.line, staging.format);
+
+        StagingBuffer &buffer = *staging.buffer;
+        TimedLock lock(buffer.mutex);
+        buffer.chunk.append(staging.line, level);
+
+        // records at the flush policy level are written right away so they are not lost in a partially filled buffer
+        if (flush || static_cast<int>(level) >= static_cast<int>(staging.flushLevel) ||
+            buffer.chunk.text.size() >= stagingCapacity)
+            publishStaged(buffer, flush);
+    }
+
+    LoggerImpl::StagingThread &LoggerImpl::stagingThread()
+    {
+        thread_local StagingThread staging;
+        return staging;
+    }
+
+    void LoggerImpl::refreshStaging(StagingThread &staging)
+    {
+        ConfigReader reader;
+        if (!reader.config)
+            return;
+
+        const ConfigSnapshot &config = *reader.config;
+        staging.timestamps.setFormat(config.timeFormat, config.precision);
+        staging.defaultSource = config.defaultSource;
+        staging.flushLevel = config.flushLevel;
+        staging.format = config.format;
+        staging.layout = config.layout;
+        staging.configVersion = config.version;
+    }
+
+    // Called with buffer.mutex held, which keeps the chunks of one thread in order
+    void LoggerImpl::publishStaged(StagingBuffer &buffer, bool flush)
+    {
+        dispatch(buffer.chunk, flush);
+        buffer.chunk.clear();
+    }
+
+    void LoggerImpl::drainStaging()
+    {
+        std::vector<std::shared_ptr<StagingBuffer>> buffers;
+        {
+            std::lock_guard<std::mutex> lock(s_stagingMutex);
+            buffers = s_stagingBuffers;
+        }
+
+        for (auto &buffer : buffers)
+        {
+            TimedLock lock(buffer->mutex);
+            if (!buffer->chunk.empty())
+                publishStaged(*buffer, false);
+        }
+    }
+
+    // False only when the writer stops while a BLOCK producer waits for room, the caller then writes synchronously
+    bool LoggerImpl::enqueue(LogRecord &record)
+    {
+        switch (s_overflowPolicy)
+        {
+        case OverflowPolicy::DROP_NEWEST:
+            if (!s_queue->tryPush(record))
+            {
+                s_droppedCount.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+            break;
+        case OverflowPolicy::DROP_OLDEST:
+            while (!s_queue->tryPush(record))
+            {
+                thread_local LogRecord evicted;
+                if (s_queue->tryPop(evicted))
+                {
+                    s_droppedCount.fetch_add(1, std::memory_order_relaxed);
+                    s_completedCount.fetch_add(1, std::memory_order_release);
+                }
+            }
+            break;
+        default:
+            while (!s_queue->tryPush(record))
+            {
+                if (s_workerStop.load(std::memory_order_acquire))
+                    return false;
+                wakeWorker();
+                std::unique_lock<std::mutex> lock(s_workerMutex);
+                s_progressCondition.wait_for(lock, std::chrono::milliseconds(1));
+            }
+            break;
+        }
+
+        s_enqueuedCount.fetch_add(1, std::memory_order_release);
+
+        // pairs with the fence in workerLoop() so a sleeping writer is never missed
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (s_workerSleeping.load(std::memory_order_relaxed))
+            wakeWorker();
+        return true;
+    }
+
+    void LoggerImpl::wakeWorker()
+    {
+        {
+            std::lock_guard<std::mutex> lock(s_workerMutex);
+        }
+        s_workerCondition.notify_one();
+    }
+
+    // Formats with the writer thread's own timestamp cache and line buffer, configured from the current snapshot
+    void LoggerImpl::writeRecords(const LogRecord *records, std::size_t count)
+    {
+        // sized for a full batch up front, a batch larger than any before must not allocate mid-stream
+        thread_local LineChunk chunk = [] {
+            LineChunk reserved;
+            reserved.text.reserve(stagingCapacity);
+            reserved.lines.reserve(maxBatchSize);
+            return reserved;
+        }();
+        thread_local TimestampFormatter timestamps{""};
+        thread_local std::string line;
+        thread_local std::uint64_t version = ~std::uint64_t{0};
+        std::size_t i = 0;
+        while (i < count)
+        {
+            // a record that triggers the flight recorder follows its history, which goes out with no lock held
+            if (records[i].dump)
+                dumpRecorded(records[i].level, records[i].time);
+
+            bool flush = false;
+            {
+                ConfigReader reader;
+                if (!reader.config)
+                    return;
+
+                const ConfigSnapshot &config = *reader.config;
+                if (version != config.version)
+                {
+                    timestamps.setFormat(config.timeFormat, config.precision);
+                    version = config.version;
+                }
+
+                for (std::size_t first = i; i < count && (i == first || !records[i].dump); ++i)
+                {
+                    const LogRecord &record = records[i];
+                    LogLevel threshold = record.interned ? record.interned->output.load(std::memory_order_relaxed)
+                                                         : config.level;
+                    if (static_cast<int>(record.level) < static_cast<int>(threshold))
+                    {
+                        if (static_cast<int>(record.level) < static_cast<int>(LogLevel::NONE))
+                            bump(statsShard().filtered[static_cast<int>(record.level)]);
+                        continue;
+                    }
+
+                    bool useDefault = !record.interned && !record.location && record.source.empty();
+                    formatLine(line, timestamps, config.format, record.level, record.time,
+                               useDefault ? config.defaultSource : record.source, record.location, record.message,
+                               record.fields, record.interned, config.layout.get(), record.thread);
+                    chunk.append(line, record.level);
+                    flush = flush || record.flush;
+                }
+            }
+
+            if (!chunk.empty())
+                dispatch(chunk, flush);
+            chunk.clear();
+        }
+    }
+
+    LogLevel LoggerImpl::outputLevel(const SourceState *interned)
+    {
+        return interned ? interned->output.load(std::memory_order_relaxed)
+                        : logcoe::detail::outputLevel.load(std::memory_order_relaxed);
+    }
+
+    bool LoggerImpl::recordFormatted(LogLevel level, const SourceLocation *location, std::string_view format,
+                                     const logcoe::detail::FormatArgument *arguments, std::size_t count,
+                                     const SourceState *interned)
+    {
+        if (static_cast<int>(level) >= static_cast<int>(outputLevel(interned)))
+            return false;
+        recordRecent(level, format, true, arguments, count, std::string_view(), location, nullptr, 0, interned);
+        return true;
+    }
+
+    // Copies the call into the next slot of this thread's ring: strings are assigned, arguments and fields encoded,
+    // nothing is formatted until a dump
+    void LoggerImpl::recordRecent(LogLevel level, std::string_view text, bool formatted,
+                                  const logcoe::detail::FormatArgument *arguments, std::size_t argumentCount,
+                                  std::string_view source, const SourceLocation *location, const Field *fields,
+                                  std::size_t fieldCount, const SourceState *interned)
+    {
+        StatsShard &stats = statsShard();
+        LatencySample sample(stats);
+        std::size_t capacity = s_recorderCapacity.load(std::memory_order_relaxed);
+        if (capacity == 0)
+            return;
+
+        FlightRing &ring = flightRing();
+        std::uint64_t generation = s_recorderGeneration.load(std::memory_order_acquire);
+        if (ring.generation != generation || ring.capacity != capacity)
+        {
+            // a dump still reading the old slots keeps them, this record is not kept
+            int idle = 0;
+            if (!ring.state.compare_exchange_strong(idle, -1, std::memory_order_acquire))
+                return;
+            ring.slots = std::make_unique<FlightSlot[]>(capacity);
+            for (std::size_t i = 0; i < capacity; ++i)
+            {
+                ring.slots[i].text.reserve(128);
+                ring.slots[i].arguments.reserve(64);
+            }
+            ring.capacity = capacity;
+            ring.generation = generation;
+            ring.state.store(0, std::memory_order_release);
+        }
+
+        // odd while a dump reads the record this one replaces, the owner does not wait for it
+        FlightSlot &slot = ring.slots[ring.written % ring.capacity];
+        std::uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+        if ((sequence & 1) != 0 ||
+            !slot.sequence.compare_exchange_strong(sequence, sequence | 1, std::memory_order_acquire))
+            return;
+
+        slot.level = level;
+        slot.time = std::chrono::system_clock::now();
+        slot.source.assign(source);
+        slot.text.assign(text);
+        slot.formatted = formatted;
+        slot.arguments.clear();
+        for (std::size_t i = 0; i < argumentCount; ++i)
+            arguments[i].encode(slot.arguments, arguments[i].value);
+        slot.argumentCount = argumentCount;
+        slot.fields.clear();
+        encodeFields(slot.fields, fields, fieldCount);
+        slot.fieldCount = fieldCount;
+        slot.location = location;
+        slot.interned = interned;
+        slot.thread = threadNumber();
+
+        slot.sequence.store(++ring.written * 2, std::memory_order_release);
+        bump(stats.recorded);
+    }
+
+    // Written as records at `level`, so every output that takes the triggering record takes its history too. Only
+    // records made before `until` go out, the writer thread dumps at the triggering record's place in the queue.
+    void LoggerImpl::dumpRecorded(LogLevel level, std::chrono::system_clock::time_point until)
+    {
+        struct ClaimedSlot
+        {
+            FlightRing *ring;
+            FlightSlot *slot;
+            std::uint64_t sequence;
+        };
+
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if (s_initCounter == 0)
+            return;
+
+        // claimed slots are formatted where they are and handed back afterwards, s_mutex keeps dumps apart
+        thread_local std::vector<FlightRing *> claimedRings;
+        thread_local std::vector<ClaimedSlot> claimed;
+        {
+            LeasePool<FlightRing> &rings = flightRings();
+            std::lock_guard<std::mutex> poolLock(rings.mutex);
+            std::uint64_t generation = s_recorderGeneration.load(std::memory_order_relaxed);
+            for (const auto &item : rings.items)
+            {
+                FlightRing &ring = *item;
+                int idle = 0;
+                if (!ring.state.compare_exchange_strong(idle, 1, std::memory_order_acquire))
+                    continue; // the owner is replacing slots of an older generation
+                claimedRings.push_back(&ring);
+                if (ring.generation != generation)
+                    continue;
+
+                for (std::size_t i = 0; i < ring.capacity; ++i)
+                {
+                    FlightSlot &slot = ring.slots[i];
+                    std::uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+                    if ((sequence & 1) != 0 || sequence / 2 <= ring.dumped ||
+                        !slot.sequence.compare_exchange_strong(sequence, sequence | 1, std::memory_order_acquire))
+                        continue;
+                    if (slot.time > until)
+                        slot.sequence.store(sequence, std::memory_order_release);
+                    else
+                        claimed.push_back(ClaimedSlot{&ring, &slot, sequence});
+                }
+            }
+        }
+
+        if (!claimed.empty())
+        {
+            // a thread's records are numbered in time order, a later one cannot be dumped before an earlier one
+            std::sort(claimed.begin(), claimed.end(), [](const ClaimedSlot &a, const ClaimedSlot &b) {
+                return a.slot->time != b.slot->time ? a.slot->time < b.slot->time : a.sequence < b.sequence;
+            });
+
+            writeToOutputs("[logcoe] Flight recorder: " + std::to_string(claimed.size()) + " recent records", level,
+                           false);
+
+            OutputFormat format = s_outputFormat.load(std::memory_order_relaxed);
+            thread_local LineChunk chunk;
+            thread_local std::string line;
+            thread_local std::string message;
+            thread_local std::string fieldText;
+            thread_local std::vector<Field> fields;
+            thread_local std::vector<DecodedArgument> decoded;
+            thread_local std::vector<logcoe::detail::FormatArgument> arguments;
+            for (const ClaimedSlot &claim : claimed)
+            {
+                const FlightSlot &slot = *claim.slot;
+                std::string_view text = slot.text;
+                const char *cursor = slot.arguments.data();
+                if (slot.formatted && decodeArguments(cursor, cursor + slot.arguments.size(), slot.argumentCount,
+                                                      decoded, arguments))
+                {
+                    message.clear();
+                    logcoe::detail::formatTo(message, slot.text, arguments.data(), arguments.size());
+                    text = message;
+                }
+
+                fieldText.clear();
+                if (decodeFields(slot.fields, slot.fieldCount, fields))
+                    appendFields(fieldText, format, fields.data(), fields.size());
+
+                bool useDefault = !slot.interned && !slot.location && slot.source.empty();
+                formatLine(line, s_timestampFormatter, format, slot.level, slot.time,
+                           useDefault ? s_defaultSource : slot.source, slot.location, text, fieldText, slot.interned,
+                           s_layout.get(), slot.thread);
+                chunk.append(line, level);
+
+                claim.slot->sequence.store(claim.sequence, std::memory_order_release);
+                claim.ring->dumped = std::max(claim.ring->dumped, claim.sequence / 2);
+            }
+            dispatchLocked(chunk, true);
+            chunk.clear();
+        }
+
+        for (FlightRing *ring : claimedRings)
+            ring->state.store(0, std::memory_order_release);
+        claimedRings.clear();
+        claimed.clear();
+    }
+
+    void LoggerImpl::setFlightRecorder(const logcoe::FlightRecorderOptions &options)
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if (s_initCounter == 0)
+            return;
+
+        s_recorder = options;
+        // every ring starts over at its owner's next record
+        s_recorderGeneration.fetch_add(1, std::memory_order_release);
+        s_recorderCapacity.store(options.records, std::memory_order_relaxed);
+        s_recorderTrigger.store(options.records > 0 ? options.trigger : LogLevel::NONE, std::memory_order_relaxed);
+        publishActiveLevel();
+    }
+
+    void LoggerImpl::dumpRecent()
+    {
+        // what was written before the recorded records goes out first
+        drainQueue();
+        drainStaging();
+        dumpRecorded(LogLevel::ERROR, std::chrono::system_clock::time_point::max());
+    }
+
+    bool LoggerImpl::startCollector(const std::string &name, const logcoe::SharedLogOptions &options)
+    {
+        stopCollector();
+
+        std::shared_ptr<SharedRing> ring = SharedRing::create(name, options);
+        {
+            std::lock_guard<std::mutex> lock(s_mutex);
+            if (s_initCounter == 0)
+                return false;
+            if (!ring)
+            {
+                writeToOutputs("[logcoe] ERROR: Failed to create shared log: " + name);
+                return false;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(s_collectorMutex);
+        s_collectorRing = std::move(ring);
+        s_collectorStop.store(false, std::memory_order_relaxed);
+        s_collectorThread = std::thread(collectorLoop);
+        return true;
+    }
+
+    void LoggerImpl::stopCollector()
+    {
+        std::shared_ptr<SharedRing> ring;
+        {
+            std::lock_guard<std::mutex> lock(s_collectorMutex);
+            s_collectorStop.store(true, std::memory_order_release);
+            ring = s_collectorRing;
+        }
+        if (ring)
+            ring->wake();
+        if (s_collectorThread.joinable())
+            s_collectorThread.join();
+
+        std::lock_guard<std::mutex> lock(s_collectorMutex);
+        s_collectorRing.reset();
+    }
+
+    // Writes the lines of the workers to this process's sinks in batches. Once stopped it still writes what the
+    // workers added until then, the wait timeout only bounds how long a stop can go unnoticed.
+    void LoggerImpl::collectorLoop()
+    {
+        LineChunk chunk;
+        std::uint64_t reported = 0;
+        std::uint64_t reportedAbandoned = 0;
+        for (;;)
+        {
+            bool stop = s_collectorStop.load(std::memory_order_acquire);
+            std::size_t records = 0;
+            {
+                std::lock_guard<std::mutex> lock(s_collectorMutex);
+                bool flush = false;
+                chunk.clear();
+                records = s_collectorRing->read(chunk, flush, stagingCapacity);
+                if (!chunk.empty())
+                    dispatch(chunk, flush, true);
+
+                std::uint64_t dropped = s_collectorRing->dropped();
+                if (dropped != reported)
+                {
+                    std::lock_guard<std::mutex> outputs(s_mutex);
+                    writeToOutputs("[logcoe] WARNING: Shared log dropped " + std::to_string(dropped - reported) +
+                                       " lines, the ring was full",
+                                   LogLevel::WARNING);
+                    reported = dropped;
+                }
+
+                std::uint64_t abandoned = s_collectorRing->abandoned();
+                if (abandoned != reportedAbandoned)
+                {
+                    std::lock_guard<std::mutex> outputs(s_mutex);
+                    writeToOutputs("[logcoe] WARNING: Shared log skipped " +
+                                       std::to_string(abandoned - reportedAbandoned) +
+                                       " lines of workers that exited while writing them",
+                                   LogLevel::WARNING);
+                    reportedAbandoned = abandoned;
+                }
+            }
+
+            if (records == 0)
+            {
+                if (stop)
+                    return;
+                s_collectorRing->wait(std::chrono::milliseconds(100));
+            }
+        }
+    }
+
+    // A forking process writes out the lines its threads buffered and holds the locks the collector thread takes,
+    // so a child inherits neither lines the parent writes as well nor a lock nobody will release
+    // What is queued or staged so far is written before the fork, and the locks a child takes are held across it
+    // in their usual order, so no thread that stays behind in the parent owns one in the child
+    void LoggerImpl::beforeFork()
+    {
+        drainQueue();
+        drainStaging();
+        BinaryLogger::beforeFork();
+        s_stagingMutex.lock();
+        for (const auto &buffer : s_stagingBuffers)
+            buffer->mutex.lock();
+        s_collectorMutex.lock();
+        s_mutex.lock();
+        flushOutputs();
+        for (const auto &slot : s_sinks)
+            slot->mutex.lock();
+    }
+
+    void LoggerImpl::afterForkParent()
+    {
+        for (const auto &slot : s_sinks)
+            slot->mutex.unlock();
+        s_mutex.unlock();
+        s_collectorMutex.unlock();
+        for (const auto &buffer : s_stagingBuffers)
+            buffer->mutex.unlock();
+        s_stagingMutex.unlock();
+        BinaryLogger::afterForkParent();
+    }
+
+    // Only the forking thread exists in the child. The handles of the writer, flush timer, stats report and
+    // collector threads are dropped without joining them, along with what their waits used, and the child logs
+    // synchronously without a timer or report until the logger is shut down and initialized again. The collector
+    // ring is unmapped without removing it, the child can then become a worker with setSharedOutput().
+    void LoggerImpl::afterForkChild()
+    {
+        for (const auto &slot : s_sinks)
+            slot->mutex.unlock();
+        s_mutex.unlock();
+        s_collectorMutex.unlock();
+        for (const auto &buffer : s_stagingBuffers)
+            buffer->mutex.unlock();
+        s_stagingMutex.unlock();
+        BinaryLogger::afterForkChild();
+
+        new (&s_collectorThread) std::thread();
+        s_collectorRing.reset();
+
+        // records other threads queued after the drain are the parent's to write
+        s_asyncEnabled.store(false, std::memory_order_relaxed);
+        new (&s_worker) std::thread();
+        new (&s_workerMutex) std::mutex();
+        new (&s_workerCondition) std::condition_variable();
+        new (&s_progressCondition) std::condition_variable();
+        s_queue.reset();
+        s_producers.store(0, std::memory_order_relaxed);
+        s_workerSleeping.store(false, std::memory_order_relaxed);
+        s_enqueuedCount.store(0, std::memory_order_relaxed);
+        s_completedCount.store(0, std::memory_order_relaxed);
+
+        new (&s_flushThread) std::thread();
+        new (&s_flushMutex) std::mutex();
+        new (&s_flushCondition) std::condition_variable();
+        s_flushInterval = std::chrono::milliseconds(0);
+
+        new (&s_reportThread) std::thread();
+        new (&s_reportMutex) std::mutex();
+        new (&s_reportCondition) std::condition_variable();
+    }
+
+    bool LoggerImpl::setSharedOutput(const std::string &name)
+    {
+        drainQueue();
+        drainStaging();
+
+        std::shared_ptr<SharedRing> ring = SharedRing::open(name);
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if (s_initCounter == 0)
+            return false;
+        if (!ring)
+        {
+            writeToOutputs("[logcoe] ERROR: Failed to open shared log: " + name);
+            return false;
+        }
+
+        s_sharedOutput = std::move(ring);
+        publishActiveLevel();
+        return true;
+    }
+
+    void LoggerImpl::disableSharedOutput()
+    {
+        drainQueue();
+        drainStaging();
+
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if (s_initCounter == 0 || !s_sharedOutput)
+            return;
+
+        s_sharedOutput.reset();
+        publishActiveLevel();
+    }
+
+    void LoggerImpl::getTimeFormat(std::string &format, TimePrecision &precision)
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        format = s_timestampFormatter.pattern();
+        precision = s_timestampFormatter.precision();
+    }
+
+    void LoggerImpl::writeBatch(const LogRecord *records, std::size_t count)
+    {
+        writeRecords(records, count);
+        s_completedCount.fetch_add(count, std::memory_order_release);
+
+        {
+            std::lock_guard<std::mutex> lock(s_workerMutex);
+        }
+        s_progressCondition.notify_all();
+    }
+
+    void LoggerImpl::workerLoop()
+    {
+        // popped records stay in place and are overwritten by the next batch, keeping their storage in circulation
+        std::vector<LogRecord> batch(maxBatchSize);
+        for (auto &record : batch)
+            record.reserve();
+
+        for (;;)
+        {
+            std::size_t count = 0;
+            while (count < maxBatchSize && s_queue->tryPop(batch[count]))
+                ++count;
+
+            if (count > 0)
+            {
+                writeBatch(batch.data(), count);
+                continue;
+            }
+
+            if (s_workerStop.load(std::memory_order_acquire))
+                return;
+
+            std::unique_lock<std::mutex> lock(s_workerMutex);
+            s_workerSleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (s_queue->empty() && !s_workerStop.load(std::memory_order_acquire))
+                s_workerCondition.wait_for(lock, std::chrono::milliseconds(100));
+            s_workerSleeping.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    void LoggerImpl::startWorker(const AsyncOptions &options)
+    {
+        // a queue from an earlier session is reused only when it has the requested bound, stopWorker() left no
+        // producer holding it
+        if (!s_queue || s_queue->capacity() != RecordQueue::sizeFor(options.queueCapacity))
+            s_queue = std::make_unique<RecordQueue>(options.queueCapacity);
+
+        s_overflowPolicy = options.overflowPolicy;
+        s_droppedCount.store(0, std::memory_order_relaxed);
+        s_workerStop.store(false, std::memory_order_relaxed);
+        s_worker = std::thread(workerLoop);
+        s_asyncEnabled.store(true, std::memory_order_release);
+    }
+
+    void LoggerImpl::stopWorker()
+    {
+        if (!s_worker.joinable())
+            return;
+
+        // new records are written synchronously from here on, the ones already on their way are pushed while
+        // the writer still makes room for them
+        s_asyncEnabled.store(false, std::memory_order_seq_cst);
+        while (s_producers.load(std::memory_order_seq_cst) != 0)
+        {
+            wakeWorker();
+            std::this_thread::yield();
+        }
+
+        s_workerStop.store(true, std::memory_order_release);
+        wakeWorker();
+        s_worker.join();
+
+        // records the writer had not popped yet when it saw the stop request
+        std::vector<LogRecord> batch;
+        LogRecord record;
+        while (s_queue->tryPop(record))
+            batch.push_back(std::move(record));
+        if (!batch.empty())
+            writeBatch(batch.data(), batch.size());
+    }
+
+    void LoggerImpl::drainQueue()
+    {
+        if (!s_asyncEnabled.load(std::memory_order_acquire))
+            return;
+
+        std::uint64_t target = s_enqueuedCount.load(std::memory_order_acquire);
+        wakeWorker();
+
+        std::unique_lock<std::mutex> lock(s_workerMutex);
+        while (s_completedCount.load(std::memory_order_acquire) < target &&
+               s_asyncEnabled.load(std::memory_order_acquire))
+            s_progressCondition.wait_for(lock, std::chrono::milliseconds(10));
+    }
+
+    void LoggerImpl::initialize(LogLevel level, const std::string &defaultSource, bool enableConsole, bool enableFile,
+                                const std::string &filename, const AsyncOptions &async)
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if(s_initCounter++ > 0)
+            return writeToOutputs("[logcoe] Already initialized, ignoring new configurations");
+
+        s_logLevel = level;
+        s_defaultSource = defaultSource;
+        if (enableConsole)
+            attachConsole(std::cout);
+
+        if (filename != s_filename)
+            s_filename = filename;
+
+        if (s_filename == "logcoe.log")
+            s_filename = "logcoe_" + getCurrentTimestamp() + ".log";
+
+        if (enableFile && !filename.empty())
+        {
+            std::filesystem::path filepath(s_filename);
+
+            if (filepath.has_parent_path() && !std::filesystem::exists(filepath.parent_path()))
+                std::filesystem::create_directories(filepath.parent_path());
+
+            if (std::filesystem::exists(filepath) && std::filesystem::is_regular_file(filepath))
+                std::filesystem::remove(filepath);
+
+            openFileOutput();
+        }
+
+#ifndef _WIN32
+        // the logger's threads do not survive a fork, children of any initialized process need the handlers
+        static std::once_flag forkHandlers;
+        std::call_once(forkHandlers, [] { ::pthread_atfork(beforeFork, afterForkParent, afterForkChild); });
+#endif
+
+        if (async.enabled)
+            startWorker(async);
+        publishActiveLevel();
+
+        writeToOutputs("[logcoe] Initialized, log level: " + getLogLevelAsString(s_logLevel) +
+                       (async.enabled ? ", async mode" : ""));
+    }
+
+    void LoggerImpl::shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(s_mutex);
+            if (s_initCounter > 1)
+            {
+                --s_initCounter;
+                return;
+            }
+        }
+
+        // the writer threads take s_mutex for every batch, so they must be drained and joined without holding it
+        stopWorker();
+        BinaryLogger::stop();
+        stopFlushTimer();
+        stopStatsReport();
+        stopCollector();
+        drainStaging();
+
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if (--s_initCounter > 0) return;
+
+        installCrashHandler(false);
+
+        std::string shutdownMessage = "[logcoe] shutting down";
+        writeToOutputs(shutdownMessage);
+
+        for (const auto &slot : s_sinks)
+            slot->close();
+        s_sinks.clear();
+        s_consoleSlot.reset();
+        s_fileSlot.reset();
+
+        s_logLevel = LogLevel::NONE;
+        s_filename = "logcoe.log";
+        s_rotation = RotationOptions{};
+        s_flushPolicy = FlushPolicy{};
+        s_outputFormat.store(OutputFormat::TEXT, std::memory_order_relaxed);
+        s_layout.reset();
+        s_recorder.records = 0;
+        s_recorderCapacity.store(0, std::memory_order_relaxed);
+        s_recorderTrigger.store(LogLevel::NONE, std::memory_order_relaxed);
+        s_sharedOutput.reset();
+        s_initCounter = 0;
+        publishActiveLevel();
+
+        // the archiver never takes s_mutex, the last rotated files are compressed before shutdown returns
+        FileArchiver::stop();
+    }
+
+    void LoggerImpl::setLogLevel(LogLevel level)
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if(s_initCounter == 0) return;
+
+        s_logLevel = level;
+        publishActiveLevel();
+    }
+
+    void LoggerImpl::setConsoleOutput(std::ostream &stream)
+    {
+        drainQueue();
+        drainStaging();
+
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if(s_initCounter == 0) return;
+
+        detachSink(s_consoleSlot);
+        attachConsole(stream);
+    }
+
+    bool LoggerImpl::setFileOutput(const std::string &filename)
+    {
+        drainQueue();
+        drainStaging();
+
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if(s_initCounter == 0) return false;
+
+        detachSink(s_fileSlot);
+        s_filename = filename.empty() ? "logcoe_" + getCurrentTimestamp() + ".log" : filename;
+
+        return openFileOutput();
+    }
+
+    void LoggerImpl::disableConsoleOutput()
+    {
+        drainQueue();
+        drainStaging();
+
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if(s_initCounter == 0) return;
+
+        detachSink(s_consoleSlot);
+    }
+
+    void LoggerImpl::disableFileOutput()
+    {
+        drainQueue();
+        drainStaging();
+
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if(s_initCounter == 0) return;
+
+        detachSink(s_fileSlot);
+        s_filename = "logcoe.log";
+    }
+
+    void LoggerImpl::setTimeFormat(const std::string &format, TimePrecision precision)
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if(s_initCounter == 0) return;
+
+        try
+        {
+            auto now = std::chrono::system_clock::now();
+            std::time_t time_t_now = std::chrono::system_clock::to_time_t(now);
+            std::tm tm_now;
+#ifdef _WIN32
+            localtime_s(&tm_now, &time_t_now);
+#else
+            localtime_r(&time_t_now, &tm_now);
+#endif
+
+            char buffer[256];
+            std::size_t result = std::strftime(buffer, sizeof(buffer), format.c_str(), &tm_now);
+            if (result == 0)
+            {
+                writeToOutputs("[logcoe] ERROR: Invalid time format provided: \"" + format + "\". Keeping the current format");
+                return;
+            }
+
+            s_timestampFormatter.setFormat(format, precision);
+            publishConfig();
+        }
+        catch (const std::exception &e)
+        {
+            std::stringstream message;
+            message << "[logcoe] ERROR: Exception while validating time format: " << e.what();
+            writeToOutputs(message.str());
+        }
+    }
+
+    void LoggerImpl::setFileRotation(const RotationOptions &options)
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if(s_initCounter == 0) return;
+
+        s_rotation = options;
+        if (!FileArchiver::supports(options.compression))
+        {
+            writeToOutputs("[logcoe] ERROR: Requested compression is not available in this build, "
+                           "rotated files are kept uncompressed");
+            s_rotation.compression = Compression::NONE;
+        }
+
+        if (s_fileSlot)
+        {
+            std::lock_guard<std::mutex> fileLock(s_fileSlot->mutex);
+            static_cast<RotatingFileSink &>(*s_fileSlot->sink).setRotation(s_rotation);
+        }
+    }
+
+    void LoggerImpl::setFlushPolicy(const FlushPolicy &policy)
+    {
+        {
+            std::lock_guard<std::mutex> lock(s_mutex);
+            if(s_initCounter == 0) return;
+
+            s_flushPolicy = policy;
+            publishConfig();
+            for (const auto &slot : {s_consoleSlot, s_fileSlot})
+            {
+                if (!slot)
+                    continue;
+                std::lock_guard<std::mutex> slotLock(slot->mutex);
+                applyFlushPolicy(*slot);
+            }
+        }
+
+        // the timer thread takes s_mutex, so it is started and woken outside of it
+        setFlushInterval(policy.interval);
+    }
+
+    SourceState *LoggerImpl::internSource(std::string_view name)
+    {
+        SourceRegistry &registry = sourceRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        std::string key(name);
+        auto found = registry.byName.find(key);
+        if (found != registry.byName.end())
+            return found->second;
+
+        auto source = std::make_unique<SourceState>();
+        source->id = static_cast<std::uint32_t>(registry.sources.size() + 1);
+        source->name = key;
+        source->prefix = " [" + key + "]";
+        // publishActiveLevel() stores the global gate before it takes the registry lock, so this is never stale
+        source->output.store(logcoe::detail::outputLevel.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        source->threshold.store(logcoe::detail::activeLevel.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+        SourceState *state = source.get();
+        registry.sources.push_back(std::move(source));
+        registry.byName.emplace(std::move(key), state);
+        return state;
+    }
+
+    void LoggerImpl::setSourceLevel(SourceState &source, bool overridden, LogLevel level)
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        {
+            std::lock_guard<std::mutex> registryLock(sourceRegistry().mutex);
+            source.overridden = overridden;
+            source.level = level;
+        }
+        publishActiveLevel();
+    }
+
+    LogLevel LoggerImpl::getSourceLevel(const SourceState &source)
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        std::lock_guard<std::mutex> registryLock(sourceRegistry().mutex);
+        return source.overridden ? source.level : s_logLevel;
+    }
+
+    void LoggerImpl::setOutputFormat(OutputFormat format)
+    {
+        // lines already formatted or queued keep the format they were logged with
+        drainQueue();
+        drainStaging();
+
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if(s_initCounter == 0) return;
+
+        s_outputFormat.store(format, std::memory_order_relaxed);
+        publishConfig();
+    }
+
+    void LoggerImpl::setLayout(const std::string &pattern)
+    {
+        drainQueue();
+        drainStaging();
+
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if(s_initCounter == 0) return;
+
+        std::shared_ptr<const Layout> layout;
+        if (!pattern.empty())
+        {
+            std::string error;
+            layout = Layout::compile(pattern, error);
+            if (!layout)
+                return writeToOutputs("[logcoe] ERROR: Invalid layout \"" + pattern + "\": " + error +
+                                      ". Keeping the current layout");
+        }
+
+        s_layout = std::move(layout);
+        publishConfig();
+    }
+
+    logcoe::SinkId LoggerImpl::addSink(std::shared_ptr<logcoe::Sink> sink, const logcoe::SinkOptions &options)
+    {
+        drainQueue();
+        drainStaging();
+
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if (s_initCounter == 0 || !sink) return 0;
+
+        auto slot = std::make_shared<SinkSlot>();
+        slot->id = s_nextSinkId++;
+        slot->sink = std::move(sink);
+        slot->options = options;
+        attachSink(slot);
+        return slot->id;
+    }
+
+    bool LoggerImpl::removeSink(logcoe::SinkId id)
+    {
+        drainQueue();
+        drainStaging();
+
+        std::lock_guard<std::mutex> lock(s_mutex);
+        auto found = std::find_if(s_sinks.begin(), s_sinks.end(),
+                                  [id](const std::shared_ptr<SinkSlot> &slot) { return id != 0 && slot->id == id; });
+        if (found == s_sinks.end())
+            return false;
+
+        std::shared_ptr<SinkSlot> slot = *found;
+        detachSink(slot);
+        return true;
+    }
+
+    bool LoggerImpl::setSinkLevel(logcoe::SinkId id, LogLevel level)
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        for (const auto &slot : s_sinks)
+        {
+            if (id == 0 || slot->id != id)
+                continue;
+
+            {
+                std::lock_guard<std::mutex> slotLock(slot->mutex);
+                slot->options.level = level;
+            }
+            publishActiveLevel();
+            return true;
+        }
+        return false;
+    }
+
+    bool LoggerImpl::isInitialized()
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+
+        return s_initCounter > 0;
+    }
+
+    LogLevel LoggerImpl::getLogLevel()
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+
+        return s_logLevel;
+    }
+
+    bool LoggerImpl::isAsync()
+    {
+        return s_asyncEnabled.load(std::memory_order_acquire);
+    }
+
+    std::uint64_t LoggerImpl::getDroppedMessageCount()
+    {
+        return s_droppedCount.load(std::memory_order_relaxed) + BinaryLogger::droppedCount();
+    }
+
+    void LoggerImpl::setFlushInterval(std::chrono::milliseconds interval)
+    {
+        std::lock_guard<std::mutex> lock(s_flushMutex);
+        s_flushInterval = interval;
+        if (interval.count() > 0 && !s_flushThread.joinable())
+        {
+            s_flushStop = false;
+            s_flushThread = std::thread(flushTimerLoop);
+        }
+        s_flushCondition.notify_all();
+    }
+
+    void LoggerImpl::stopFlushTimer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(s_flushMutex);
+            s_flushStop = true;
+            s_flushInterval = std::chrono::milliseconds(0);
+        }
+        s_flushCondition.notify_all();
+
+        if (s_flushThread.joinable())
+            s_flushThread.join();
+    }
+
+    // Group commit: everything staged or buffered since the last tick is written and flushed together
+    void LoggerImpl::flushTimerLoop()
+    {
+        std::unique_lock<std::mutex> lock(s_flushMutex);
+        while (!s_flushStop)
+        {
+            if (s_flushInterval.count() <= 0)
+            {
+                s_flushCondition.wait(lock);
+                continue;
+            }
+
+            if (s_flushCondition.wait_for(lock, s_flushInterval, [] { return s_flushStop; }))
+                break;
+            lock.unlock();
+
+            drainStaging();
+            {
+                ConfigReader reader;
+                if (reader.config)
+                {
+                    for (const auto &slot : reader.config->sinks)
+                        slot->flush();
+                }
+            }
+
+            lock.lock();
+        }
+    }
+
+    logcoe::LogStats LoggerImpl::getStats()
+    {
+        logcoe::LogStats stats;
+        {
+            LeasePool<StatsShard> &shards = statsShards();
+            std::lock_guard<std::mutex> lock(shards.mutex);
+            for (const auto &shard : shards.items)
+            {
+                for (std::size_t level = 0; level < 4; ++level)
+                {
+                    stats.accepted[level] += shard->accepted[level].load(std::memory_order_relaxed);
+                    stats.filtered[level] += shard->filtered[level].load(std::memory_order_relaxed);
+                }
+                stats.bytesWritten += shard->bytes.load(std::memory_order_relaxed);
+                stats.writes += shard->writes.load(std::memory_order_relaxed);
+                stats.flushes += shard->flushes.load(std::memory_order_relaxed);
+                stats.lockContentions += shard->contentions.load(std::memory_order_relaxed);
+                stats.lockWaitNanoseconds += shard->waitNanoseconds.load(std::memory_order_relaxed);
+                stats.recorded += shard->recorded.load(std::memory_order_relaxed);
+                for (std::size_t bucket = 0; bucket < logcoe::LogStats::latencyBuckets; ++bucket)
+                    stats.latency[bucket] += shard->latency[bucket].load(std::memory_order_relaxed);
+            }
+        }
+
+        std::vector<std::shared_ptr<SinkSlot>> sinks;
+        {
+            std::lock_guard<std::mutex> lock(s_mutex);
+            sinks = s_sinks;
+            if (s_asyncEnabled.load(std::memory_order_acquire) && s_queue)
+            {
+                std::uint64_t completed = s_completedCount.load(std::memory_order_acquire);
+                std::uint64_t enqueued = s_enqueuedCount.load(std::memory_order_acquire);
+                stats.queueDepth = enqueued > completed ? static_cast<std::size_t>(enqueued - completed) : 0;
+                stats.queueCapacity = s_queue->capacity();
+            }
+        }
+        stats.dropped = getDroppedMessageCount();
+
+        for (const auto &slot : sinks)
+        {
+            std::lock_guard<std::mutex> lock(slot->mutex);
+            logcoe::SinkStats sink = slot->stats;
+            sink.id = slot->id;
+            sink.name = slot->name;
+            sink.buffered = slot->buffer.size();
+            sink.dropped = slot->sink->dropped();
+            stats.sinks.push_back(std::move(sink));
+        }
+        return stats;
+    }
+
+    void LoggerImpl::setStatsReport(std::chrono::milliseconds interval, logcoe::SinkId sink)
+    {
+        if (interval.count() <= 0)
+            return stopStatsReport();
+
+        std::lock_guard<std::mutex> lock(s_reportMutex);
+        s_reportInterval = interval;
+        s_reportSink = sink;
+        if (!s_reportThread.joinable())
+        {
+            s_reportStop = false;
+            s_reportThread = std::thread(statsReportLoop);
+        }
+        s_reportCondition.notify_all();
+    }
+
+    void LoggerImpl::stopStatsReport()
+    {
+        {
+            std::lock_guard<std::mutex> lock(s_reportMutex);
+            s_reportStop = true;
+        }
+        s_reportCondition.notify_all();
+
+        if (s_reportThread.joinable())
+            s_reportThread.join();
+    }
+
+    void LoggerImpl::statsReportLoop()
+    {
+        std::unique_lock<std::mutex> lock(s_reportMutex);
+        while (!s_reportStop)
+        {
+            if (s_reportCondition.wait_for(lock, s_reportInterval, [] { return s_reportStop; }))
+                break;
+            logcoe::SinkId target = s_reportSink;
+            lock.unlock();
+            writeStatsReport(target);
+            lock.lock();
+        }
+    }
+
+    void LoggerImpl::writeStatsReport(logcoe::SinkId target)
+    {
+        logcoe::LogStats stats = getStats();
+        std::uint64_t accepted = 0;
+        std::uint64_t filtered = 0;
+        for (std::size_t level = 0; level < 4; ++level)
+        {
+            accepted += stats.accepted[level];
+            filtered += stats.filtered[level];
+        }
+
+        const Field fields[] = {{"accepted", accepted},
+                                {"filtered", filtered},
+                                {"bytes", stats.bytesWritten},
+                                {"writes", stats.writes},
+                                {"flushes", stats.flushes},
+                                {"lock_wait_us", stats.lockWaitNanoseconds / 1000},
+                                {"queue_depth", stats.queueDepth},
+                                {"dropped", stats.dropped},
+                                {"p50_ns", stats.latencyPercentile(0.5)},
+                                {"p99_ns", stats.latencyPercentile(0.99)}};
+
+        LineChunk chunk;
+        std::vector<std::shared_ptr<SinkSlot>> sinks;
+        {
+            std::lock_guard<std::mutex> lock(s_mutex);
+            if (s_initCounter == 0)
+                return;
+
+            std::string line;
+            OutputFormat format = s_outputFormat.load(std::memory_order_relaxed);
+            beginLine(line, s_timestampFormatter, format, LogLevel::INFO, std::chrono::system_clock::now(),
+                      std::string_view(), nullptr, "[logcoe] stats", nullptr, s_layout.get(), threadNumber());
+            appendFields(line, format, fields, std::size(fields));
+            endLine(line, format);
+            chunk.append(line, LogLevel::INFO);
+
+            for (const auto &slot : s_sinks)
+            {
+                if (target == 0 || slot->id == target)
+                    sinks.push_back(slot);
+            }
+        }
+
+        for (const auto &slot : sinks)
+            slot->write(chunk, true);
+    }
+
+    void LoggerImpl::setCrashHandler(bool enabled)
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        installCrashHandler(enabled && s_initCounter > 0);
+    }
+
+    // Called with s_mutex held
+    void LoggerImpl::installCrashHandler(bool enabled)
+    {
+        if (enabled == s_crashHandler)
+            return;
+        s_crashHandler = enabled;
+
+        if (!enabled)
+        {
+            std::set_terminate(s_previousTerminate);
+            for (std::size_t i = 0; i < std::size(crashSignals); ++i)
+            {
+#ifdef _WIN32
+                std::signal(crashSignals[i], s_previousSignalHandlers[i]);
+#else
+                sigaction(crashSignals[i], &s_previousSignalActions[i], nullptr);
+#endif
+            }
+            return;
+        }
+
+        s_previousTerminate = std::set_terminate(onTerminate);
+#ifdef _WIN32
+        for (std::size_t i = 0; i < std::size(crashSignals); ++i)
+            s_previousSignalHandlers[i] = std::signal(crashSignals[i], onCrashSignal);
+#else
+        // a stack overflow leaves no room for the handler, so the enabling thread gets a stack of its own (leaked,
+        // the handler may run during static destruction)
+        stack_t current{};
+        if (sigaltstack(nullptr, &current) == 0 && (current.ss_flags & SS_DISABLE))
+        {
+            constexpr std::size_t stackSize = 64 * 1024;
+            stack_t stack{};
+            stack.ss_sp = new char[stackSize];
+            stack.ss_size = stackSize;
+            sigaltstack(&stack, nullptr);
+        }
+
+        struct sigaction action{};
+        action.sa_handler = onCrashSignal;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_ONSTACK;
+        for (std::size_t i = 0; i < std::size(crashSignals); ++i)
+            sigaction(crashSignals[i], &action, &s_previousSignalActions[i]);
+#endif
+    }
+
+    // No locks and no allocation, the crashing thread may hold any of them. Buffers are read as they are, a thread
+    // writing at the same moment can only garble its own last line.
+    void LoggerImpl::drainOnCrash(std::string_view reason)
+    {
+        CrashLine marker;
+        OutputFormat format = s_outputFormat.load(std::memory_order_relaxed);
+        if (format == OutputFormat::JSON)
+            marker.append("{\"level\":\"ERROR\",\"message\":\"");
+        else if (format == OutputFormat::LOGFMT)
+            marker.append("level=ERROR msg=\"");
+        marker.append("[logcoe] FATAL: ");
+        marker.append(reason);
+        if (format == OutputFormat::JSON)
+            marker.append("\"}");
+        else if (format == OutputFormat::LOGFMT)
+            marker.append("\"");
+        marker.append("\n");
+
+        const ConfigSnapshot *config = s_config.load(std::memory_order_acquire);
+        if (!config)
+            return;
+
+        for (const auto &slot : config->sinks)
+        {
+            if (slot->closed)
+                continue;
+
+            // written but held back by the sink's buffer first, then what each thread has staged since
+            int level = static_cast<int>(slot->options.level);
+            if (!slot->buffer.empty())
+                slot->sink->writeOnCrash(slot->buffer);
+
+            for (const auto &staging : s_stagingBuffers)
+            {
+                std::string_view text = staging->chunk.text;
+                std::size_t begin = 0;
+                std::size_t end = 0;
+                for (const auto &line : staging->chunk.lines)
+                {
+                    if (static_cast<int>(line.level) < level)
+                    {
+                        if (end > begin)
+                            slot->sink->writeOnCrash(text.substr(begin, end - begin));
+                        begin = line.end;
+                    }
+                    end = line.end;
+                }
+                if (end > begin)
+                    slot->sink->writeOnCrash(text.substr(begin, end - begin));
+            }
+
+            if (level <= static_cast<int>(LogLevel::ERROR))
+                slot->sink->writeOnCrash(marker.view());
+        }
+    }
+
+    void LoggerImpl::onCrashSignal(int signal)
+    {
+        if (!s_crashing.exchange(true))
+            drainOnCrash(crashSignalName(signal));
+
+        // back to the disposition from before logcoe, raised again so the process ends as it would have without it
+        for (std::size_t i = 0; i < std::size(crashSignals); ++i)
+        {
+            if (crashSignals[i] != signal)
+                continue;
+#ifdef _WIN32
+            std::signal(signal, s_previousSignalHandlers[i]);
+#else
+            sigaction(signal, &s_previousSignalActions[i], nullptr);
+#endif
+        }
+        std::raise(signal);
+    }
+
+    void LoggerImpl::onTerminate()
+    {
+        if (!s_crashing.exchange(true))
+            drainOnCrash("std::terminate");
+
+        if (s_previousTerminate)
+            s_previousTerminate();
+        std::abort();
+    }
+
+    void LoggerImpl::flush()
+    {
+        drainQueue();
+        drainStaging();
+        BinaryLogger::drain();
+
+        TimedLock lock(s_mutex);
+        flushOutputs();
+    }
+
+    bool LoggerImpl::firstFormatWarning(std::string_view format)
+    {
+        // formats built at run time could grow the set without bound, after the cap nothing more is reported
+        std::lock_guard<std::mutex> lock(s_formatWarningsMutex);
+        return s_formatWarnings.size() < 256 && s_formatWarnings.emplace(format).second;
+    }
+
+    void LoggerImpl::warnFormatMismatch(std::string_view format, std::size_t count)
+    {
+        if (!firstFormatWarning(format))
+            return;
+
+        std::lock_guard<std::mutex> lock(s_mutex);
+        writeToOutputs("[logcoe] WARNING: Format \"" + std::string(format) + "\" has " +
+                           std::to_string(logcoe::detail::countPlaceholders(format)) + " placeholders for " +
+                           std::to_string(count) + " arguments, unmatched {} are kept and extra arguments dropped",
+                       LogLevel::WARNING);
+    }
+
+    void LoggerImpl::warnUnformattedMessage(std::string_view message, std::string_view source)
+    {
+        if (!firstFormatWarning(message))
+            return;
+
+        std::lock_guard<std::mutex> lock(s_mutex);
+        writeToOutputs("[logcoe] WARNING: Message \"" + std::string(message) + "\" was logged from source \"" +
+                           std::string(source) + "\" without formatting, use infof() or LOGCOE_FMT() to format it",
+                       LogLevel::WARNING);
+    }
+
+    constexpr char binaryMagic[8] = {'L', 'O', 'G', 'C', 'O', 'E', 'B', '1'};
+    constexpr char binaryConfigEntry = 'C';
+    constexpr char binaryFormatEntry = 'F';
+    constexpr char binaryRecordEntry = 'R';
+
+    // Decodes an 'R' entry whose type byte was already consumed
+    bool decodeBinaryRecord(const char *&cursor, const char *end,
+                            const std::vector<std::unique_ptr<BinaryFormat>> &formats, LogRecord &record)
+    {
+        thread_local std::vector<DecodedArgument> decoded;
+        thread_local std::vector<logcoe::detail::FormatArgument> arguments;
+
+        std::uint32_t formatId;
+        std::int64_t nanoseconds;
+        if (!readBinary(cursor, end, formatId) || !readBinary(cursor, end, nanoseconds) ||
+            formatId >= formats.size() || !formats[formatId])
+            return false;
+
+        const BinaryFormat &format = *formats[formatId];
+        if (!decodeArguments(cursor, end, format.argumentCount, decoded, arguments))
+            return false;
+
+        record.level = format.level;
+        record.time = std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(nanoseconds)));
+        record.source.clear();
+        record.location = &format.location;
+        record.flush = false;
+        record.message.clear();
+        logcoe::detail::formatTo(record.message, format.format, arguments.data(), arguments.size());
+        return true;
+    }
+
+    std::mutex BinaryLogger::s_formatsMutex;
+    std::vector<std::unique_ptr<BinaryFormat>> BinaryLogger::s_formats;
+    std::mutex BinaryLogger::s_buffersMutex;
+    std::vector<std::shared_ptr<BinaryThreadBuffer>> BinaryLogger::s_buffers;
+    std::mutex BinaryLogger::s_drainMutex;
+    std::ofstream BinaryLogger::s_file;
+    std::size_t BinaryLogger::s_formatsWritten = 0;
+    std::vector<LogRecord> BinaryLogger::s_decoded;
+    std::mutex BinaryLogger::s_threadMutex;
+    std::condition_variable BinaryLogger::s_threadCondition;
+    std::thread BinaryLogger::s_thread;
+    std::atomic<bool> BinaryLogger::s_running{false};
+    bool BinaryLogger::s_stop = false;
+    std::atomic<std::uint64_t> BinaryLogger::s_droppedCount{0};
+
+    BinaryThreadBuffer &BinaryLogger::threadBuffer()
+    {
+        struct Handle
+        {
+            std::shared_ptr<BinaryThreadBuffer> buffer = std::make_shared<BinaryThreadBuffer>();
+
+            Handle()
+            {
+                buffer->data.reserve(wakeThreshold);
+                std::lock_guard<std::mutex> lock(s_buffersMutex);
+                s_buffers.push_back(buffer);
+            }
+
+            // the drainer still owns the buffer and removes it once it is empty
+            ~Handle()
+            {
+                std::lock_guard<std::mutex> lock(buffer->mutex);
+                buffer->orphaned = true;
+            }
+        };
+
+        thread_local Handle handle;
+        return *handle.buffer;
+    }
+
+    std::uint32_t BinaryLogger::registerFormat(LogLevel level, const SourceLocation &location, std::string_view format,
+                                               std::size_t argumentCount)
+    {
+        auto entry = std::make_unique<BinaryFormat>();
+        entry->level = level;
+        entry->location = location;
+        entry->format = std::string(format);
+        entry->argumentCount = argumentCount;
+
+        std::lock_guard<std::mutex> lock(s_formatsMutex);
+        s_formats.push_back(std::move(entry));
+        return static_cast<std::uint32_t>(s_formats.size() - 1);
+    }
+
+    char *BinaryLogger::beginRecord(std::uint32_t formatId, std::size_t payloadSize)
+    {
+        BinaryThreadBuffer &buffer = threadBuffer();
+        std::int64_t timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::system_clock::now().time_since_epoch()).count();
+
+        buffer.mutex.lock();
+        std::size_t offset = buffer.data.size();
+        std::size_t recordSize = recordHeaderSize + payloadSize;
+        if (offset + recordSize > maxBufferSize)
+        {
+            buffer.mutex.unlock();
+            s_droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        buffer.data.resize(offset + recordSize);
+        char *cursor = buffer.data.data() + offset;
+        *cursor++ = binaryRecordEntry;
+        std::memcpy(cursor, &formatId, sizeof(formatId));
+        cursor += sizeof(formatId);
+        std::memcpy(cursor, &timestamp, sizeof(timestamp));
+        return cursor + sizeof(timestamp);
+    }
+
+    void BinaryLogger::endRecord()
+    {
+        BinaryThreadBuffer &buffer = threadBuffer();
+        bool wake = buffer.data.size() >= wakeThreshold;
+        buffer.mutex.unlock();
+
+        if (!s_running.load(std::memory_order_acquire))
+            start();
+        if (wake)
+            s_threadCondition.notify_one();
+    }
+
+    void BinaryLogger::start()
+    {
+        std::lock_guard<std::mutex> lock(s_threadMutex);
+        if (s_running.load(std::memory_order_relaxed))
+            return;
+
+        s_stop = false;
+        s_thread = std::thread(threadLoop);
+        s_running.store(true, std::memory_order_release);
+    }
+
+    void BinaryLogger::threadLoop()
+    {
+        std::unique_lock<std::mutex> lock(s_threadMutex);
+        while (!s_stop)
+        {
+            s_threadCondition.wait_for(lock, std::chrono::milliseconds(50));
+            lock.unlock();
+            drain();
+            lock.lock();
+        }
+    }
+
+    void BinaryLogger::stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(s_threadMutex);
+            s_stop = true;
+        }
+        s_threadCondition.notify_one();
+        if (s_thread.joinable())
+            s_thread.join();
+        s_running.store(false, std::memory_order_release);
+
+        disableOutput();
+    }
+
+    // Held in the order drain() and the writing threads take them, so no record or drain is half done in the child
+    void BinaryLogger::beforeFork()
+    {
+        s_drainMutex.lock();
+        s_buffersMutex.lock();
+        for (const auto &buffer : s_buffers)
+            buffer->mutex.lock();
+        s_formatsMutex.lock();
+        s_threadMutex.lock();
+    }
+
+    void BinaryLogger::afterForkParent()
     {
-        if (s_initCounter == 0 || static_cast<int>(level) < static_cast<int>(s_logLevel))
-            return;
+        s_threadMutex.unlock();
+        s_formatsMutex.unlock();
+        for (const auto &buffer : s_buffers)
+            buffer->mutex.unlock();
+        s_buffersMutex.unlock();
+        s_drainMutex.unlock();
+    }
 
-        if (s_useConsole && s_consoleStream)
-        {
-            *s_consoleStream << formattedMessage << std::endl;
-            if (flush)
-                s_consoleStream->flush();
-        }
+    // The drain thread stayed in the parent, the child's next record starts its own
+    void BinaryLogger::afterForkChild()
+    {
+        afterForkParent();
+        new (&s_thread) std::thread();
+        new (&s_threadCondition) std::condition_variable();
+        s_running.store(false, std::memory_order_relaxed);
+        s_stop = false;
+    }
 
-        if (s_useFile)
+    void BinaryLogger::writeFormats(std::size_t end)
+    {
+        std::string entry;
+        std::lock_guard<std::mutex> lock(s_formatsMutex);
+        for (; s_formatsWritten < end; ++s_formatsWritten)
         {
-            s_fileStream << formattedMessage << std::endl;
-            if (flush)
-                s_fileStream.flush();
+            const BinaryFormat &format = *s_formats[s_formatsWritten];
+            std::string_view file(format.location.file);
+
+            entry.clear();
+            entry += binaryFormatEntry;
+            appendBinary(entry, static_cast<std::uint32_t>(s_formatsWritten));
+            appendBinary(entry, static_cast<std::uint8_t>(format.level));
+            appendBinary(entry, static_cast<std::int32_t>(format.location.line));
+            appendBinary(entry, static_cast<std::uint16_t>(file.size()));
+            entry.append(file.data(), file.size());
+            appendBinary(entry, static_cast<std::uint32_t>(format.format.size()));
+            entry += format.format;
+            appendBinary(entry, static_cast<std::uint8_t>(format.argumentCount));
+            s_file.write(entry.data(), static_cast<std::streamsize>(entry.size()));
         }
     }
 
-    void LoggerImpl::log(LogLevel level, const std::string &message, const std::string &source, bool flush)
+    void BinaryLogger::decodeChunk(const std::vector<char> &chunk)
     {
-        std::lock_guard<std::mutex> lock(s_mutex);
-        if(s_initCounter == 0) return;
-
-        std::stringstream formattedMessage;
-        formattedMessage << "[" << getCurrentTimestamp() << "] ";
-        formattedMessage << "[" << getLogLevelAsString(level) << "]";
-        if (!source.empty())
-            formattedMessage << " [" << source << "]";
-        formattedMessage << ": " << message;
+        std::size_t count = 0;
+        {
+            // every format referenced by the chunk was registered before its records were written
+            std::lock_guard<std::mutex> lock(s_formatsMutex);
+            const char *cursor = chunk.data();
+            const char *end = cursor + chunk.size();
+            while (cursor < end && *cursor++ == binaryRecordEntry)
+            {
+                if (count == s_decoded.size())
+                    s_decoded.emplace_back();
+                if (!decodeBinaryRecord(cursor, end, s_formats, s_decoded[count]))
+                    break;
+                ++count;
+            }
+        }
 
-        writeToOutputs(formattedMessage.str(), level, flush);
+        LoggerImpl::writeRecords(s_decoded.data(), count);
     }
 
-    void LoggerImpl::initialize(LogLevel level, const std::string &defaultSource, bool enableConsole, bool enableFile, const std::string &filename)
+    void BinaryLogger::drain()
     {
-        std::lock_guard<std::mutex> lock(s_mutex);
-        if(s_initCounter++ > 0)
-            return writeToOutputs("[logcoe] Already initialized, ignoring new configurations");
-
-        s_logLevel = level;
-        s_defaultSource = defaultSource;
-        s_useConsole = enableConsole;
-        if (s_useConsole && !s_consoleStream)
-            s_consoleStream = &std::cout;
-        s_useFile = enableFile;
+        std::lock_guard<std::mutex> drainLock(s_drainMutex);
 
-        if (filename != s_filename)
-            s_filename = filename;
+        std::vector<std::shared_ptr<BinaryThreadBuffer>> buffers;
+        {
+            std::lock_guard<std::mutex> lock(s_buffersMutex);
+            buffers = s_buffers;
+        }
 
-        if (s_filename == "logcoe.log")
-            s_filename = "logcoe_" + getCurrentTimestamp() + ".log";
+        bool orphans = false;
+        for (auto &buffer : buffers)
+        {
+            std::lock_guard<std::mutex> lock(buffer->mutex);
+            buffer->data.swap(buffer->spare);
+            orphans = orphans || buffer->orphaned;
+        }
 
-        if (s_useFile && !filename.empty())
+        std::size_t formatCount;
         {
-            if (s_fileStream.is_open())
-                s_fileStream.close();
+            std::lock_guard<std::mutex> lock(s_formatsMutex);
+            formatCount = s_formats.size();
+        }
 
-            std::filesystem::path filepath(s_filename);
+        if (s_file.is_open())
+            writeFormats(formatCount);
 
-            if (filepath.has_parent_path() && !std::filesystem::exists(filepath.parent_path()))
-                std::filesystem::create_directories(filepath.parent_path());
-            
-            if (std::filesystem::exists(filepath) && std::filesystem::is_regular_file(filepath))
-                std::filesystem::remove(filepath);
+        for (auto &buffer : buffers)
+        {
+            if (buffer->spare.empty())
+                continue;
 
-            s_fileStream.open(s_filename);
-            if (!s_fileStream.is_open())
-            {
-                writeToOutputs("[logcoe] ERROR: Failed to open log file: " + s_filename);
-                s_useFile = false;
-            }
+            if (s_file.is_open())
+                s_file.write(buffer->spare.data(), static_cast<std::streamsize>(buffer->spare.size()));
+            else
+                decodeChunk(buffer->spare);
+            buffer->spare.clear();
         }
 
-        writeToOutputs("[logcoe] Initialized, log level: " + getLogLevelAsString(s_logLevel));
+        if (s_file.is_open())
+            s_file.flush();
+
+        if (orphans)
+        {
+            std::lock_guard<std::mutex> lock(s_buffersMutex);
+            s_buffers.erase(std::remove_if(s_buffers.begin(), s_buffers.end(),
+                                           [](const std::shared_ptr<BinaryThreadBuffer> &buffer)
+                                           {
+                                               std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+                                               return buffer->orphaned && buffer->data.empty();
+                                           }),
+                            s_buffers.end());
+        }
     }
 
-    void LoggerImpl::shutdown()
+    bool BinaryLogger::setOutput(const std::string &filename)
     {
-        std::lock_guard<std::mutex> lock(s_mutex);
-        if (--s_initCounter > 0) return;
+        if (!LoggerImpl::isInitialized())
+            return false;
 
-        std::string shutdownMessage = "[logcoe] shutting down";
-        writeToOutputs(shutdownMessage);
+        // records logged so far belong to the previous destination
+        drain();
 
-        flush();
-        if (s_fileStream.is_open())
-            s_fileStream.close();
+        std::string timeFormat;
+        TimePrecision precision;
+        LoggerImpl::getTimeFormat(timeFormat, precision);
 
-        s_consoleStream = nullptr;
-        s_useConsole = false;
-        s_useFile = false;
-        s_logLevel = LogLevel::NONE;
-        s_filename = "logcoe.log";
-        s_initCounter = 0;
-    }
+        std::lock_guard<std::mutex> lock(s_drainMutex);
+        if (s_file.is_open())
+            s_file.close();
 
-    void LoggerImpl::setLogLevel(LogLevel level)
-    {
-        std::lock_guard<std::mutex> lock(s_mutex);
-        if(s_initCounter == 0) return;
+        s_file.open(filename, std::ios::binary | std::ios::trunc);
+        if (!s_file.is_open())
+            return false;
 
-        s_logLevel = level;
+        std::string header(binaryMagic, sizeof(binaryMagic));
+        header += binaryConfigEntry;
+        appendBinary(header, static_cast<std::uint8_t>(precision));
+        appendBinary(header, static_cast<std::uint16_t>(timeFormat.size()));
+        header += timeFormat;
+        s_file.write(header.data(), static_cast<std::streamsize>(header.size()));
+        s_formatsWritten = 0;
+
+        return true;
     }
 
-    void LoggerImpl::setConsoleOutput(std::ostream &stream)
+    void BinaryLogger::disableOutput()
     {
-        std::lock_guard<std::mutex> lock(s_mutex);
-        if(s_initCounter == 0) return;
+        drain();
 
-        if (s_useConsole && s_consoleStream)
-            s_consoleStream->flush();
-        s_consoleStream = &stream;
-        s_useConsole = true;
+        std::lock_guard<std::mutex> lock(s_drainMutex);
+        if (s_file.is_open())
+            s_file.close();
     }
 
-    bool LoggerImpl::setFileOutput(const std::string &filename)
+    std::uint64_t BinaryLogger::droppedCount()
     {
-        std::lock_guard<std::mutex> lock(s_mutex);
-        if(s_initCounter == 0) return false;
+        return s_droppedCount.load(std::memory_order_relaxed);
+    }
 
-        if (s_fileStream.is_open())
+    std::mutex FileArchiver::s_mutex;
+    std::condition_variable FileArchiver::s_condition;
+    std::deque<ArchiveJob> FileArchiver::s_jobs;
+    std::thread FileArchiver::s_thread;
+    bool FileArchiver::s_stop = false;
+
+#ifdef LOGCOE_HAS_ZLIB
+    bool gzipFile(const std::string &source, const std::string &target)
+    {
+        std::ifstream in(source, std::ios::binary);
+        gzFile out = gzopen(target.c_str(), "wb6");
+        if (!in.is_open() || !out)
         {
-            if (s_useFile)
-                s_fileStream.flush();
-            s_fileStream.close();
+            if (out)
+                gzclose(out);
+            return false;
         }
 
-        s_filename = filename.empty() ? "logcoe_" + getCurrentTimestamp() + ".log" : filename;
-        s_useFile = true;
-
-        s_fileStream.open(s_filename);
-        if (!s_fileStream.is_open())
+        std::vector<char> buffer(64 * 1024);
+        bool written = true;
+        while (written && in)
         {
-            writeToOutputs("[logcoe] ERROR: Failed to open log file: " + s_filename);
-            s_useFile = false;
+            in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            auto count = static_cast<int>(in.gcount());
+            if (count > 0 && gzwrite(out, buffer.data(), static_cast<unsigned>(count)) != count)
+                written = false;
         }
 
-        return s_useFile;
+        return gzclose(out) == Z_OK && written;
     }
+#endif
 
-    void LoggerImpl::disableConsoleOutput()
+#ifdef LOGCOE_HAS_ZSTD
+    bool zstdFile(const std::string &source, const std::string &target)
     {
-        std::lock_guard<std::mutex> lock(s_mutex);
-        if(s_initCounter == 0) return;
+        std::ifstream in(source, std::ios::binary);
+        std::ofstream out(target, std::ios::binary | std::ios::trunc);
+        std::unique_ptr<ZSTD_CCtx, std::size_t (*)(ZSTD_CCtx *)> context(ZSTD_createCCtx(), ZSTD_freeCCtx);
+        if (!in.is_open() || !out.is_open() || !context)
+            return false;
+
+        std::vector<char> input(ZSTD_CStreamInSize());
+        std::vector<char> output(ZSTD_CStreamOutSize());
+        for (;;)
+        {
+            in.read(input.data(), static_cast<std::streamsize>(input.size()));
+            auto count = static_cast<std::size_t>(in.gcount());
+            bool last = count < input.size();
+
+            ZSTD_inBuffer inBuffer{input.data(), count, 0};
+            bool finished = false;
+            while (!finished)
+            {
+                ZSTD_outBuffer outBuffer{output.data(), output.size(), 0};
+                std::size_t remaining = ZSTD_compressStream2(context.get(), &outBuffer, &inBuffer,
+                                                             last ? ZSTD_e_end : ZSTD_e_continue);
+                if (ZSTD_isError(remaining))
+                    return false;
+                out.write(output.data(), static_cast<std::streamsize>(outBuffer.pos));
+                finished = last ? remaining == 0 : inBuffer.pos == inBuffer.size;
+            }
+
+            if (last)
+                break;
+        }
 
-        if (s_useConsole && s_consoleStream)
-            s_consoleStream->flush();
-        s_consoleStream = nullptr;
-        s_useConsole = false;
+        return static_cast<bool>(out);
     }
+#endif
 
-    void LoggerImpl::disableFileOutput()
+    // <stem>.<YYYYmmdd-HHMMSS>.<NNN><extension>[.gz|.zst]
+    bool isRotatedName(const std::string &name, const std::string &stem, const std::string &extension)
     {
-        std::lock_guard<std::mutex> lock(s_mutex);
-        if(s_initCounter == 0) return;
+        constexpr std::string_view pattern = "########-######.###";
+        std::string_view rest(name);
+        if (rest.size() < stem.size() + 1 + pattern.size() || rest.compare(0, stem.size(), stem) != 0 ||
+            rest[stem.size()] != '.')
+            return false;
 
-        if (s_fileStream.is_open())
+        rest.remove_prefix(stem.size() + 1);
+        for (std::size_t i = 0; i < pattern.size(); ++i)
         {
-            if (s_useFile)
-                s_fileStream.flush();
-            s_fileStream.close();
+            bool digit = rest[i] >= '0' && rest[i] <= '9';
+            if (pattern[i] == '#' ? !digit : rest[i] != pattern[i])
+                return false;
         }
 
-        s_filename = "logcoe.log";
-        s_useFile = false;
+        rest.remove_prefix(pattern.size());
+        if (rest.compare(0, extension.size(), extension) != 0)
+            return false;
+
+        rest.remove_prefix(extension.size());
+        return rest.empty() || rest == ".gz" || rest == ".zst";
     }
 
-    void LoggerImpl::setTimeFormat(const std::string &format)
+    bool FileArchiver::supports(Compression compression)
     {
-        std::lock_guard<std::mutex> lock(s_mutex);
-        if(s_initCounter == 0) return;
-
-        try
+        switch (compression)
         {
-            auto now = std::chrono::system_clock::now();
-            std::time_t time_t_now = std::chrono::system_clock::to_time_t(now);
-            std::tm tm_now;
-#ifdef _WIN32
-            localtime_s(&tm_now, &time_t_now);
+        case Compression::GZIP:
+#ifdef LOGCOE_HAS_ZLIB
+            return true;
 #else
-            localtime_r(&time_t_now, &tm_now);
+            return false;
 #endif
+        case Compression::ZSTD:
+#ifdef LOGCOE_HAS_ZSTD
+            return true;
+#else
+            return false;
+#endif
+        default:
+            return true;
+        }
+    }
 
-            char buffer[256];
-            std::size_t result = std::strftime(buffer, sizeof(buffer), format.c_str(), &tm_now);
-            if (result == 0)
+    void FileArchiver::submit(ArchiveJob job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(s_mutex);
+            s_jobs.push_back(std::move(job));
+            if (!s_thread.joinable())
             {
-                writeToOutputs("[logcoe] ERROR: Invalid time format provided: \"" + format + "\". Keeping the current format");
-                return;
+                s_stop = false;
+                s_thread = std::thread(threadLoop);
             }
-
-            s_timeFormat = format;
         }
-        catch (const std::exception &e)
+        s_condition.notify_one();
+    }
+
+    void FileArchiver::stop()
+    {
         {
-            std::stringstream message;
-            message << "[logcoe] ERROR: Exception while validating time format: " << e.what();
-            writeToOutputs(message.str());
+            std::lock_guard<std::mutex> lock(s_mutex);
+            if (!s_thread.joinable())
+                return;
+            s_stop = true;
         }
+        s_condition.notify_one();
+        s_thread.join();
     }
 
-    bool LoggerImpl::isInitialized()
+    void FileArchiver::threadLoop()
     {
-        std::lock_guard<std::mutex> lock(s_mutex);
+        std::unique_lock<std::mutex> lock(s_mutex);
+        for (;;)
+        {
+            s_condition.wait(lock, [] { return s_stop || !s_jobs.empty(); });
+            if (s_jobs.empty())
+                return;
 
-        return s_initCounter > 0;
-    }
+            ArchiveJob job = std::move(s_jobs.front());
+            s_jobs.pop_front();
+            lock.unlock();
 
-    LogLevel LoggerImpl::getLogLevel()
-    {
-        std::lock_guard<std::mutex> lock(s_mutex);
+            compress(job.rotatedFile, job.compression);
+            prune(job.activeFile, job.maxFiles);
 
-        return s_logLevel;
+            lock.lock();
+        }
     }
 
-    void LoggerImpl::debug(const std::string &message, const std::string &source, bool flush)
+    // failures leave the rotated file uncompressed, the archiver has no output of its own to report them
+    void FileArchiver::compress(const std::string &file, Compression compression)
     {
-        log(LogLevel::DEBUG, message, source.empty() ? s_defaultSource : source, flush);
-    }
+        std::string target;
+        bool compressed = false;
+        switch (compression)
+        {
+        case Compression::GZIP:
+#ifdef LOGCOE_HAS_ZLIB
+            target = file + ".gz";
+            compressed = gzipFile(file, target);
+#endif
+            break;
+        case Compression::ZSTD:
+#ifdef LOGCOE_HAS_ZSTD
+            target = file + ".zst";
+            compressed = zstdFile(file, target);
+#endif
+            break;
+        default:
+            break;
+        }
+        if (target.empty())
+            return;
 
-    void LoggerImpl::info(const std::string &message, const std::string &source, bool flush)
-    {
-        log(LogLevel::INFO, message, source.empty() ? s_defaultSource : source, flush);
+        std::error_code error;
+        std::filesystem::remove(compressed ? file : target, error);
     }
 
-    void LoggerImpl::warning(const std::string &message, const std::string &source, bool flush)
+    void FileArchiver::prune(const std::string &activeFile, std::size_t maxFiles)
     {
-        log(LogLevel::WARNING, message, source.empty() ? s_defaultSource : source, flush);
-    }
+        if (maxFiles == 0)
+            return;
 
-    void LoggerImpl::error(const std::string &message, const std::string &source, bool flush)
-    {
-        log(LogLevel::ERROR, message, source.empty() ? s_defaultSource : source, flush);
+        std::filesystem::path active(activeFile);
+        std::filesystem::path directory = active.has_parent_path() ? active.parent_path() : std::filesystem::path(".");
+        std::string stem = active.stem().string();
+        std::string extension = active.extension().string();
+
+        std::error_code error;
+        std::vector<std::filesystem::path> rotated;
+        for (const auto &entry : std::filesystem::directory_iterator(directory, error))
+        {
+            if (entry.is_regular_file(error) && isRotatedName(entry.path().filename().string(), stem, extension))
+                rotated.push_back(entry.path());
+        }
+
+        if (rotated.size() <= maxFiles)
+            return;
+
+        // the timestamp and sequence in the name sort oldest first
+        std::sort(rotated.begin(), rotated.end(),
+                  [](const std::filesystem::path &a, const std::filesystem::path &b)
+                  { return a.filename().string() < b.filename().string(); });
+        for (std::size_t i = 0; i + maxFiles < rotated.size(); ++i)
+            std::filesystem::remove(rotated[i], error);
     }
 
-    void LoggerImpl::flush()
+    bool decodeBinaryFile(const std::string &filename, std::ostream &out)
     {
-        if(s_initCounter == 0) return;
-        if (s_useConsole && s_consoleStream)
-            s_consoleStream->flush();
-        if (s_useFile && s_fileStream.is_open())
-            s_fileStream.flush();
+        std::ifstream file(filename, std::ios::binary);
+        if (!file.is_open())
+            return false;
+
+        std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (data.size() < sizeof(binaryMagic) ||
+            data.compare(0, sizeof(binaryMagic), binaryMagic, sizeof(binaryMagic)) != 0)
+            return false;
+
+        TimestampFormatter timestamps("%d/%m/%Y__%H:%M:%S");
+        std::vector<std::unique_ptr<BinaryFormat>> formats;
+        LogRecord record;
+        std::string line;
+
+        const char *cursor = data.data() + sizeof(binaryMagic);
+        const char *end = data.data() + data.size();
+        while (cursor < end)
+        {
+            char type = *cursor++;
+            if (type == binaryConfigEntry)
+            {
+                std::uint8_t precision;
+                std::uint16_t length;
+                std::string_view format;
+                if (!readBinary(cursor, end, precision) || !readBinary(cursor, end, length) ||
+                    !readBinaryString(cursor, end, length, format))
+                    return false;
+                timestamps.setFormat(std::string(format), static_cast<TimePrecision>(precision));
+            }
+            else if (type == binaryFormatEntry)
+            {
+                std::uint32_t id;
+                std::uint8_t level;
+                std::int32_t lineNumber;
+                std::uint16_t fileLength;
+                std::uint32_t formatLength;
+                std::uint8_t argumentCount;
+                std::string_view fileText;
+                std::string_view formatText;
+                if (!readBinary(cursor, end, id) || !readBinary(cursor, end, level) ||
+                    !readBinary(cursor, end, lineNumber) || !readBinary(cursor, end, fileLength) ||
+                    !readBinaryString(cursor, end, fileLength, fileText) || !readBinary(cursor, end, formatLength) ||
+                    !readBinaryString(cursor, end, formatLength, formatText) || !readBinary(cursor, end, argumentCount))
+                    return false;
+
+                auto entry = std::make_unique<BinaryFormat>();
+                entry->level = static_cast<LogLevel>(level);
+                entry->file = std::string(fileText);
+                entry->location = SourceLocation{entry->file.c_str(), lineNumber, ""};
+                entry->format = std::string(formatText);
+                entry->argumentCount = argumentCount;
+                if (formats.size() <= id)
+                    formats.resize(id + 1);
+                formats[id] = std::move(entry);
+            }
+            else if (type == binaryRecordEntry)
+            {
+                if (!decodeBinaryRecord(cursor, end, formats, record))
+                    return false;
+                formatLine(line, timestamps, OutputFormat::TEXT, record.level, record.time, record.source,
+                           record.location, record.message);
+                out << line << '\n';
+            }
+            else
+                return false;
+        }
+
+        out.flush();
+        return true;
     }
 }
 
 namespace logcoe
 {
     void initialize(LogLevel level, const std::string &defaultSource, bool enableConsole,
-                    bool enableFile, const std::string &filename) { LoggerImpl::initialize(level, defaultSource, enableConsole, enableFile, filename); }
+                    bool enableFile, const std::string &filename, const AsyncOptions &async)
+    {
+        LoggerImpl::initialize(level, defaultSource, enableConsole, enableFile, filename, async);
+    }
 
     void shutdown() { LoggerImpl::shutdown(); }
 
@@ -365,15 +5665,286 @@ namespace logcoe
     bool setFileOutput(const std::string &filename) { return LoggerImpl::setFileOutput(filename); }
     void disableConsoleOutput() { LoggerImpl::disableConsoleOutput(); }
     void disableFileOutput() { LoggerImpl::disableFileOutput(); }
-    void setTimeFormat(const std::string &format) { LoggerImpl::setTimeFormat(format); }
+    void setTimeFormat(const std::string &format, TimePrecision precision) { LoggerImpl::setTimeFormat(format, precision); }
+    void setFileRotation(const RotationOptions &options) { LoggerImpl::setFileRotation(options); }
+    void setFlushPolicy(const FlushPolicy &policy) { LoggerImpl::setFlushPolicy(policy); }
+    void setOutputFormat(OutputFormat format) { LoggerImpl::setOutputFormat(format); }
+    void setLayout(const std::string &pattern) { LoggerImpl::setLayout(pattern); }
+
+    Source source(std::string_view name) { return Source(LoggerImpl::internSource(name)); }
+    void Source::setLevel(LogLevel level) const { LoggerImpl::setSourceLevel(*m_state, true, level); }
+    void Source::resetLevel() const { LoggerImpl::setSourceLevel(*m_state, false, LogLevel::NONE); }
+    LogLevel Source::getLevel() const { return LoggerImpl::getSourceLevel(*m_state); }
+
+    std::shared_ptr<Sink> makeFileSink(const std::string &filename, bool syncOnFlush)
+    {
+        auto sink = std::make_shared<FileSink>(filename, syncOnFlush);
+        return sink->isOpen() ? sink : nullptr;
+    }
+
+    std::shared_ptr<Sink> makeMappedFileSink(const std::string &filename, std::size_t segmentSize, bool syncOnFlush)
+    {
+#ifdef _WIN32
+        static_cast<void>(segmentSize);
+        return makeFileSink(filename, syncOnFlush);
+#else
+        auto sink = std::make_shared<MappedFileSink>(filename, segmentSize, syncOnFlush);
+        return sink->isOpen() ? sink : nullptr;
+#endif
+    }
+
+    std::shared_ptr<Sink> makeUringFileSink(const std::string &filename, bool syncOnFlush, std::size_t bufferSize,
+                                            std::size_t buffers)
+    {
+#ifdef LOGCOE_HAS_IO_URING
+        auto sink = std::make_shared<UringFileSink>(filename, syncOnFlush, bufferSize, buffers);
+        if (sink->isOpen())
+            return sink;
+#else
+        static_cast<void>(bufferSize);
+        static_cast<void>(buffers);
+#endif
+        return makeFileSink(filename, syncOnFlush);
+    }
+
+    std::shared_ptr<Sink> makeStreamSink(std::ostream &stream) { return std::make_shared<StreamSink>(stream); }
+
+    std::shared_ptr<Sink> makeSocketSink(const std::string &path, const SocketOptions &options)
+    {
+#ifdef _WIN32
+        static_cast<void>(path);
+        static_cast<void>(options);
+        return nullptr;
+#else
+        sockaddr_un address{};
+        if (path.empty() || path.size() >= sizeof(address.sun_path))
+            return nullptr;
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, path.data(), path.size());
+        return std::make_shared<SocketSink>(address, options);
+#endif
+    }
+    SinkId addSink(std::shared_ptr<Sink> sink, const SinkOptions &options)
+    {
+        return LoggerImpl::addSink(std::move(sink), options);
+    }
+    bool removeSink(SinkId id) { return LoggerImpl::removeSink(id); }
+    bool setSinkLevel(SinkId id, LogLevel level) { return LoggerImpl::setSinkLevel(id, level); }
 
     bool isInitialized() { return LoggerImpl::isInitialized(); }
     LogLevel getLogLevel() { return LoggerImpl::getLogLevel(); }
+    bool isAsync() { return LoggerImpl::isAsync(); }
+    std::uint64_t getDroppedMessageCount() { return LoggerImpl::getDroppedMessageCount(); }
+    LogStats getStats() { return LoggerImpl::getStats(); }
+    void setCrashHandler(bool enabled) { LoggerImpl::setCrashHandler(enabled); }
+    void setFlightRecorder(const FlightRecorderOptions &options) { LoggerImpl::setFlightRecorder(options); }
+    void dumpRecent() { LoggerImpl::dumpRecent(); }
+    bool startCollector(const std::string &name, const SharedLogOptions &options)
+    {
+        return LoggerImpl::startCollector(name, options);
+    }
+    void stopCollector() { LoggerImpl::stopCollector(); }
+    bool setSharedOutput(const std::string &name) { return LoggerImpl::setSharedOutput(name); }
+    void disableSharedOutput() { LoggerImpl::disableSharedOutput(); }
+    void setStatsReport(std::chrono::milliseconds interval, SinkId sink) { LoggerImpl::setStatsReport(interval, sink); }
+    bool isCompressionSupported(Compression compression) { return FileArchiver::supports(compression); }
 
-    void debug(const std::string &message, const std::string &source, bool flush) { LoggerImpl::debug(message, source, flush); }
-    void info(const std::string &message, const std::string &source, bool flush) { LoggerImpl::info(message, source, flush); }
-    void warning(const std::string &message, const std::string &source, bool flush) { LoggerImpl::warning(message, source, flush); }
-    void error(const std::string &message, const std::string &source, bool flush) { LoggerImpl::error(message, source, flush); }
     void flush() { LoggerImpl::flush(); }
 
-} // namespace logcoe
\ No newline at end of file
+    bool setBinaryOutput(const std::string &filename) { return BinaryLogger::setOutput(filename); }
+    void disableBinaryOutput() { BinaryLogger::disableOutput(); }
+    bool decodeBinaryLog(const std::string &filename, std::ostream &out) { return decodeBinaryFile(filename, out); }
+
+    namespace detail
+    {
+        std::atomic<LogLevel> activeLevel{LogLevel::NONE};
+        std::atomic<LogLevel> outputLevel{LogLevel::NONE};
+
+        void log(LogLevel level, std::string_view message, std::string_view source, bool flush)
+        {
+            // info("user={}", name) with a string name picks this overload, so a message with a placeholder and a
+            // source is most likely a format call that lost its arguments
+            if (!source.empty() && message.find('{') != std::string_view::npos && countPlaceholders(message) > 0)
+                LoggerImpl::warnUnformattedMessage(message, source);
+            LoggerImpl::log(level, message, source, flush);
+        }
+
+        void logAt(LogLevel level, const SourceLocation &location, std::string_view message, bool flush)
+        {
+            LoggerImpl::log(level, message, std::string_view(), flush, &location);
+        }
+
+        void logFields(LogLevel level, std::string_view message, const Field *fields, std::size_t count,
+                       std::string_view source, bool flush)
+        {
+            LoggerImpl::log(level, message, source, flush, nullptr, fields, count);
+        }
+
+        void logSource(LogLevel level, const SourceState &source, std::string_view message, bool flush,
+                       const Field *fields, std::size_t count)
+        {
+            LoggerImpl::log(level, message, std::string_view(), flush, nullptr, fields, count, &source);
+        }
+
+        void logFormatted(LogLevel level, const SourceLocation *location, std::string_view format,
+                          const FormatArgument *arguments, std::size_t count, const SourceState *source)
+        {
+            if (LoggerImpl::recordFormatted(level, location, format, arguments, count, source))
+                return;
+
+            // reused by every formatted call on this thread, so steady-state formatting does not allocate. A call
+            // made while formatting (an argument whose operator<< logs) formats after the outer message, like a
+            // nested LogStream, and leaves the buffer as it found it.
+            thread_local std::string buffer;
+            std::size_t start = buffer.size();
+            if (!formatTo(buffer, format, arguments, count))
+                LoggerImpl::warnFormatMismatch(format, count);
+            LoggerImpl::log(level, std::string_view(buffer).substr(start), std::string_view(), true, location,
+                            nullptr, 0, source);
+            buffer.resize(start);
+        }
+
+        std::string &streamBuffer()
+        {
+            thread_local std::string buffer;
+            return buffer;
+        }
+
+        // Everything the stream appended after start is one record, nested streams end before their outer one
+        void logStream(LogLevel level, const SourceLocation &location, std::size_t start)
+        {
+            std::string &buffer = streamBuffer();
+            LoggerImpl::log(level, std::string_view(buffer).substr(start), std::string_view(), true, &location);
+            buffer.resize(start);
+        }
+
+        void logLimited(LogLevel level, const SourceLocation &location, LogLimiter &limiter, std::string_view format,
+                        const FormatArgument *arguments, std::size_t count, bool flush)
+        {
+            // nested calls share the buffer like in logFormatted()
+            thread_local std::string buffer;
+            std::size_t start = buffer.size();
+            std::string_view message = format;
+            if (count > 0)
+            {
+                if (!formatTo(buffer, format, arguments, count))
+                    LoggerImpl::warnFormatMismatch(format, count);
+                message = std::string_view(buffer).substr(start);
+            }
+
+            std::uint64_t repeats = 0;
+            if (limiter.suppressesDuplicates())
+            {
+                // FNV-1a, zero is kept free for "no previous message"
+                std::uint64_t hash = 14695981039346656037ull;
+                for (unsigned char c : message)
+                    hash = (hash ^ c) * 1099511628211ull;
+                if (!limiter.admitMessage(hash | 1, repeats))
+                {
+                    buffer.resize(start);
+                    return;
+                }
+            }
+
+            std::uint64_t dropped = limiter.takeSuppressed();
+            if (dropped > 0)
+                LoggerImpl::log(level, "[logcoe] suppressed " + std::to_string(dropped) + " messages (rate limit)",
+                                std::string_view(), false, &location);
+            if (repeats > 0)
+                LoggerImpl::log(level, "[logcoe] suppressed " + std::to_string(repeats) + " repeats",
+                                std::string_view(), false, &location);
+            LoggerImpl::log(level, message, std::string_view(), flush, &location);
+            buffer.resize(start);
+        }
+
+        bool formatTo(std::string &out, std::string_view format, const FormatArgument *arguments, std::size_t count)
+        {
+            std::size_t next = 0;
+            std::size_t literalStart = 0;
+            bool unmatched = false;
+            for (std::size_t i = 0; i < format.size(); ++i)
+            {
+                char current = format[i];
+                if ((current != '{' && current != '}') || i + 1 >= format.size())
+                    continue;
+
+                char following = format[i + 1];
+                if (following == current)
+                {
+                    // "{{" and "}}" print a single brace
+                    out.append(format.data() + literalStart, i + 1 - literalStart);
+                    literalStart = i + 2;
+                    ++i;
+                }
+                else if (current == '{' && following == '}' && next < count)
+                {
+                    out.append(format.data() + literalStart, i - literalStart);
+                    arguments[next].append(out, arguments[next].value);
+                    ++next;
+                    literalStart = i + 2;
+                    ++i;
+                }
+                else if (current == '{' && following == '}')
+                {
+                    // no argument left, the placeholder stays in the text
+                    unmatched = true;
+                    ++i;
+                }
+            }
+            out.append(format.data() + literalStart, format.size() - literalStart);
+            return !unmatched && next == count;
+        }
+
+        void appendValue(std::string &out, bool value) { out += value ? "true" : "false"; }
+
+        void appendValue(std::string &out, char value) { out += value; }
+
+        void appendValue(std::string &out, long long value)
+        {
+            char buffer[24];
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            out.append(buffer, result.ptr);
+        }
+
+        void appendValue(std::string &out, unsigned long long value)
+        {
+            char buffer[24];
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            out.append(buffer, result.ptr);
+        }
+
+        void appendValue(std::string &out, double value)
+        {
+            // same output as operator<< with default stream flags
+            char buffer[32];
+            int length = std::snprintf(buffer, sizeof(buffer), "%g", value);
+            if (length > 0)
+                out.append(buffer, std::min(static_cast<std::size_t>(length), sizeof(buffer) - 1));
+        }
+
+        void appendValue(std::string &out, const void *value)
+        {
+            char buffer[2 + 2 * sizeof(std::uintptr_t)] = {'0', 'x'};
+            auto result = std::to_chars(buffer + 2, buffer + sizeof(buffer), reinterpret_cast<std::uintptr_t>(value), 16);
+            out.append(buffer, result.ptr);
+        }
+
+        void appendValue(std::string &out, const char *value) { out += value ? value : "(null)"; }
+
+        void appendValue(std::string &out, std::string_view value) { out.append(value.data(), value.size()); }
+
+        std::uint32_t registerBinaryFormat(LogLevel level, const SourceLocation &location, std::string_view format,
+                                           std::size_t argumentCount)
+        {
+            return BinaryLogger::registerFormat(level, location, format, argumentCount);
+        }
+
+        char *beginBinaryRecord(std::uint32_t formatId, std::size_t payloadSize)
+        {
+            return BinaryLogger::beginRecord(formatId, payloadSize);
+        }
+
+        void endBinaryRecord() { BinaryLogger::endRecord(); }
+    } // namespace detail
+
+} // namespace logcoe
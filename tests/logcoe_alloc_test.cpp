@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+#include <logcoe.hpp>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+// Counts every heap allocation of the test binary while counting is switched on
+namespace
+{
+    std::atomic<bool> counting{false};
+    std::atomic<std::size_t> allocations{0};
+
+    void *allocate(std::size_t size)
+    {
+        if (counting.load(std::memory_order_relaxed))
+            allocations.fetch_add(1, std::memory_order_relaxed);
+        if (void *memory = std::malloc(size ? size : 1))
+            return memory;
+        throw std::bad_alloc();
+    }
+}
+
+void *operator new(std::size_t size) { return allocate(size); }
+void *operator new[](std::size_t size) { return allocate(size); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    try { return allocate(size); } catch (...) { return nullptr; }
+}
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    try { return allocate(size); } catch (...) { return nullptr; }
+}
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete[](void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void *memory, std::size_t) noexcept { std::free(memory); }
+
+class LogcoeAllocTest : public ::testing::Test
+{
+protected:
+    class CountingSink : public logcoe::Sink
+    {
+    public:
+        std::atomic<std::size_t> bytes{0};
+        void write(std::string_view lines) override { bytes.fetch_add(lines.size(), std::memory_order_relaxed); }
+    };
+
+    std::shared_ptr<CountingSink> sink = std::make_shared<CountingSink>();
+
+    void SetUp() override
+    {
+        while(logcoe::isInitialized()) { logcoe::shutdown(); }
+    }
+
+    void TearDown() override
+    {
+        counting = false;
+        while(logcoe::isInitialized()) { logcoe::shutdown(); }
+    }
+
+    static void logMessages(int count)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            logcoe::info("order {} filled at {} by {}", i, 101.25, "a counterparty name longer than SSO");
+            logcoe::info("request done", {{"status", 200}, {"path", "/orders/submit"}, {"ms", 3.25}});
+            logcoe::warning("connection accepted from the load balancer health check", "network", false);
+            logcoe::info(std::string_view("a string_view message longer than the small buffer"));
+            LOGCOE_STREAM(INFO) << "stream record " << i << " at " << 0.5 << " from the stream builder";
+            logcoe::debug("debug {}", i);
+        }
+    }
+
+    // steady state: every buffer, queue cell and thread record has grown to its working size
+    static std::size_t allocationsWhile(int count)
+    {
+        logMessages(count);
+        logcoe::flush();
+
+        allocations = 0;
+        counting = true;
+        logMessages(count);
+        counting = false;
+        return allocations.load();
+    }
+};
+
+TEST_F(LogcoeAllocTest, SynchronousLoggingDoesNotAllocate)
+{
+    logcoe::initialize(logcoe::LogLevel::INFO, "", false, false);
+    logcoe::addSink(sink);
+
+    EXPECT_EQ(allocationsWhile(5000), 0u);
+
+    logcoe::flush();
+    EXPECT_GT(sink->bytes.load(), 0u);
+}
+
+TEST_F(LogcoeAllocTest, CustomLayoutDoesNotAllocate)
+{
+    logcoe::initialize(logcoe::LogLevel::INFO, "", false, false);
+    logcoe::addSink(sink);
+    logcoe::setLayout("%d %-7L %n %t [%S] %m");
+
+    EXPECT_EQ(allocationsWhile(5000), 0u);
+}
+
+TEST_F(LogcoeAllocTest, FlightRecorderDoesNotAllocate)
+{
+    logcoe::initialize(logcoe::LogLevel::INFO, "", false, false);
+    logcoe::addSink(sink);
+    logcoe::FlightRecorderOptions recorder;
+    recorder.records = 64;
+    logcoe::setFlightRecorder(recorder);
+
+    // the DEBUG records of logMessages() go to the ring, whose slots are reused lap after lap
+    EXPECT_EQ(allocationsWhile(5000), 0u);
+    EXPECT_GT(logcoe::getStats().recorded, 0u);
+}
+
+TEST_F(LogcoeAllocTest, AsyncLoggingDoesNotAllocate)
+{
+    logcoe::AsyncOptions async;
+    async.enabled = true;
+    async.queueCapacity = 64;
+    logcoe::initialize(logcoe::LogLevel::INFO, "", false, false, "logcoe.log", async);
+    logcoe::addSink(sink);
+
+    // the writer thread formats while the producer logs, its allocations are counted as well
+    EXPECT_EQ(allocationsWhile(5000), 0u);
+
+    logcoe::flush();
+    EXPECT_GT(sink->bytes.load(), 0u);
+}
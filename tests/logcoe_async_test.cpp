@@ -0,0 +1,261 @@
+#include <gtest/gtest.h>
+#include <logcoe.hpp>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // stringbuf that holds every write until it is opened, simulating a stalled sink
+    class GatedBuffer : public std::stringbuf
+    {
+        std::atomic<bool> m_open{false};
+
+        void waitForOpen()
+        {
+            while (!m_open.load())
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+    protected:
+        int overflow(int c) override
+        {
+            waitForOpen();
+            return std::stringbuf::overflow(c);
+        }
+
+        std::streamsize xsputn(const char *s, std::streamsize n) override
+        {
+            waitForOpen();
+            return std::stringbuf::xsputn(s, n);
+        }
+
+    public:
+        void open() { m_open.store(true); }
+    };
+}
+
+class LogcoeAsyncTest : public ::testing::Test
+{
+protected:
+    std::string testFilename;
+    std::stringstream testStream;
+
+    void SetUp() override
+    {
+        testFilename = "async_test_" + std::to_string(std::chrono::system_clock::now().time_since_epoch().count()) + ".log";
+
+        while(logcoe::isInitialized()) { logcoe::shutdown(); }
+    }
+
+    void TearDown() override
+    {
+        while(logcoe::isInitialized()) { logcoe::shutdown(); }
+
+        if (std::filesystem::exists(testFilename))
+            std::filesystem::remove(testFilename);
+    }
+
+    static logcoe::AsyncOptions asyncOptions(std::size_t capacity, logcoe::OverflowPolicy policy)
+    {
+        logcoe::AsyncOptions options;
+        options.enabled = true;
+        options.queueCapacity = capacity;
+        options.overflowPolicy = policy;
+        return options;
+    }
+
+    int countLines(const std::string &content, const std::string &pattern)
+    {
+        std::istringstream stream(content);
+        std::string line;
+        int count = 0;
+
+        while (std::getline(stream, line))
+        {
+            if (line.find(pattern) != std::string::npos)
+                count++;
+        }
+
+        return count;
+    }
+};
+
+TEST_F(LogcoeAsyncTest, FlushDrainsQueue)
+{
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", true, false, "logcoe.log",
+                       asyncOptions(64, logcoe::OverflowPolicy::BLOCK));
+    logcoe::setConsoleOutput(testStream);
+    EXPECT_TRUE(logcoe::isAsync());
+
+    for (int i = 0; i < 500; i++)
+        logcoe::info("Async message " + std::to_string(i), "Async", false);
+
+    logcoe::flush();
+
+    EXPECT_EQ(countLines(testStream.str(), "[INFO] [Async]: Async message"), 500);
+    EXPECT_EQ(logcoe::getDroppedMessageCount(), 0u);
+}
+
+TEST_F(LogcoeAsyncTest, ShutdownDrainsQueueToFile)
+{
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", false, true, testFilename,
+                       asyncOptions(16, logcoe::OverflowPolicy::BLOCK));
+
+    for (int i = 0; i < 200; i++)
+        logcoe::debug("Queued " + std::to_string(i), "", false);
+
+    logcoe::shutdown();
+    EXPECT_FALSE(logcoe::isAsync());
+
+    std::ifstream file(testFilename);
+    std::stringstream content;
+    content << file.rdbuf();
+    EXPECT_EQ(countLines(content.str(), "[DEBUG]: Queued"), 200);
+}
+
+TEST_F(LogcoeAsyncTest, PreservesOrderFromSingleProducer)
+{
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", true, false, "logcoe.log",
+                       asyncOptions(8, logcoe::OverflowPolicy::BLOCK));
+    logcoe::setConsoleOutput(testStream);
+
+    for (int i = 0; i < 100; i++)
+        logcoe::info("Ordered " + std::to_string(i), "", false);
+    logcoe::flush();
+
+    std::istringstream stream(testStream.str());
+    std::string line;
+    int expected = 0;
+    while (std::getline(stream, line))
+    {
+        auto pos = line.find("Ordered ");
+        if (pos == std::string::npos)
+            continue;
+        EXPECT_EQ(std::stoi(line.substr(pos + 8)), expected);
+        expected++;
+    }
+    EXPECT_EQ(expected, 100);
+}
+
+TEST_F(LogcoeAsyncTest, DropNewestWhenWriterStalls)
+{
+    GatedBuffer gate;
+    std::ostream gatedStream(&gate);
+
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", true, false, "logcoe.log",
+                       asyncOptions(4, logcoe::OverflowPolicy::DROP_NEWEST));
+    logcoe::setConsoleOutput(gatedStream);
+
+    const int total = 100;
+    for (int i = 0; i < total; i++)
+        logcoe::info("Storm " + std::to_string(i), "", false);
+
+    gate.open();
+    logcoe::flush();
+
+    int written = countLines(gate.str(), "Storm ");
+    EXPECT_GT(logcoe::getDroppedMessageCount(), 0u);
+    EXPECT_EQ(written + static_cast<int>(logcoe::getDroppedMessageCount()), total);
+    EXPECT_NE(gate.str().find("Storm 0"), std::string::npos);
+
+    // the gated stream lives on this stack frame, the logger must let go of it first
+    logcoe::shutdown();
+}
+
+TEST_F(LogcoeAsyncTest, DropOldestKeepsLatestRecords)
+{
+    GatedBuffer gate;
+    std::ostream gatedStream(&gate);
+
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", true, false, "logcoe.log",
+                       asyncOptions(4, logcoe::OverflowPolicy::DROP_OLDEST));
+    logcoe::setConsoleOutput(gatedStream);
+
+    const int total = 100;
+    for (int i = 0; i < total; i++)
+        logcoe::info("Storm " + std::to_string(i), "", false);
+
+    gate.open();
+    logcoe::flush();
+
+    int written = countLines(gate.str(), "Storm ");
+    EXPECT_GT(logcoe::getDroppedMessageCount(), 0u);
+    EXPECT_EQ(written + static_cast<int>(logcoe::getDroppedMessageCount()), total);
+    EXPECT_NE(gate.str().find("Storm " + std::to_string(total - 1)), std::string::npos);
+
+    // the gated stream lives on this stack frame, the logger must let go of it first
+    logcoe::shutdown();
+}
+
+TEST_F(LogcoeAsyncTest, ConcurrentProducersBlockPolicy)
+{
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", false, true, testFilename,
+                       asyncOptions(32, logcoe::OverflowPolicy::BLOCK));
+
+    const int numThreads = 8;
+    const int messagesPerThread = 500;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; t++)
+    {
+        threads.emplace_back([t, messagesPerThread]()
+        {
+            std::string source = "Producer-" + std::to_string(t);
+            for (int i = 0; i < messagesPerThread; i++)
+                logcoe::info("Message " + std::to_string(i), source, false);
+        });
+    }
+
+    for (auto &thread : threads)
+        thread.join();
+
+    logcoe::flush();
+
+    std::ifstream file(testFilename);
+    std::stringstream content;
+    content << file.rdbuf();
+    for (int t = 0; t < numThreads; t++)
+        EXPECT_EQ(countLines(content.str(), "[Producer-" + std::to_string(t) + "]"), messagesPerThread);
+    EXPECT_EQ(logcoe::getDroppedMessageCount(), 0u);
+}
+
+TEST_F(LogcoeAsyncTest, ShutdownWaitsForProducersStillPushing)
+{
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", false, true, testFilename,
+                       asyncOptions(8, logcoe::OverflowPolicy::BLOCK));
+
+    // producers keep the small queue full, so some of them wait for room while shutdown() runs
+    std::atomic<bool> running{true};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&running]()
+        {
+            while (running.load())
+                logcoe::info("Before shutdown", "", false);
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    logcoe::shutdown();
+    running = false;
+    for (auto &thread : threads)
+        thread.join();
+
+    // nothing of the first session is left in the queue for the next one, which starts over with a new file
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", false, true, testFilename,
+                       asyncOptions(8, logcoe::OverflowPolicy::BLOCK));
+    logcoe::info("After restart");
+    logcoe::flush();
+
+    std::ifstream file(testFilename);
+    std::stringstream content;
+    content << file.rdbuf();
+    EXPECT_EQ(countLines(content.str(), "Before shutdown"), 0);
+    EXPECT_EQ(countLines(content.str(), "After restart"), 1);
+}
@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include <logcoe.hpp>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+class LogcoeBinaryTest : public ::testing::Test
+{
+protected:
+    std::string testFilename;
+    std::stringstream testStream;
+
+    void SetUp() override
+    {
+        testFilename = "binary_test_" + std::to_string(std::chrono::system_clock::now().time_since_epoch().count()) + ".bin";
+
+        while(logcoe::isInitialized()) { logcoe::shutdown(); }
+    }
+
+    void TearDown() override
+    {
+        while(logcoe::isInitialized()) { logcoe::shutdown(); }
+
+        if (std::filesystem::exists(testFilename))
+            std::filesystem::remove(testFilename);
+    }
+
+    int countLines(const std::string &content, const std::string &pattern)
+    {
+        std::istringstream stream(content);
+        std::string line;
+        int count = 0;
+
+        while (std::getline(stream, line))
+        {
+            if (line.find(pattern) != std::string::npos)
+                count++;
+        }
+
+        return count;
+    }
+};
+
+TEST_F(LogcoeBinaryTest, DecodesToConfiguredOutputsOnFlush)
+{
+    logcoe::initialize(logcoe::LogLevel::DEBUG);
+    logcoe::setConsoleOutput(testStream);
+
+    std::string name = "cache";
+    LOGCOE_BINARY_INFO("{} hit ratio {} after {} lookups", name, 0.5, 1024u);
+    LOGCOE_BINARY_WARNING("flag={} code={}", true, -7);
+    logcoe::flush();
+
+    std::string output = testStream.str();
+    EXPECT_NE(output.find("[INFO] [logcoe_binary_test.cpp:"), std::string::npos);
+    EXPECT_NE(output.find("cache hit ratio 0.5 after 1024 lookups"), std::string::npos);
+    EXPECT_NE(output.find("[WARNING]"), std::string::npos);
+    EXPECT_NE(output.find("flag=true code=-7"), std::string::npos);
+}
+
+TEST_F(LogcoeBinaryTest, FileRoundTripsThroughDecoder)
+{
+    logcoe::initialize(logcoe::LogLevel::DEBUG);
+    logcoe::setConsoleOutput(testStream);
+    logcoe::setTimeFormat("%H:%M:%S", logcoe::TimePrecision::MICROSECONDS);
+    ASSERT_TRUE(logcoe::setBinaryOutput(testFilename));
+
+    for (int i = 0; i < 100; i++)
+        LOGCOE_BINARY_DEBUG("Deferred {} of {}", i, "batch");
+    logcoe::shutdown();
+
+    EXPECT_EQ(countLines(testStream.str(), "Deferred"), 0);
+
+    std::stringstream decoded;
+    ASSERT_TRUE(logcoe::decodeBinaryLog(testFilename, decoded));
+    EXPECT_EQ(countLines(decoded.str(), "[DEBUG] [logcoe_binary_test.cpp:"), 100);
+    EXPECT_NE(decoded.str().find("Deferred 0 of batch"), std::string::npos);
+    EXPECT_NE(decoded.str().find("Deferred 99 of batch"), std::string::npos);
+
+    // HH:MM:SS.uuuuuu
+    std::string firstLine = decoded.str().substr(0, decoded.str().find('\n'));
+    EXPECT_EQ(firstLine.find(']'), 16u);
+}
+
+TEST_F(LogcoeBinaryTest, ConcurrentThreadsKeepPerThreadOrder)
+{
+    logcoe::initialize(logcoe::LogLevel::DEBUG);
+    ASSERT_TRUE(logcoe::setBinaryOutput(testFilename));
+
+    const int numThreads = 4;
+    const int messagesPerThread = 1000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; t++)
+    {
+        threads.emplace_back([t, messagesPerThread]()
+        {
+            for (int i = 0; i < messagesPerThread; i++)
+                LOGCOE_BINARY_INFO("thread {} message {}", t, i);
+        });
+    }
+
+    for (auto &thread : threads)
+        thread.join();
+    logcoe::disableBinaryOutput();
+
+    std::stringstream decoded;
+    ASSERT_TRUE(logcoe::decodeBinaryLog(testFilename, decoded));
+
+    std::vector<int> next(numThreads, 0);
+    std::istringstream stream(decoded.str());
+    std::string line;
+    while (std::getline(stream, line))
+    {
+        int thread = 0;
+        int message = 0;
+        auto pos = line.find("thread ");
+        ASSERT_NE(pos, std::string::npos);
+        ASSERT_EQ(std::sscanf(line.c_str() + pos, "thread %d message %d", &thread, &message), 2);
+        EXPECT_EQ(message, next[thread]++);
+    }
+
+    for (int t = 0; t < numThreads; t++)
+        EXPECT_EQ(next[t], messagesPerThread);
+}
+
+TEST_F(LogcoeBinaryTest, RejectsFilesWithoutHeader)
+{
+    {
+        std::ofstream file(testFilename);
+        file << "[INFO]: not a binary log\n";
+    }
+
+    std::stringstream decoded;
+    EXPECT_FALSE(logcoe::decodeBinaryLog(testFilename, decoded));
+    EXPECT_FALSE(logcoe::decodeBinaryLog("missing_" + testFilename, decoded));
+}
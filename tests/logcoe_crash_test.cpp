@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+#include <logcoe.hpp>
+#include <csignal>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#if GTEST_HAS_DEATH_TEST && !defined(_WIN32)
+
+class LogcoeCrashTest : public ::testing::Test
+{
+protected:
+    std::string testFilename;
+
+    void SetUp() override
+    {
+        GTEST_FLAG_SET(death_test_style, "threadsafe");
+        // the threadsafe death test style runs SetUp again in the child, so the name must not change
+        testFilename = std::string("crash_test_") + ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".log";
+
+        while(logcoe::isInitialized()) { logcoe::shutdown(); }
+    }
+
+    void TearDown() override
+    {
+        while(logcoe::isInitialized()) { logcoe::shutdown(); }
+
+        if (std::filesystem::exists(testFilename))
+            std::filesystem::remove(testFilename);
+    }
+
+    static std::string readFile(const std::string &path)
+    {
+        std::ifstream file(path);
+        return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    }
+
+    static std::size_t count(const std::string &text, const std::string &part)
+    {
+        std::size_t found = 0;
+        for (auto pos = text.find(part); pos != std::string::npos; pos = text.find(part, pos + 1))
+            found++;
+        return found;
+    }
+
+    // more than the staging buffer holds, so lines wait both in the file output's buffer and in staging
+    static void logBuffered(int lines)
+    {
+        const std::string padding(200, 'c');
+        for (int i = 0; i < lines; i++)
+            logcoe::info("Pending " + std::to_string(i) + " " + padding, "", false);
+    }
+};
+
+TEST_F(LogcoeCrashTest, SignalWritesBufferedLinesAndMarker)
+{
+    auto crash = [this] {
+        logcoe::initialize(logcoe::LogLevel::DEBUG, "", false, true, testFilename);
+        logcoe::FlushPolicy policy;
+        policy.bytes = 1024 * 1024;
+        logcoe::setFlushPolicy(policy);
+        logcoe::setCrashHandler(true);
+        logBuffered(120);
+        std::raise(SIGABRT);
+    };
+    // SIGABRT takes the same path as the other signals and is the one sanitizers leave alone
+    EXPECT_EXIT(crash(), ::testing::KilledBySignal(SIGABRT), "");
+
+    std::string content = readFile(testFilename);
+    for (int i = 0; i < 120; i++)
+        EXPECT_EQ(count(content, "Pending " + std::to_string(i) + " "), 1u) << i;
+    EXPECT_LT(content.find("Pending 119 "), content.find("[logcoe] FATAL: SIGABRT\n"));
+    EXPECT_EQ(content.back(), '\n');
+}
+
+TEST_F(LogcoeCrashTest, TerminateWritesOneMarker)
+{
+    auto crash = [this] {
+        logcoe::initialize(logcoe::LogLevel::DEBUG, "", false, true, testFilename);
+        logcoe::setOutputFormat(logcoe::OutputFormat::JSON);
+        logcoe::setCrashHandler(true);
+        logcoe::warning("Last words", "", false);
+        std::terminate();
+    };
+    EXPECT_EXIT(crash(), ::testing::KilledBySignal(SIGABRT), "");
+
+    std::string content = readFile(testFilename);
+    EXPECT_NE(content.find("\"message\":\"Last words\""), std::string::npos);
+    EXPECT_EQ(count(content, "[logcoe] FATAL"), 1u);
+    EXPECT_NE(content.find("{\"level\":\"ERROR\",\"message\":\"[logcoe] FATAL: std::terminate\"}\n"), std::string::npos);
+}
+
+TEST_F(LogcoeCrashTest, MappedSinkIsTrimmedAfterCrash)
+{
+    auto crash = [this] {
+        logcoe::initialize(logcoe::LogLevel::DEBUG, "", false, false);
+        logcoe::SinkOptions options;
+        options.bufferSize = 1024 * 1024;
+        logcoe::addSink(logcoe::makeMappedFileSink(testFilename, 4096), options);
+        logcoe::setCrashHandler(true);
+        logBuffered(40);
+        std::abort();
+    };
+    EXPECT_EXIT(crash(), ::testing::KilledBySignal(SIGABRT), "");
+
+    std::string content = readFile(testFilename);
+    EXPECT_EQ(content.find('\0'), std::string::npos);
+    EXPECT_NE(content.find("Pending 39 "), std::string::npos);
+    EXPECT_EQ(content.substr(content.size() - 24), "[logcoe] FATAL: SIGABRT\n");
+}
+
+TEST_F(LogcoeCrashTest, UringSinkWritesFillingBufferAfterCrash)
+{
+    auto crash = [this] {
+        logcoe::initialize(logcoe::LogLevel::DEBUG, "", false, false);
+        logcoe::addSink(logcoe::makeUringFileSink(testFilename, false, 8192, 2));
+        logcoe::setCrashHandler(true);
+        logBuffered(100);
+        std::abort();
+    };
+    EXPECT_EXIT(crash(), ::testing::KilledBySignal(SIGABRT), "");
+
+    std::string content = readFile(testFilename);
+    EXPECT_EQ(content.find('\0'), std::string::npos);
+    for (int i = 0; i < 100; i++)
+        EXPECT_EQ(count(content, "Pending " + std::to_string(i) + " "), 1u) << i;
+    EXPECT_EQ(content.substr(content.size() - 24), "[logcoe] FATAL: SIGABRT\n");
+}
+
+TEST_F(LogcoeCrashTest, ShutdownRestoresPreviousHandlers)
+{
+    std::terminate_handler terminateBefore = std::get_terminate();
+    struct sigaction before{};
+    sigaction(SIGSEGV, nullptr, &before);
+
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", false, false);
+    logcoe::setCrashHandler(true);
+    EXPECT_NE(std::get_terminate(), terminateBefore);
+
+    struct sigaction action{};
+    sigaction(SIGSEGV, nullptr, &action);
+    EXPECT_NE(action.sa_handler, before.sa_handler);
+
+    logcoe::shutdown();
+    sigaction(SIGSEGV, nullptr, &action);
+    EXPECT_EQ(action.sa_handler, before.sa_handler);
+    EXPECT_EQ(std::get_terminate(), terminateBefore);
+
+    // not installed without an initialized logger
+    logcoe::setCrashHandler(true);
+    sigaction(SIGSEGV, nullptr, &action);
+    EXPECT_EQ(action.sa_handler, before.sa_handler);
+}
+
+#endif
@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+#include <logcoe.hpp>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+class LogcoeLayoutTest : public ::testing::Test
+{
+protected:
+    std::stringstream testStream;
+
+    void SetUp() override
+    {
+        while(logcoe::isInitialized()) { logcoe::shutdown(); }
+
+        logcoe::initialize(logcoe::LogLevel::DEBUG, "", true, false);
+        logcoe::setConsoleOutput(testStream);
+        testStream.str("");
+    }
+
+    void TearDown() override
+    {
+        while(logcoe::isInitialized()) { logcoe::shutdown(); }
+    }
+
+    std::vector<std::string> takeLines()
+    {
+        std::vector<std::string> lines;
+        std::istringstream stream(testStream.str());
+        testStream.str("");
+        for (std::string line; std::getline(stream, line);)
+            lines.push_back(line);
+        return lines;
+    }
+};
+
+TEST_F(LogcoeLayoutTest, PatternPadsAndAlignsItems)
+{
+    logcoe::setLayout("%-7L|%5S|%m");
+    logcoe::warning("disk low", "io");
+    logcoe::info("started", "network-service");
+    logcoe::error("no source");
+
+    auto lines = takeLines();
+    ASSERT_EQ(lines.size(), 3u);
+    EXPECT_EQ(lines[0], "WARNING|   io|disk low");
+    EXPECT_EQ(lines[1], "INFO   |network-service|started");
+    EXPECT_EQ(lines[2], "ERROR  |     |no source");
+}
+
+TEST_F(LogcoeLayoutTest, TimeLiteralsAndFields)
+{
+    logcoe::setTimeFormat("%H:%M:%S", logcoe::TimePrecision::MILLISECONDS);
+    logcoe::setLayout("<%d> 100%% %m");
+    logcoe::info("request done", {{"status", 200}});
+
+    auto lines = takeLines();
+    ASSERT_EQ(lines.size(), 1u);
+    EXPECT_TRUE(std::regex_match(lines[0], std::regex(R"(<\d\d:\d\d:\d\d\.\d{3}> 100% request done status=200)")))
+        << lines[0];
+}
+
+TEST_F(LogcoeLayoutTest, ThreadAndLineNumbers)
+{
+    logcoe::setLayout("%n %t %m");
+    logcoe::info("first");
+    logcoe::info("second");
+    std::thread([] { logcoe::info("other"); }).join();
+
+    auto lines = takeLines();
+    ASSERT_EQ(lines.size(), 3u);
+
+    std::istringstream first(lines[0]), second(lines[1]), other(lines[2]);
+    unsigned long long sequence[3];
+    unsigned thread[3];
+    first >> sequence[0] >> thread[0];
+    second >> sequence[1] >> thread[1];
+    other >> sequence[2] >> thread[2];
+
+    EXPECT_EQ(sequence[1], sequence[0] + 1);
+    EXPECT_EQ(sequence[2], sequence[1] + 1);
+    EXPECT_EQ(thread[0], thread[1]);
+    EXPECT_NE(thread[0], thread[2]);
+}
+
+TEST_F(LogcoeLayoutTest, EachLayoutNumbersItsOwnLines)
+{
+    logcoe::setLayout("%n %m");
+    logcoe::info("first");
+    logcoe::info("second");
+    logcoe::setLayout("%n: %m");
+    logcoe::info("third");
+
+    auto lines = takeLines();
+    ASSERT_EQ(lines.size(), 3u);
+    EXPECT_EQ(lines[0], "1 first");
+    EXPECT_EQ(lines[1], "2 second");
+    EXPECT_EQ(lines[2], "1: third");
+}
+
+TEST_F(LogcoeLayoutTest, AsyncRecordsKeepTheProducerThread)
+{
+    logcoe::shutdown();
+    logcoe::AsyncOptions async;
+    async.enabled = true;
+    async.queueCapacity = 64;
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", true, false, "logcoe.log", async);
+    logcoe::setConsoleOutput(testStream);
+    logcoe::setLayout("%t %L %m");
+    testStream.str("");
+
+    logcoe::info("here");
+    std::thread([] { logcoe::info("there"); }).join();
+    logcoe::flush();
+
+    auto lines = takeLines();
+    ASSERT_EQ(lines.size(), 2u);
+    EXPECT_NE(lines[0].substr(0, lines[0].find(' ')), lines[1].substr(0, lines[1].find(' ')));
+    EXPECT_NE(lines[0].find(" INFO here"), std::string::npos) << lines[0];
+    EXPECT_NE(lines[1].find(" INFO there"), std::string::npos) << lines[1];
+
+    logcoe::shutdown();
+}
+
+TEST_F(LogcoeLayoutTest, InvalidPatternKeepsCurrentLayout)
+{
+    logcoe::setLayout("%L: %m");
+    testStream.str("");
+
+    logcoe::setLayout("%L %q %m");
+    EXPECT_NE(testStream.str().find("[logcoe] ERROR: Invalid layout \"%L %q %m\": unknown placeholder \"%q\""),
+              std::string::npos) << testStream.str();
+
+    testStream.str("");
+    logcoe::info("still");
+    EXPECT_EQ(testStream.str(), "INFO: still\n");
+
+    // empty restores the built-in layout, which only brackets a source that is present
+    logcoe::setLayout("");
+    testStream.str("");
+    logcoe::info("default");
+    EXPECT_NE(testStream.str().find("] [INFO]: default"), std::string::npos) << testStream.str();
+}
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include <logcoe.hpp>
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+class LogcoeLimitTest : public ::testing::Test
+{
+protected:
+    std::stringstream testStream;
+
+    void SetUp() override
+    {
+        while(logcoe::isInitialized()) { logcoe::shutdown(); }
+
+        logcoe::initialize(logcoe::LogLevel::DEBUG, "", true, false);
+        logcoe::setConsoleOutput(testStream);
+        testStream.str("");
+    }
+
+    void TearDown() override
+    {
+        while(logcoe::isInitialized()) { logcoe::shutdown(); }
+    }
+
+    std::size_t count(const std::string &text)
+    {
+        std::string all = testStream.str();
+        std::size_t found = 0;
+        for (auto pos = all.find(text); pos != std::string::npos; pos = all.find(text, pos + 1))
+            found++;
+        return found;
+    }
+};
+
+TEST_F(LogcoeLimitTest, EveryNthCallIsLogged)
+{
+    for (int i = 0; i < 10; i++)
+        LOGCOE_INFO_LIMITED(logcoe::LogLimit::every(4), "sampled {}", i);
+
+    EXPECT_EQ(count("sampled "), 3u);
+    EXPECT_EQ(count("sampled 0"), 1u);
+    EXPECT_EQ(count("sampled 4"), 1u);
+    EXPECT_EQ(count("sampled 8"), 1u);
+}
+
+TEST_F(LogcoeLimitTest, FirstCallsThenEveryNth)
+{
+    for (int i = 0; i < 12; i++)
+        LOGCOE_WARNING_LIMITED(logcoe::LogLimit::firstThenEvery(3, 5), "storm {}", i);
+
+    EXPECT_EQ(count("storm "), 5u);
+    EXPECT_EQ(count("storm 2"), 1u);
+    EXPECT_EQ(count("storm 3"), 1u);
+    EXPECT_EQ(count("storm 8"), 1u);
+    EXPECT_EQ(count("storm 4"), 0u);
+}
+
+TEST_F(LogcoeLimitTest, RateLimitAllowsBurstAndReportsDrops)
+{
+    // one token per 100 s, so only the burst gets through while the test runs
+    for (int i = 0; i < 50; i++)
+        LOGCOE_ERROR_LIMITED(logcoe::LogLimit::rate(0.01, 5), "limited {}", i);
+
+    EXPECT_EQ(count("limited "), 5u);
+    EXPECT_EQ(count("suppressed"), 0u);
+
+    logcoe::LogLimiter limiter(logcoe::LogLimit::rate(0.01, 2));
+    EXPECT_TRUE(limiter.allow());
+    EXPECT_TRUE(limiter.allow());
+    EXPECT_FALSE(limiter.allow());
+    EXPECT_FALSE(limiter.allow());
+    EXPECT_EQ(limiter.takeSuppressed(), 2u);
+    EXPECT_EQ(limiter.takeSuppressed(), 0u);
+}
+
+TEST_F(LogcoeLimitTest, RepeatsAreSummarisedWhenTheMessageChanges)
+{
+    auto site = [](const std::string &message) {
+        LOGCOE_INFO_LIMITED(logcoe::LogLimit::duplicates(), message);
+    };
+
+    for (int i = 0; i < 6; i++)
+        site("disk full");
+    site("disk ok");
+    site("disk ok");
+
+    EXPECT_EQ(count("disk full"), 1u);
+    EXPECT_EQ(count("disk ok"), 1u);
+    EXPECT_EQ(count("[logcoe] suppressed 5 repeats"), 1u);
+    EXPECT_LT(testStream.str().find("suppressed 5 repeats"), testStream.str().find("disk ok"));
+}
+
+TEST_F(LogcoeLimitTest, DisabledLevelSkipsTheLimiter)
+{
+    logcoe::setLogLevel(logcoe::LogLevel::WARNING);
+
+    bool evaluated = false;
+    auto expensive = [&] { evaluated = true; return 1; };
+    LOGCOE_DEBUG_LIMITED(logcoe::LogLimit::every(1), "value {}", expensive());
+
+    EXPECT_FALSE(evaluated);
+    EXPECT_TRUE(testStream.str().empty());
+}
+
+TEST_F(LogcoeLimitTest, ConcurrentCallersShareOneSiteBudget)
+{
+    logcoe::LogLimiter limiter(logcoe::LogLimit::firstThenEvery(10, 100));
+    std::atomic<int> allowed{0};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+        threads.emplace_back([&] {
+            for (int i = 0; i < 2500; i++)
+                if (limiter.allow())
+                    allowed++;
+        });
+    for (auto &thread : threads)
+        thread.join();
+
+    // calls 0..9, then 10, 110, ..., 9910
+    EXPECT_EQ(allowed.load(), 10 + 100);
+}
@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+
+// compile this file as a release build that strips everything below WARNING
+#undef LOGCOE_ACTIVE_LEVEL
+#define LOGCOE_ACTIVE_LEVEL LOGCOE_LEVEL_WARNING
+#include <logcoe.hpp>
+
+#include <sstream>
+#include <string>
+
+class LogcoeMacroTest : public ::testing::Test
+{
+protected:
+    std::stringstream testStream;
+
+    void SetUp() override
+    {
+        while(logcoe::isInitialized()) { logcoe::shutdown(); }
+    }
+
+    void TearDown() override
+    {
+        while(logcoe::isInitialized()) { logcoe::shutdown(); }
+    }
+};
+
+TEST_F(LogcoeMacroTest, StrippedLevelsDoNotEvaluateArguments)
+{
+    logcoe::initialize(logcoe::LogLevel::DEBUG);
+    logcoe::setConsoleOutput(testStream);
+
+    int evaluations = 0;
+    auto message = [&evaluations]() { evaluations++; return std::string("Stripped message"); };
+
+    LOGCOE_DEBUG(message());
+    LOGCOE_INFO(message());
+    EXPECT_EQ(evaluations, 0);
+    EXPECT_EQ(testStream.str().find("Stripped message"), std::string::npos);
+
+    LOGCOE_WARNING(message());
+    EXPECT_EQ(evaluations, 1);
+    EXPECT_NE(testStream.str().find("Stripped message"), std::string::npos);
+}
+
+TEST_F(LogcoeMacroTest, RuntimeFilteredLevelsDoNotEvaluateArguments)
+{
+    logcoe::initialize(logcoe::LogLevel::ERROR);
+    logcoe::setConsoleOutput(testStream);
+
+    int evaluations = 0;
+    auto message = [&evaluations]() { evaluations++; return std::string("Filtered message"); };
+
+    LOGCOE_WARNING(message());
+    EXPECT_EQ(evaluations, 0);
+
+    LOGCOE_ERROR(message());
+    EXPECT_EQ(evaluations, 1);
+}
+
+TEST_F(LogcoeMacroTest, SourceIsCallSiteLocation)
+{
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "DefaultSource");
+    logcoe::setConsoleOutput(testStream);
+
+    int line = __LINE__ + 1;
+    LOGCOE_ERROR("Located message");
+
+    std::string expected = "[ERROR] [logcoe_macro_test.cpp:" + std::to_string(line) + "]: Located message";
+    EXPECT_NE(testStream.str().find(expected), std::string::npos) << testStream.str();
+}
+
+TEST_F(LogcoeMacroTest, FormatArguments)
+{
+    logcoe::initialize(logcoe::LogLevel::DEBUG);
+    logcoe::setConsoleOutput(testStream);
+
+    LOGCOE_WARNING("retries={} delay={}ms", 3, 2.5);
+    LOGCOE_ERROR(LOGCOE_FMT("peer={}"), std::string("10.0.0.1"));
+
+    std::string output = testStream.str();
+    EXPECT_NE(output.find("]: retries=3 delay=2.5ms"), std::string::npos) << output;
+    EXPECT_NE(output.find("]: peer=10.0.0.1"), std::string::npos) << output;
+}
+
+TEST_F(LogcoeMacroTest, StreamBuilder)
+{
+    logcoe::initialize(logcoe::LogLevel::DEBUG);
+    logcoe::setConsoleOutput(testStream);
+
+    int evaluations = 0;
+    auto value = [&evaluations]() { evaluations++; return 42; };
+
+    LOGCOE_STREAM(DEBUG) << "stripped " << value();
+    EXPECT_EQ(evaluations, 0);
+
+    int line = __LINE__ + 1;
+    LOGCOE_STREAM(WARNING) << "answer=" << value() << " ratio=" << 0.5 << ' ' << std::string("done");
+    EXPECT_EQ(evaluations, 1);
+
+    std::string expected = "[WARNING] [logcoe_macro_test.cpp:" + std::to_string(line) + "]: answer=42 ratio=0.5 done";
+    EXPECT_NE(testStream.str().find(expected), std::string::npos) << testStream.str();
+
+    // a value whose formatting logs its own stream record, both lines come out whole
+    auto nested = []() { LOGCOE_STREAM(ERROR) << "inner " << 1; return 2; };
+    LOGCOE_STREAM(ERROR) << "outer " << nested() << " end";
+
+    std::string output = testStream.str();
+    EXPECT_NE(output.find("]: inner 1\n"), std::string::npos) << output;
+    EXPECT_NE(output.find("]: outer 2 end\n"), std::string::npos) << output;
+    EXPECT_LT(output.find("inner 1"), output.find("outer 2"));
+}
+
+TEST_F(LogcoeMacroTest, StreamRespectsRuntimeLevel)
+{
+    logcoe::initialize(logcoe::LogLevel::ERROR);
+    logcoe::setConsoleOutput(testStream);
+
+    int evaluations = 0;
+    auto value = [&evaluations]() { return ++evaluations; };
+
+    if (evaluations == 0)
+        LOGCOE_STREAM(WARNING) << "filtered " << value();
+    else
+        FAIL() << "the macro must not take over the else branch";
+
+    EXPECT_EQ(evaluations, 0);
+    EXPECT_EQ(testStream.str().find("filtered"), std::string::npos);
+}
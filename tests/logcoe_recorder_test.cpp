@@ -0,0 +1,260 @@
+#include <gtest/gtest.h>
+#include <logcoe.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+class LogcoeRecorderTest : public ::testing::Test
+{
+protected:
+    std::stringstream testStream;
+
+    void SetUp() override
+    {
+        while(logcoe::isInitialized()) { logcoe::shutdown(); }
+
+        logcoe::initialize(logcoe::LogLevel::INFO, "", true, false);
+        logcoe::setConsoleOutput(testStream);
+        testStream.str("");
+    }
+
+    void TearDown() override
+    {
+        while(logcoe::isInitialized()) { logcoe::shutdown(); }
+    }
+
+    static logcoe::FlightRecorderOptions recorder(std::size_t records)
+    {
+        logcoe::FlightRecorderOptions options;
+        options.records = records;
+        return options;
+    }
+
+    static bool inOrder(const std::string &text, std::initializer_list<const char *> parts)
+    {
+        std::size_t position = 0;
+        for (const char *part : parts)
+        {
+            position = text.find(part, position);
+            if (position == std::string::npos)
+                return false;
+        }
+        return true;
+    }
+};
+
+TEST_F(LogcoeRecorderTest, ErrorWritesRecordedHistoryFirst)
+{
+    std::uint64_t recordedBefore = logcoe::getStats().recorded;
+    logcoe::setFlightRecorder(recorder(8));
+    EXPECT_TRUE(logcoe::isEnabled(logcoe::LogLevel::DEBUG));
+
+    logcoe::debug("Opening connection");
+    logcoe::info("Request received");
+    logcoe::debug("Parsed {} headers", 12);
+    EXPECT_EQ(testStream.str().find("[DEBUG]"), std::string::npos) << testStream.str();
+
+    logcoe::error("Request failed");
+    std::string output = testStream.str();
+    EXPECT_TRUE(inOrder(output, {"[INFO]: Request received", "[logcoe] Flight recorder: 2 recent records",
+                                 "[DEBUG]: Opening connection", "[DEBUG]: Parsed 12 headers",
+                                 "[ERROR]: Request failed"}))
+        << output;
+
+    // the history went out once, the next error has none
+    testStream.str("");
+    logcoe::error("Again");
+    EXPECT_EQ(testStream.str().find("Flight recorder"), std::string::npos) << testStream.str();
+    EXPECT_EQ(logcoe::getStats().recorded - recordedBefore, 2u);
+}
+
+TEST_F(LogcoeRecorderTest, KeepsTheNewestRecordsOfEachThread)
+{
+    logcoe::setFlightRecorder(recorder(4));
+    for (int i = 0; i < 10; i++)
+        logcoe::debug("Step " + std::to_string(i));
+
+    logcoe::dumpRecent();
+    std::string output = testStream.str();
+    EXPECT_EQ(output.find("Step 5"), std::string::npos) << output;
+    EXPECT_TRUE(inOrder(output, {"recorder: 4 recent", "Step 6", "Step 7", "Step 8", "Step 9"})) << output;
+}
+
+TEST_F(LogcoeRecorderTest, DumpMergesThreadsInTimeOrder)
+{
+    logcoe::setFlightRecorder(recorder(16));
+
+    std::thread([] { logcoe::debug("First, other thread"); }).join();
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    logcoe::debug("Second, main thread");
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    std::thread([] { logcoe::debug("Third, another thread"); }).join();
+
+    logcoe::dumpRecent();
+    EXPECT_TRUE(inOrder(testStream.str(), {"First, other thread", "Second, main thread", "Third, another thread"}))
+        << testStream.str();
+}
+
+TEST_F(LogcoeRecorderTest, HistoryReachesSinksThatOnlyTakeErrors)
+{
+    class RecordingSink : public logcoe::Sink
+    {
+    public:
+        std::string text;
+        void write(std::string_view lines) override { text.append(lines); }
+    };
+
+    auto errors = std::make_shared<RecordingSink>();
+    logcoe::SinkOptions options;
+    options.level = logcoe::LogLevel::ERROR;
+    logcoe::addSink(errors, options);
+    logcoe::setLogLevel(logcoe::LogLevel::WARNING);
+
+    logcoe::FlightRecorderOptions settings = recorder(8);
+    settings.level = logcoe::LogLevel::INFO;
+    logcoe::setFlightRecorder(settings);
+    EXPECT_FALSE(logcoe::isEnabled(logcoe::LogLevel::DEBUG));
+
+    logcoe::debug("Never recorded");
+    logcoe::info("Recorded for the error sink");
+    logcoe::error("Disk full");
+
+    EXPECT_TRUE(inOrder(errors->text, {"[INFO]: Recorded for the error sink", "[ERROR]: Disk full"}))
+        << errors->text;
+    EXPECT_EQ(errors->text.find("Never recorded"), std::string::npos);
+    EXPECT_EQ(testStream.str().find("Never recorded"), std::string::npos);
+    logcoe::shutdown();
+}
+
+TEST_F(LogcoeRecorderTest, AsyncRecordsAreRecordedByTheProducer)
+{
+    logcoe::shutdown();
+    logcoe::AsyncOptions async;
+    async.enabled = true;
+    async.queueCapacity = 64;
+    logcoe::initialize(logcoe::LogLevel::INFO, "", true, false, "logcoe.log", async);
+    logcoe::setConsoleOutput(testStream);
+
+    logcoe::FlightRecorderOptions settings = recorder(8);
+    settings.trigger = logcoe::LogLevel::NONE;
+    logcoe::setFlightRecorder(settings);
+    testStream.str("");
+
+    logcoe::info("Queued");
+    logcoe::debug("Recorded");
+    logcoe::error("Not a trigger");
+    logcoe::flush();
+    EXPECT_EQ(testStream.str().find("Recorded"), std::string::npos) << testStream.str();
+
+    logcoe::dumpRecent();
+    EXPECT_TRUE(inOrder(testStream.str(), {"Queued", "Not a trigger", "[DEBUG]: Recorded"})) << testStream.str();
+    logcoe::shutdown();
+}
+
+TEST_F(LogcoeRecorderTest, ZeroRecordsTurnsTheRecorderOff)
+{
+    logcoe::setFlightRecorder(recorder(8));
+    logcoe::debug("Dropped with the recorder");
+    logcoe::setFlightRecorder(recorder(0));
+    EXPECT_FALSE(logcoe::isEnabled(logcoe::LogLevel::DEBUG));
+
+    logcoe::error("No history");
+    logcoe::dumpRecent();
+    EXPECT_EQ(testStream.str().find("Dropped with the recorder"), std::string::npos) << testStream.str();
+    EXPECT_EQ(testStream.str().find("Flight recorder"), std::string::npos) << testStream.str();
+}
+
+TEST_F(LogcoeRecorderTest, RecordsAreFormattedWhenDumped)
+{
+    logcoe::setFlightRecorder(recorder(8));
+
+    std::string user = "Ada";
+    logcoe::debug("user={} attempt={} ratio={}", user, 3, 0.5);
+    logcoe::debug("cache", {{"hit", false}, {"key", "users/7"}, {"ms", 12}});
+    user = "changed";
+
+    // the output format of the dump applies, not the one at the time of recording
+    logcoe::setOutputFormat(logcoe::OutputFormat::JSON);
+    logcoe::dumpRecent();
+    std::string output = testStream.str();
+    EXPECT_NE(output.find("\"message\":\"user=Ada attempt=3 ratio=0.5\""), std::string::npos) << output;
+    EXPECT_NE(output.find("\"message\":\"cache\",\"hit\":false,\"key\":\"users/7\",\"ms\":12}"), std::string::npos)
+        << output;
+}
+
+TEST_F(LogcoeRecorderTest, AsyncErrorDumpsOnTheWriterThread)
+{
+    logcoe::shutdown();
+    logcoe::AsyncOptions async;
+    async.enabled = true;
+    async.queueCapacity = 64;
+    logcoe::initialize(logcoe::LogLevel::INFO, "", true, false, "logcoe.log", async);
+    logcoe::setConsoleOutput(testStream);
+    logcoe::setFlightRecorder(recorder(8));
+    testStream.str("");
+
+    logcoe::debug("Before the error");
+    logcoe::info("Queued first");
+    logcoe::error("Request failed");
+    logcoe::debug("After the error");
+    logcoe::flush();
+
+    // only what was recorded before the error is its history, the rest waits for the next dump
+    std::string output = testStream.str();
+    EXPECT_TRUE(inOrder(output, {"[INFO]: Queued first", "Flight recorder: 1 recent records",
+                                 "[DEBUG]: Before the error", "[ERROR]: Request failed"}))
+        << output;
+    EXPECT_EQ(output.find("After the error"), std::string::npos) << output;
+
+    logcoe::dumpRecent();
+    EXPECT_NE(testStream.str().find("[DEBUG]: After the error"), std::string::npos) << testStream.str();
+    logcoe::shutdown();
+}
+
+TEST_F(LogcoeRecorderTest, DumpsDoNotWaitForRecordingThreads)
+{
+    logcoe::FlightRecorderOptions settings = recorder(16);
+    settings.trigger = logcoe::LogLevel::NONE;
+    logcoe::setFlightRecorder(settings);
+
+    std::atomic<bool> stop{false};
+    std::atomic<int> recording{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&stop, &recording, t] {
+            for (int i = 0; !stop.load(); i++)
+            {
+                logcoe::debug("Thread {} step {}", t, i);
+                if (i == 0)
+                    recording++;
+            }
+        });
+    }
+
+    while (recording.load() < 4)
+        std::this_thread::yield();
+    for (int i = 0; i < 50; i++)
+        logcoe::dumpRecent();
+    stop.store(true);
+    for (auto &thread : threads)
+        thread.join();
+
+    // every dumped record is whole, a slot is never read while its owner writes it
+    std::istringstream lines(testStream.str());
+    std::string line;
+    std::size_t records = 0;
+    while (std::getline(lines, line))
+    {
+        if (line.find("[DEBUG]") == std::string::npos)
+            continue;
+        EXPECT_NE(line.find("[DEBUG]: Thread "), std::string::npos) << line;
+        EXPECT_NE(line.find(" step "), std::string::npos) << line;
+        records++;
+    }
+    EXPECT_GT(records, 0u);
+}
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include <logcoe.hpp>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+class LogcoeRotationTest : public ::testing::Test
+{
+protected:
+    std::filesystem::path testDirectory;
+    std::string testFilename;
+
+    void SetUp() override
+    {
+        testDirectory = "rotation_test_" + std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
+        testFilename = (testDirectory / "app.log").string();
+
+        while(logcoe::isInitialized()) { logcoe::shutdown(); }
+    }
+
+    void TearDown() override
+    {
+        while(logcoe::isInitialized()) { logcoe::shutdown(); }
+
+        std::filesystem::remove_all(testDirectory);
+    }
+
+    std::vector<std::string> rotatedFiles()
+    {
+        std::vector<std::string> files;
+        for (const auto &entry : std::filesystem::directory_iterator(testDirectory))
+        {
+            std::string name = entry.path().filename().string();
+            if (name != "app.log")
+                files.push_back(name);
+        }
+        std::sort(files.begin(), files.end());
+        return files;
+    }
+
+    static std::string readFile(const std::filesystem::path &path)
+    {
+        std::ifstream file(path);
+        return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    }
+};
+
+TEST_F(LogcoeRotationTest, SizeLimitRotatesAndKeepsNewestFiles)
+{
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", false, true, testFilename);
+
+    logcoe::RotationOptions rotation;
+    rotation.maxBytes = 1024;
+    rotation.maxFiles = 3;
+    logcoe::setFileRotation(rotation);
+
+    for (int i = 0; i < 200; i++)
+        logcoe::info("Rotating message " + std::to_string(i));
+    logcoe::shutdown();
+
+    std::vector<std::string> files = rotatedFiles();
+    ASSERT_EQ(files.size(), 3u);
+    for (const auto &name : files)
+    {
+        EXPECT_EQ(name.rfind("app.", 0), 0u) << name;
+        EXPECT_EQ(name.size(), std::string("app.20250101-000000.000.log").size()) << name;
+        EXPECT_LE(std::filesystem::file_size(testDirectory / name), 1024u) << name;
+    }
+
+    // the newest messages are in the active file, the oldest rotated files were removed
+    EXPECT_NE(readFile(testFilename).find("Rotating message 199"), std::string::npos);
+    EXPECT_EQ(readFile(testDirectory / files.front()).find("Rotating message 0\n"), std::string::npos);
+}
+
+TEST_F(LogcoeRotationTest, IntervalRotatesOnBoundary)
+{
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", false, true, testFilename);
+
+    logcoe::RotationOptions rotation;
+    rotation.interval = std::chrono::seconds(1);
+    logcoe::setFileRotation(rotation);
+
+    logcoe::info("Before boundary");
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    logcoe::info("After boundary");
+    logcoe::flush();
+
+    std::string rotated;
+    for (const auto &name : rotatedFiles())
+        rotated += readFile(testDirectory / name);
+    EXPECT_NE(rotated.find("Before boundary"), std::string::npos);
+    EXPECT_EQ(rotated.find("After boundary"), std::string::npos);
+    EXPECT_NE(readFile(testFilename).find("After boundary"), std::string::npos);
+}
+
+TEST_F(LogcoeRotationTest, CompressesRotatedFilesInBackground)
+{
+    if (!logcoe::isCompressionSupported(logcoe::Compression::GZIP))
+        GTEST_SKIP() << "built without LOGCOE_WITH_ZLIB";
+
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", false, true, testFilename);
+
+    logcoe::RotationOptions rotation;
+    rotation.maxBytes = 512;
+    rotation.compression = logcoe::Compression::GZIP;
+    logcoe::setFileRotation(rotation);
+
+    for (int i = 0; i < 50; i++)
+        logcoe::info("Compressed message " + std::to_string(i));
+    logcoe::shutdown();
+
+    std::vector<std::string> files = rotatedFiles();
+    ASSERT_FALSE(files.empty());
+    for (const auto &name : files)
+    {
+        ASSERT_GE(name.size(), 3u);
+        EXPECT_EQ(name.substr(name.size() - 3), ".gz") << name;
+
+        std::ifstream file(testDirectory / name, std::ios::binary);
+        unsigned char magic[2] = {};
+        file.read(reinterpret_cast<char *>(magic), 2);
+        EXPECT_EQ(magic[0], 0x1f);
+        EXPECT_EQ(magic[1], 0x8b);
+    }
+}
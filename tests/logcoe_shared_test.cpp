@@ -0,0 +1,352 @@
+#include <gtest/gtest.h>
+#include <logcoe.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#ifndef _WIN32
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+class LogcoeSharedTest : public ::testing::Test
+{
+protected:
+    class RecordingSink : public logcoe::Sink
+    {
+        mutable std::mutex m_mutex;
+        std::string m_text;
+
+    public:
+        void write(std::string_view lines) override
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_text.append(lines);
+        }
+
+        std::string text() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_text;
+        }
+    };
+
+    // SharedRingHeader of src/logcoe.cpp, for playing a worker that dies between reserving and writing a line
+    struct RingHeader
+    {
+        std::atomic<std::uint32_t> magic;
+        std::uint32_t version;
+        std::uint64_t capacity;
+        alignas(64) std::atomic<std::uint64_t> head;
+        alignas(64) std::atomic<std::uint64_t> tail;
+        std::atomic<std::uint64_t> dropped;
+        std::atomic<std::uint32_t> sleeping;
+    };
+
+    std::stringstream testStream;
+    std::string name = "/logcoe-test-" + std::to_string(::getpid());
+
+    void SetUp() override
+    {
+        while(logcoe::isInitialized()) { logcoe::shutdown(); }
+
+        logcoe::initialize(logcoe::LogLevel::INFO, "", false, false);
+    }
+
+    void TearDown() override
+    {
+        while(logcoe::isInitialized()) { logcoe::shutdown(); }
+    }
+
+    // The child becomes a worker of the collector in this process, runs `work` and exits without running the
+    // test binary's exit handlers
+    template <typename Work>
+    pid_t spawnWorker(Work work)
+    {
+        pid_t pid = ::fork();
+        if (pid == 0)
+        {
+            bool attached = logcoe::setSharedOutput(name);
+            if (attached)
+                work();
+            logcoe::flush();
+            ::_exit(attached ? 0 : 1);
+        }
+        return pid;
+    }
+
+    static bool exitedCleanly(pid_t pid)
+    {
+        int status = 0;
+        return ::waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+
+    static std::size_t count(const std::string &text, const std::string &part)
+    {
+        std::size_t found = 0;
+        for (auto pos = text.find(part); pos != std::string::npos; pos = text.find(part, pos + 1))
+            found++;
+        return found;
+    }
+};
+
+TEST_F(LogcoeSharedTest, ForkedWorkersShareOneOrderedStream)
+{
+    auto sink = std::make_shared<RecordingSink>();
+    logcoe::addSink(sink);
+    ASSERT_TRUE(logcoe::startCollector(name));
+
+    constexpr int workers = 3;
+    constexpr int lines = 300;
+    pid_t pids[workers];
+    for (int worker = 0; worker < workers; worker++)
+    {
+        pids[worker] = spawnWorker([worker] {
+            for (int i = 0; i < lines; i++)
+                logcoe::info("Worker " + std::to_string(worker) + " line " + std::to_string(i));
+        });
+        ASSERT_GT(pids[worker], 0);
+    }
+    for (pid_t pid : pids)
+        EXPECT_TRUE(exitedCleanly(pid));
+
+    logcoe::stopCollector();
+    std::string text = sink->text();
+    for (int worker = 0; worker < workers; worker++)
+    {
+        std::string prefix = "Worker " + std::to_string(worker) + " line ";
+        EXPECT_EQ(count(text, prefix), static_cast<std::size_t>(lines)) << "worker " << worker;
+
+        // each worker's own lines keep their order
+        std::size_t position = 0;
+        for (int i = 0; i < lines && position != std::string::npos; i++)
+            position = text.find(prefix + std::to_string(i) + "\n", position);
+        EXPECT_NE(position, std::string::npos) << "worker " << worker;
+    }
+    EXPECT_EQ(text.find("Shared log dropped"), std::string::npos);
+}
+
+TEST_F(LogcoeSharedTest, SmallRingWrapsAroundManyTimes)
+{
+    auto sink = std::make_shared<RecordingSink>();
+    logcoe::addSink(sink);
+    logcoe::SharedLogOptions options;
+    options.capacity = 4096;
+    ASSERT_TRUE(logcoe::startCollector(name, options));
+
+    constexpr int workers = 3;
+    constexpr int lines = 2000;
+    pid_t pids[workers];
+    for (int worker = 0; worker < workers; worker++)
+    {
+        pids[worker] = spawnWorker([worker] {
+            for (int i = 0; i < lines; i++)
+                logcoe::info("Worker " + std::to_string(worker) + " line " + std::to_string(i));
+        });
+        ASSERT_GT(pids[worker], 0);
+    }
+    for (pid_t pid : pids)
+        EXPECT_TRUE(exitedCleanly(pid));
+    logcoe::stopCollector();
+
+    // every line is either written whole or counted as dropped
+    std::string text = sink->text();
+    std::size_t written = count(text, "[INFO]: Worker ");
+    std::size_t dropped = 0;
+    const std::string report = "Shared log dropped ";
+    for (auto pos = text.find(report); pos != std::string::npos; pos = text.find(report, pos + 1))
+        dropped += std::stoul(text.substr(pos + report.size()));
+    EXPECT_EQ(written + dropped, static_cast<std::size_t>(workers * lines));
+    EXPECT_GT(written, 0u);
+
+    std::istringstream stream(text);
+    int last[workers] = {-1, -1, -1};
+    for (std::string line; std::getline(stream, line);)
+    {
+        auto at = line.find("[INFO]: Worker ");
+        if (at == std::string::npos)
+            continue;
+        int worker = -1;
+        int number = -1;
+        ASSERT_EQ(std::sscanf(line.c_str() + at, "[INFO]: Worker %d line %d", &worker, &number), 2) << line;
+        ASSERT_TRUE(worker >= 0 && worker < workers) << line;
+        EXPECT_GT(number, last[worker]) << line;
+        last[worker] = number;
+    }
+}
+
+TEST_F(LogcoeSharedTest, CollectorSinksFilterByTheWorkersLevels)
+{
+    auto everything = std::make_shared<RecordingSink>();
+    auto errors = std::make_shared<RecordingSink>();
+    logcoe::addSink(everything);
+    logcoe::SinkOptions options;
+    options.level = logcoe::LogLevel::ERROR;
+    logcoe::addSink(errors, options);
+    ASSERT_TRUE(logcoe::startCollector(name));
+
+    pid_t pid = spawnWorker([] {
+        logcoe::setLogLevel(logcoe::LogLevel::DEBUG);
+        logcoe::debug("Worker detail");
+        logcoe::info("Worker progress");
+        logcoe::error("Worker failure");
+    });
+    ASSERT_GT(pid, 0);
+    EXPECT_TRUE(exitedCleanly(pid));
+    logcoe::stopCollector();
+
+    std::string all = everything->text();
+    EXPECT_NE(all.find("[DEBUG]: Worker detail"), std::string::npos) << all;
+    EXPECT_NE(all.find("[INFO]: Worker progress"), std::string::npos) << all;
+    EXPECT_NE(all.find("[ERROR]: Worker failure"), std::string::npos) << all;
+    EXPECT_EQ(errors->text().find("Worker progress"), std::string::npos) << errors->text();
+    EXPECT_NE(errors->text().find("[ERROR]: Worker failure"), std::string::npos) << errors->text();
+}
+
+TEST_F(LogcoeSharedTest, LinesThatDoNotFitAreDroppedAndReported)
+{
+    auto sink = std::make_shared<RecordingSink>();
+    logcoe::addSink(sink);
+    logcoe::SharedLogOptions options;
+    options.capacity = 4096;
+    ASSERT_TRUE(logcoe::startCollector(name, options));
+
+    pid_t pid = spawnWorker([] {
+        logcoe::info("Huge " + std::string(64 * 1024, 'x'));
+        logcoe::info("Small line after it");
+    });
+    ASSERT_GT(pid, 0);
+    EXPECT_TRUE(exitedCleanly(pid));
+    logcoe::stopCollector();
+
+    std::string text = sink->text();
+    EXPECT_EQ(text.find("Huge"), std::string::npos);
+    EXPECT_NE(text.find("Small line after it"), std::string::npos) << text;
+    EXPECT_NE(text.find("[logcoe] WARNING: Shared log dropped 1 lines"), std::string::npos) << text;
+}
+
+TEST_F(LogcoeSharedTest, CollectorSkipsLinesOfWorkersThatExitedWhileWritingThem)
+{
+    auto sink = std::make_shared<RecordingSink>();
+    logcoe::addSink(sink);
+    ASSERT_TRUE(logcoe::startCollector(name));
+
+    // claims 64 bytes at head the way a worker does, then exits before moving head past them or writing the line
+    pid_t lost = ::fork();
+    if (lost == 0)
+    {
+        int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+        struct stat status{};
+        if (fd < 0 || ::fstat(fd, &status) != 0)
+            ::_exit(1);
+        void *memory = ::mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ | PROT_WRITE, MAP_SHARED,
+                              fd, 0);
+        if (memory == MAP_FAILED)
+            ::_exit(1);
+
+        auto *header = static_cast<RingHeader *>(memory);
+        std::uint64_t position = header->head.load();
+        char *record = static_cast<char *>(memory) + sizeof(RingHeader) + position % header->capacity;
+        std::uint64_t free = position / header->capacity;
+        bool claimed = reinterpret_cast<std::atomic<std::uint64_t> *>(record)->compare_exchange_strong(
+            free, static_cast<std::uint64_t>(::getpid()) << 32 | 64);
+        ::_exit(claimed ? 0 : 1);
+    }
+    ASSERT_GT(lost, 0);
+    EXPECT_TRUE(exitedCleanly(lost));
+
+    pid_t pid = spawnWorker([] { logcoe::info("Written after the lost line"); });
+    ASSERT_GT(pid, 0);
+    EXPECT_TRUE(exitedCleanly(pid));
+
+    // the collector gets past the lost line while it keeps running
+    const std::string skipped = "[logcoe] WARNING: Shared log skipped 1 lines of workers that exited";
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (sink->text().find(skipped) == std::string::npos && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    std::string text = sink->text();
+    EXPECT_NE(text.find("Written after the lost line"), std::string::npos) << text;
+    EXPECT_NE(text.find(skipped), std::string::npos) << text;
+    logcoe::stopCollector();
+}
+
+TEST_F(LogcoeSharedTest, ForkedChildOfAnAsyncCollectorLogsSynchronously)
+{
+    logcoe::shutdown();
+    logcoe::AsyncOptions async;
+    async.enabled = true;
+    logcoe::initialize(logcoe::LogLevel::INFO, "", false, false, "", async);
+    auto sink = std::make_shared<RecordingSink>();
+    logcoe::addSink(sink);
+    logcoe::FlushPolicy policy;
+    policy.interval = std::chrono::milliseconds(5);
+    logcoe::setFlushPolicy(policy);
+    logcoe::setStatsReport(std::chrono::milliseconds(5));
+    ASSERT_TRUE(logcoe::startCollector(name));
+    logcoe::info("Parent before fork");
+
+    pid_t pid = ::fork();
+    if (pid == 0)
+    {
+        // a child still waiting for the parent's writer thread is killed instead of hanging the test
+        ::alarm(10);
+        bool attached = !logcoe::isAsync() && logcoe::setSharedOutput(name);
+        if (attached)
+            logcoe::info("Child after fork");
+        logcoe::flush();
+        logcoe::shutdown();
+        ::_exit(attached ? 0 : 1);
+    }
+    ASSERT_GT(pid, 0);
+    EXPECT_TRUE(exitedCleanly(pid));
+
+    logcoe::info("Parent after fork");
+    logcoe::flush();
+    logcoe::stopCollector();
+    std::string text = sink->text();
+    EXPECT_EQ(count(text, "Parent before fork"), 1u) << text;
+    EXPECT_NE(text.find("Child after fork"), std::string::npos) << text;
+    EXPECT_NE(text.find("Parent after fork"), std::string::npos) << text;
+}
+
+TEST_F(LogcoeSharedTest, OneProcessCanBeWorkerAndCollector)
+{
+    auto sink = std::make_shared<RecordingSink>();
+    logcoe::addSink(sink);
+    ASSERT_TRUE(logcoe::startCollector(name));
+    ASSERT_TRUE(logcoe::setSharedOutput(name));
+
+    logcoe::warning("Through the ring", "self");
+    logcoe::flush();
+    logcoe::disableSharedOutput();
+    logcoe::info("Written directly");
+    logcoe::stopCollector();
+
+    std::string text = sink->text();
+    EXPECT_EQ(count(text, "Through the ring"), 1u) << text;
+    EXPECT_NE(text.find("[WARNING] [self]: Through the ring"), std::string::npos) << text;
+    EXPECT_NE(text.find("Written directly"), std::string::npos) << text;
+}
+
+TEST_F(LogcoeSharedTest, WorkersNeedARunningCollector)
+{
+    logcoe::setConsoleOutput(testStream);
+    EXPECT_FALSE(logcoe::setSharedOutput(name));
+    EXPECT_NE(testStream.str().find("[logcoe] ERROR: Failed to open shared log: " + name), std::string::npos);
+
+    // the collector removes the ring when it stops
+    ASSERT_TRUE(logcoe::startCollector(name));
+    logcoe::stopCollector();
+    EXPECT_FALSE(logcoe::setSharedOutput(name));
+}
+
+#endif
@@ -0,0 +1,516 @@
+#include <gtest/gtest.h>
+#include <logcoe.hpp>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // sink that records every write() and flush() call it receives
+    class RecordingSink : public logcoe::Sink
+    {
+    public:
+        std::vector<std::string> writes;
+        int flushes = 0;
+
+        void write(std::string_view lines) override { writes.emplace_back(lines); }
+        void flush() override { flushes++; }
+
+        std::string text() const
+        {
+            std::string all;
+            for (const auto &lines : writes)
+                all += lines;
+            return all;
+        }
+    };
+
+#ifndef _WIN32
+    // local collector for the socket sinks, bound to a fresh path
+    class SocketListener
+    {
+    public:
+        std::string path;
+        int fd = -1;
+        int peer = -1;
+
+        SocketListener(std::string socketPath, int type) : path(std::move(socketPath))
+        {
+            ::unlink(path.c_str());
+            fd = ::socket(AF_UNIX, type, 0);
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            path.copy(address.sun_path, sizeof(address.sun_path) - 1);
+            ::bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+            if (type == SOCK_STREAM)
+                ::listen(fd, 1);
+            peer = fd;
+        }
+        ~SocketListener()
+        {
+            if (peer != fd)
+                ::close(peer);
+            ::close(fd);
+            ::unlink(path.c_str());
+        }
+
+        void accept() { peer = ::accept(fd, nullptr, nullptr); }
+
+        // one datagram or whatever the stream has, empty once nothing arrives in time
+        std::string receive(bool wait = true)
+        {
+            char buffer[64 * 1024];
+            for (int attempt = 0; attempt < 200; attempt++)
+            {
+                ssize_t received = ::recv(peer, buffer, sizeof(buffer), MSG_DONTWAIT);
+                if (received >= 0)
+                    return std::string(buffer, static_cast<std::size_t>(received));
+                if (!wait)
+                    break;
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            return {};
+        }
+    };
+
+    logcoe::SinkStats sinkStats(logcoe::SinkId id)
+    {
+        for (const auto &sink : logcoe::getStats().sinks)
+            if (sink.id == id)
+                return sink;
+        return {};
+    }
+#endif
+}
+
+class LogcoeSinkTest : public ::testing::Test
+{
+protected:
+    std::string testFilename;
+
+    void SetUp() override
+    {
+        testFilename = "sink_test_" + std::to_string(std::chrono::system_clock::now().time_since_epoch().count()) + ".log";
+
+        while(logcoe::isInitialized()) { logcoe::shutdown(); }
+    }
+
+    void TearDown() override
+    {
+        while(logcoe::isInitialized()) { logcoe::shutdown(); }
+
+        if (std::filesystem::exists(testFilename))
+            std::filesystem::remove(testFilename);
+    }
+
+    static std::string readFile(const std::string &path)
+    {
+        std::ifstream file(path);
+        return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    }
+};
+
+TEST_F(LogcoeSinkTest, EachSinkFiltersByItsOwnLevel)
+{
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", false, false);
+
+    auto verbose = std::make_shared<RecordingSink>();
+    auto errors = std::make_shared<RecordingSink>();
+    logcoe::SinkOptions errorOptions;
+    errorOptions.level = logcoe::LogLevel::ERROR;
+    EXPECT_NE(logcoe::addSink(verbose), 0u);
+    EXPECT_NE(logcoe::addSink(errors, errorOptions), 0u);
+
+    logcoe::debug("Debug line");
+    logcoe::warning("Warning line");
+    logcoe::error("Error line");
+
+    EXPECT_NE(verbose->text().find("[DEBUG]: Debug line"), std::string::npos);
+    EXPECT_NE(verbose->text().find("[ERROR]: Error line"), std::string::npos);
+    EXPECT_EQ(errors->text().find("Debug line"), std::string::npos);
+    EXPECT_EQ(errors->text().find("Warning line"), std::string::npos);
+    EXPECT_NE(errors->text().find("[ERROR]: Error line"), std::string::npos);
+}
+
+TEST_F(LogcoeSinkTest, BufferedSinkWritesOnFlush)
+{
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", false, false);
+
+    auto sink = std::make_shared<RecordingSink>();
+    logcoe::SinkOptions options;
+    options.bufferSize = 4096;
+    logcoe::addSink(sink, options);
+
+    for (int i = 0; i < 10; i++)
+        logcoe::info("Buffered " + std::to_string(i), "", false);
+    logcoe::flush();
+
+    ASSERT_EQ(sink->writes.size(), 1u);
+    EXPECT_NE(sink->writes[0].find("Buffered 0"), std::string::npos);
+    EXPECT_NE(sink->writes[0].find("Buffered 9"), std::string::npos);
+    EXPECT_GE(sink->flushes, 1);
+}
+
+TEST_F(LogcoeSinkTest, FlushLevelFlushesBufferedSink)
+{
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", false, false);
+
+    auto sink = std::make_shared<RecordingSink>();
+    logcoe::SinkOptions options;
+    options.bufferSize = 4096;
+    options.flushLevel = logcoe::LogLevel::ERROR;
+    logcoe::addSink(sink, options);
+
+    logcoe::warning("Held back", "", false);
+    EXPECT_TRUE(sink->writes.empty());
+
+    logcoe::error("Flushes everything", "", false);
+    ASSERT_EQ(sink->writes.size(), 1u);
+    EXPECT_NE(sink->writes[0].find("Held back"), std::string::npos);
+    EXPECT_NE(sink->writes[0].find("Flushes everything"), std::string::npos);
+}
+
+TEST_F(LogcoeSinkTest, FileSinkAlongsideConsole)
+{
+    std::stringstream console;
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", true, false);
+    logcoe::setConsoleOutput(console);
+
+    auto file = logcoe::makeFileSink(testFilename, true);
+    ASSERT_NE(file, nullptr);
+    logcoe::SinkOptions options;
+    options.level = logcoe::LogLevel::WARNING;
+    logcoe::SinkId id = logcoe::addSink(file, options);
+
+    logcoe::info("Console only");
+    logcoe::warning("Both outputs");
+    EXPECT_TRUE(logcoe::removeSink(id));
+    EXPECT_FALSE(logcoe::removeSink(id));
+    logcoe::warning("After removal");
+
+    std::string content = readFile(testFilename);
+    EXPECT_EQ(content.find("Console only"), std::string::npos);
+    EXPECT_NE(content.find("[WARNING]: Both outputs"), std::string::npos);
+    EXPECT_EQ(content.find("After removal"), std::string::npos);
+    EXPECT_NE(console.str().find("Console only"), std::string::npos);
+    EXPECT_NE(console.str().find("After removal"), std::string::npos);
+
+    logcoe::shutdown();
+}
+
+TEST_F(LogcoeSinkTest, SinkLevelsRaiseTheCallSiteGate)
+{
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", false, false);
+
+    logcoe::SinkId id = logcoe::addSink(std::make_shared<logcoe::NullSink>());
+    EXPECT_TRUE(logcoe::isEnabled(logcoe::LogLevel::DEBUG));
+
+    EXPECT_TRUE(logcoe::setSinkLevel(id, logcoe::LogLevel::ERROR));
+    EXPECT_FALSE(logcoe::isEnabled(logcoe::LogLevel::WARNING));
+    EXPECT_TRUE(logcoe::isEnabled(logcoe::LogLevel::ERROR));
+
+    bool evaluated = false;
+    logcoe::debug([&] { evaluated = true; return std::string("never built"); });
+    EXPECT_FALSE(evaluated);
+
+    EXPECT_FALSE(logcoe::setSinkLevel(id + 1, logcoe::LogLevel::DEBUG));
+    EXPECT_TRUE(logcoe::removeSink(id));
+    EXPECT_TRUE(logcoe::isEnabled(logcoe::LogLevel::DEBUG));
+}
+
+TEST_F(LogcoeSinkTest, MappedFileSinkRollsSegmentsAndTrimsOnShutdown)
+{
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", false, false);
+
+    auto mapped = logcoe::makeMappedFileSink(testFilename, 4096, true);
+    ASSERT_NE(mapped, nullptr);
+    logcoe::addSink(mapped);
+
+    const std::string padding(80, 'm');
+    for (int i = 0; i < 200; i++)
+        logcoe::info("Mapped " + std::to_string(i) + " " + padding, "", i % 50 == 0);
+    logcoe::shutdown();
+
+    std::string content = readFile(testFilename);
+    EXPECT_GT(content.size(), 3u * 4096u);
+    EXPECT_EQ(std::filesystem::file_size(testFilename), content.size());
+    EXPECT_EQ(content.find('\0'), std::string::npos);
+    EXPECT_EQ(content.back(), '\n');
+    for (int i = 0; i < 200; i++)
+        EXPECT_NE(content.find("Mapped " + std::to_string(i) + " "), std::string::npos);
+}
+
+#ifndef _WIN32
+TEST_F(LogcoeSinkTest, MappedFileSinkWritesAndCountsLinesItCannotMap)
+{
+    // the file size limit lets two 4096 byte segments be reserved but not the third, pwrite() then fills the file
+    // up to the limit and the lines past it are dropped
+    constexpr std::size_t lineLength = 100;
+    constexpr int lines = 200;
+    constexpr rlim_t limit = 10240;
+    int report[2];
+    ASSERT_EQ(::pipe(report), 0);
+
+    pid_t child = ::fork();
+    ASSERT_GE(child, 0);
+    if (child == 0)
+    {
+        std::signal(SIGXFSZ, SIG_IGN);
+        rlimit size{limit, limit};
+        setrlimit(RLIMIT_FSIZE, &size);
+
+        auto mapped = logcoe::makeMappedFileSink(testFilename, 4096);
+        const std::string line = std::string(lineLength - 1, 'x') + '\n';
+        for (int i = 0; i < lines; i++)
+            mapped->write(line);
+        mapped->close();
+
+        std::uint64_t dropped = mapped->dropped();
+        ssize_t written = ::write(report[1], &dropped, sizeof(dropped));
+        _exit(written == sizeof(dropped) ? 0 : 1);
+    }
+
+    std::uint64_t dropped = 0;
+    ssize_t received = ::read(report[0], &dropped, sizeof(dropped));
+    int status = 0;
+    ::waitpid(child, &status, 0);
+    ::close(report[0]);
+    ::close(report[1]);
+    ASSERT_EQ(received, static_cast<ssize_t>(sizeof(dropped)));
+    ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    std::string content = readFile(testFilename);
+    auto complete = static_cast<std::uint64_t>(std::count(content.begin(), content.end(), '\n'));
+    EXPECT_EQ(content.size(), limit);
+    EXPECT_EQ(complete, limit / lineLength);
+    EXPECT_EQ(complete + dropped, static_cast<std::uint64_t>(lines));
+}
+#endif
+
+TEST_F(LogcoeSinkTest, UringFileSinkKeepsLinesInOrderAcrossBuffers)
+{
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", false, false);
+
+    // small buffers, so most of them are in flight while the next one fills
+    auto uring = logcoe::makeUringFileSink(testFilename, false, 4096, 3);
+    ASSERT_NE(uring, nullptr);
+    logcoe::addSink(uring);
+
+    const std::string padding(90, 'u');
+    for (int i = 0; i < 2000; i++)
+        logcoe::info("Ring " + std::to_string(i) + " " + padding, "", i % 100 == 0);
+    logcoe::shutdown();
+
+    std::istringstream content(readFile(testFilename));
+    int expected = 0;
+    for (std::string line; std::getline(content, line); expected++)
+    {
+        ASSERT_NE(line.find("Ring " + std::to_string(expected) + " "), std::string::npos) << line;
+        EXPECT_EQ(line.substr(line.size() - padding.size()), padding);
+    }
+    EXPECT_EQ(expected, 2000);
+}
+
+TEST_F(LogcoeSinkTest, UringFileSinkFlushReachesTheFile)
+{
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", false, false);
+    logcoe::SinkId id = logcoe::addSink(logcoe::makeUringFileSink(testFilename, true));
+
+    // flush() submits without waiting, the write lands shortly after
+    logcoe::warning("Synced through the ring");
+    bool found = false;
+    for (int attempt = 0; attempt < 200 && !found; attempt++)
+    {
+        found = readFile(testFilename).find("Synced through the ring") != std::string::npos;
+        if (!found)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_TRUE(found);
+
+    logcoe::info("Written on removal", "", false);
+    EXPECT_TRUE(logcoe::removeSink(id));
+    EXPECT_NE(readFile(testFilename).find("Written on removal"), std::string::npos);
+}
+
+TEST_F(LogcoeSinkTest, FlushPolicyBuffersUntilBytesOrLevel)
+{
+    std::stringstream console;
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", true, false);
+    logcoe::setConsoleOutput(console);
+    console.str("");
+
+    logcoe::FlushPolicy policy;
+    policy.bytes = 64 * 1024;
+    policy.level = logcoe::LogLevel::ERROR;
+    logcoe::setFlushPolicy(policy);
+
+    // more than one staging buffer, still below the byte threshold
+    const std::string padding(200, 'b');
+    for (int i = 0; i < 120; i++)
+        logcoe::info("Batched " + std::to_string(i) + " " + padding, "", false);
+    logcoe::warning("Below flush level", "", false);
+    EXPECT_TRUE(console.str().empty());
+
+    logcoe::error("Commit", "", false);
+    EXPECT_NE(console.str().find("Batched 0 "), std::string::npos);
+    EXPECT_NE(console.str().find("Below flush level"), std::string::npos);
+    EXPECT_NE(console.str().find("Commit"), std::string::npos);
+
+    policy.bytes = 0;
+    logcoe::setFlushPolicy(policy);
+    for (int i = 0; i < 120; i++)
+        logcoe::info("Unbatched " + std::to_string(i) + " " + padding, "", false);
+    EXPECT_NE(console.str().find("Unbatched 0 "), std::string::npos);
+
+    logcoe::shutdown();
+}
+
+TEST_F(LogcoeSinkTest, FlushPolicyIntervalWritesWithoutFlushCalls)
+{
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", false, true, testFilename);
+
+    logcoe::FlushPolicy policy;
+    policy.interval = std::chrono::milliseconds(20);
+    logcoe::setFlushPolicy(policy);
+
+    logcoe::info("Committed by the timer", "", false);
+
+    bool found = false;
+    for (int attempt = 0; attempt < 200 && !found; attempt++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        found = readFile(testFilename).find("Committed by the timer") != std::string::npos;
+    }
+    EXPECT_TRUE(found);
+}
+
+#ifndef _WIN32
+
+TEST_F(LogcoeSinkTest, SocketSinkSendsOneDatagramPerLine)
+{
+    SocketListener collector(testFilename + ".sock", SOCK_DGRAM);
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", false, false);
+
+    auto socket = logcoe::makeSocketSink(collector.path);
+    ASSERT_NE(socket, nullptr);
+    logcoe::SinkId id = logcoe::addSink(socket);
+
+    logcoe::info("First datagram");
+    logcoe::warning("Second datagram", "net");
+
+    std::string first = collector.receive();
+    std::string second = collector.receive();
+    EXPECT_NE(first.find("[INFO]: First datagram"), std::string::npos) << first;
+    EXPECT_NE(second.find("[WARNING] [net]: Second datagram"), std::string::npos) << second;
+    EXPECT_NE(first.back(), '\n');
+    EXPECT_EQ(sinkStats(id).dropped, 0u);
+
+    EXPECT_EQ(logcoe::makeSocketSink(std::string(200, 's')), nullptr);
+}
+
+TEST_F(LogcoeSinkTest, SocketSinkDropsWhileCollectorIsMissingAndReconnects)
+{
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", false, false);
+
+    logcoe::SocketOptions options;
+    options.reconnectInterval = std::chrono::milliseconds(10);
+    logcoe::SinkId id = logcoe::addSink(logcoe::makeSocketSink(testFilename + ".sock", options));
+
+    logcoe::info("Nobody listens");
+    logcoe::info("Still nobody");
+    EXPECT_EQ(sinkStats(id).dropped, 2u);
+
+    SocketListener collector(testFilename + ".sock", SOCK_DGRAM);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    logcoe::info("Collector is back");
+
+    EXPECT_NE(collector.receive().find("Collector is back"), std::string::npos);
+    EXPECT_EQ(sinkStats(id).dropped, 2u);
+}
+
+TEST_F(LogcoeSinkTest, DatagramSocketSinkDropsInsteadOfBlocking)
+{
+    SocketListener collector(testFilename + ".sock", SOCK_DGRAM);
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", false, false);
+    logcoe::SinkId id = logcoe::addSink(logcoe::makeSocketSink(collector.path));
+
+    // nothing is read meanwhile, the socket's queue fills up long before the end
+    const int total = 5000;
+    for (int i = 0; i < total; i++)
+        logcoe::info("Burst " + std::to_string(i));
+
+    std::uint64_t dropped = sinkStats(id).dropped;
+    EXPECT_GT(dropped, 0u);
+
+    std::uint64_t received = 0;
+    while (!collector.receive(false).empty())
+        received++;
+    EXPECT_EQ(received + dropped, static_cast<std::uint64_t>(total));
+}
+
+TEST_F(LogcoeSinkTest, StreamSocketSinkKeepsWholeLinesUnderBackpressure)
+{
+    SocketListener collector(testFilename + ".sock", SOCK_STREAM);
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", false, false);
+
+    logcoe::SocketOptions options;
+    options.type = logcoe::SocketType::STREAM;
+    options.backlog = 4096;
+    logcoe::SinkId id = logcoe::addSink(logcoe::makeSocketSink(collector.path, options));
+    collector.accept();
+
+    const int total = 20000;
+    const std::string padding(100, 'p');
+    for (int i = 0; i < total; i++)
+        logcoe::info("Streamed " + std::to_string(i) + " " + padding);
+
+    std::uint64_t dropped = sinkStats(id).dropped;
+    EXPECT_GT(dropped, 0u);
+
+    // reading makes room, flush() sends what the sink held back
+    std::string stream;
+    std::size_t lines = 0;
+    for (int attempt = 0; attempt < 500 && lines + dropped < total; attempt++)
+    {
+        std::string part = collector.receive(false);
+        if (part.empty())
+        {
+            logcoe::flush();
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        stream += part;
+        lines = static_cast<std::size_t>(std::count(stream.begin(), stream.end(), '\n'));
+    }
+    EXPECT_EQ(lines + dropped, static_cast<std::uint64_t>(total));
+    EXPECT_EQ(sinkStats(id).dropped, dropped);
+
+    std::istringstream received(stream);
+    int previous = -1;
+    for (std::string line; std::getline(received, line);)
+    {
+        auto start = line.find("Streamed ");
+        ASSERT_NE(start, std::string::npos) << line;
+        int number = std::stoi(line.substr(start + 9));
+        EXPECT_GT(number, previous);
+        EXPECT_EQ(line.substr(line.size() - padding.size()), padding);
+        previous = number;
+    }
+}
+
+#endif
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include <logcoe.hpp>
+#include <sstream>
+#include <string>
+
+class LogcoeSourceTest : public ::testing::Test
+{
+protected:
+    std::stringstream testStream;
+
+    void SetUp() override
+    {
+        while(logcoe::isInitialized()) { logcoe::shutdown(); }
+
+        logcoe::initialize(logcoe::LogLevel::INFO, "Default", true, false);
+        logcoe::setConsoleOutput(testStream);
+    }
+
+    void TearDown() override
+    {
+        while(logcoe::isInitialized()) { logcoe::shutdown(); }
+    }
+
+    bool contains(const std::string &text) { return testStream.str().find(text) != std::string::npos; }
+};
+
+TEST_F(LogcoeSourceTest, SameNameReturnsSameHandle)
+{
+    logcoe::Source first = logcoe::source("SourceTest.Interned");
+    logcoe::Source second = logcoe::source(std::string("SourceTest.Interned"));
+    logcoe::Source other = logcoe::source("SourceTest.Other");
+
+    EXPECT_EQ(first.id(), second.id());
+    EXPECT_NE(first.id(), other.id());
+    EXPECT_EQ(first.name(), "SourceTest.Interned");
+}
+
+TEST_F(LogcoeSourceTest, HandleCallsWriteTheSourceName)
+{
+    logcoe::Source network = logcoe::source("Network");
+
+    logcoe::info(network, "connected");
+    logcoe::warning(network, "retry {} of {}", 2, 3);
+    logcoe::error(network, LOGCOE_FMT("code {}"), 7);
+    logcoe::info(network, "done", {{"bytes", 512}});
+    logcoe::info("no handle");
+
+    EXPECT_TRUE(contains("[INFO] [Network]: connected"));
+    EXPECT_TRUE(contains("[WARNING] [Network]: retry 2 of 3"));
+    EXPECT_TRUE(contains("[ERROR] [Network]: code 7"));
+    EXPECT_TRUE(contains("[INFO] [Network]: done bytes=512"));
+    EXPECT_TRUE(contains("[INFO] [Default]: no handle"));
+
+    logcoe::setOutputFormat(logcoe::OutputFormat::JSON);
+    logcoe::info(network, "structured");
+    EXPECT_TRUE(contains("\"source\":\"Network\",\"message\":\"structured\""));
+}
+
+TEST_F(LogcoeSourceTest, SourceLevelOverridesGlobalLevel)
+{
+    logcoe::Source noisy = logcoe::source("SourceTest.Noisy");
+    logcoe::Source quiet = logcoe::source("SourceTest.Quiet");
+
+    noisy.setLevel(logcoe::LogLevel::DEBUG);
+    EXPECT_EQ(noisy.getLevel(), logcoe::LogLevel::DEBUG);
+    EXPECT_EQ(quiet.getLevel(), logcoe::LogLevel::INFO);
+    EXPECT_TRUE(noisy.isEnabled(logcoe::LogLevel::DEBUG));
+    EXPECT_FALSE(quiet.isEnabled(logcoe::LogLevel::DEBUG));
+    EXPECT_FALSE(logcoe::isEnabled(logcoe::LogLevel::DEBUG));
+
+    logcoe::debug(noisy, "noisy detail");
+    logcoe::debug(quiet, "quiet detail");
+    logcoe::debug("global detail");
+    EXPECT_TRUE(contains("noisy detail"));
+    EXPECT_FALSE(contains("quiet detail"));
+    EXPECT_FALSE(contains("global detail"));
+
+    quiet.setLevel(logcoe::LogLevel::ERROR);
+    logcoe::warning(quiet, "quiet warning");
+    logcoe::warning("global warning");
+    EXPECT_FALSE(contains("quiet warning"));
+    EXPECT_TRUE(contains("global warning"));
+
+    noisy.resetLevel();
+    quiet.resetLevel();
+    logcoe::debug(noisy, "after reset");
+    EXPECT_FALSE(contains("after reset"));
+
+    logcoe::setLogLevel(logcoe::LogLevel::DEBUG);
+    EXPECT_TRUE(quiet.isEnabled(logcoe::LogLevel::DEBUG));
+}
+
+TEST_F(LogcoeSourceTest, AsyncWriterKeepsSourceLevels)
+{
+    logcoe::shutdown();
+    logcoe::AsyncOptions async;
+    async.enabled = true;
+    logcoe::initialize(logcoe::LogLevel::WARNING, "", true, false, "logcoe.log", async);
+    logcoe::setConsoleOutput(testStream);
+
+    logcoe::Source worker = logcoe::source("SourceTest.Worker");
+    worker.setLevel(logcoe::LogLevel::DEBUG);
+    logcoe::debug(worker, "queued debug", false);
+    logcoe::info("queued info", "", false);
+    logcoe::flush();
+
+    EXPECT_TRUE(contains("[DEBUG] [SourceTest.Worker]: queued debug"));
+    EXPECT_FALSE(contains("queued info"));
+    worker.resetLevel();
+}
+
+TEST_F(LogcoeSourceTest, SinkLevelStillApplies)
+{
+    logcoe::Source verbose = logcoe::source("SourceTest.Verbose");
+    verbose.setLevel(logcoe::LogLevel::DEBUG);
+
+    logcoe::SinkOptions options;
+    options.level = logcoe::LogLevel::WARNING;
+    logcoe::disableConsoleOutput();
+    logcoe::addSink(logcoe::makeStreamSink(testStream), options);
+
+    EXPECT_FALSE(verbose.isEnabled(logcoe::LogLevel::INFO));
+    EXPECT_TRUE(verbose.isEnabled(logcoe::LogLevel::WARNING));
+    verbose.resetLevel();
+}
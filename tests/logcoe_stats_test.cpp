@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+#include <logcoe.hpp>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+
+class LogcoeStatsTest : public ::testing::Test
+{
+protected:
+    std::stringstream testStream;
+
+    void SetUp() override
+    {
+        while(logcoe::isInitialized()) { logcoe::shutdown(); }
+
+        logcoe::initialize(logcoe::LogLevel::DEBUG, "", true, false);
+        logcoe::setConsoleOutput(testStream);
+    }
+
+    void TearDown() override
+    {
+        while(logcoe::isInitialized()) { logcoe::shutdown(); }
+    }
+
+    static const logcoe::SinkStats *findSink(const logcoe::LogStats &stats, logcoe::SinkId id, const std::string &name)
+    {
+        for (const auto &sink : stats.sinks)
+        {
+            if (sink.id == id && sink.name == name)
+                return &sink;
+        }
+        return nullptr;
+    }
+};
+
+TEST_F(LogcoeStatsTest, CountsRecordsPerLevelAndSink)
+{
+    std::stringstream errors;
+    logcoe::SinkOptions options;
+    options.level = logcoe::LogLevel::ERROR;
+    logcoe::SinkId id = logcoe::addSink(logcoe::makeStreamSink(errors), options);
+
+    testStream.str("");
+    errors.str("");
+    logcoe::LogStats before = logcoe::getStats();
+    logcoe::debug("one");
+    logcoe::info("two");
+    logcoe::info("three");
+    logcoe::error("four");
+    logcoe::LogStats after = logcoe::getStats();
+
+    EXPECT_EQ(after.accepted[0] - before.accepted[0], 1u);
+    EXPECT_EQ(after.accepted[1] - before.accepted[1], 2u);
+    EXPECT_EQ(after.accepted[3] - before.accepted[3], 1u);
+    EXPECT_GE(after.bytesWritten - before.bytesWritten, testStream.str().size() + errors.str().size());
+    EXPECT_GE(after.writes - before.writes, 5u);
+    EXPECT_GE(after.flushes - before.flushes, 4u);
+
+    const logcoe::SinkStats *errorSink = findSink(after, id, "");
+    ASSERT_NE(errorSink, nullptr);
+    EXPECT_EQ(errorSink->lines, 1u);
+    EXPECT_EQ(errorSink->filtered, 3u);
+    EXPECT_EQ(errorSink->bytes, errors.str().size());
+    EXPECT_EQ(errorSink->buffered, 0u);
+
+    const logcoe::SinkStats *console = findSink(after, 0, "console");
+    ASSERT_NE(console, nullptr);
+    EXPECT_GE(console->lines, 4u);
+
+    logcoe::shutdown();
+}
+
+TEST_F(LogcoeStatsTest, CountsWaitsForASlowSink)
+{
+    class SlowSink : public logcoe::Sink
+    {
+    public:
+        void write(std::string_view) override { std::this_thread::sleep_for(std::chrono::milliseconds(5)); }
+    };
+    logcoe::SinkId id = logcoe::addSink(std::make_shared<SlowSink>());
+
+    logcoe::LogStats before = logcoe::getStats();
+    auto writer = [] {
+        for (int i = 0; i < 10; i++)
+            logcoe::error("slow " + std::to_string(i));
+    };
+    std::thread first(writer);
+    std::thread second(writer);
+    first.join();
+    second.join();
+    logcoe::LogStats after = logcoe::getStats();
+
+    const logcoe::SinkStats *slow = findSink(after, id, "");
+    ASSERT_NE(slow, nullptr);
+    EXPECT_GT(slow->lockContentions, 0u);
+    EXPECT_GT(slow->lockWaitNanoseconds, 0u);
+    EXPECT_GE(after.lockContentions - before.lockContentions, slow->lockContentions);
+    EXPECT_GE(after.lockWaitNanoseconds - before.lockWaitNanoseconds, slow->lockWaitNanoseconds);
+}
+
+TEST_F(LogcoeStatsTest, LatencyHistogramSamplesCalls)
+{
+    logcoe::LogStats before = logcoe::getStats();
+    for (int i = 0; i < 64; i++)
+        logcoe::info("sampled " + std::to_string(i), "", false);
+    logcoe::LogStats after = logcoe::getStats();
+
+    std::uint64_t samples = 0;
+    for (std::size_t bucket = 0; bucket < logcoe::LogStats::latencyBuckets; ++bucket)
+        samples += after.latency[bucket] - before.latency[bucket];
+    EXPECT_EQ(samples, 4u);
+    EXPECT_GE(after.latencyPercentile(0.99), after.latencyPercentile(0.5));
+    EXPECT_GT(after.latencyPercentile(0.5), 0u);
+}
+
+TEST_F(LogcoeStatsTest, ReportsAsyncQueue)
+{
+    logcoe::shutdown();
+    logcoe::AsyncOptions async;
+    async.enabled = true;
+    async.queueCapacity = 1024;
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", true, false, "logcoe.log", async);
+    logcoe::setConsoleOutput(testStream);
+
+    logcoe::info("queued", "", false);
+    logcoe::flush();
+
+    logcoe::LogStats stats = logcoe::getStats();
+    EXPECT_GE(stats.queueCapacity, 1024u);
+    EXPECT_EQ(stats.queueDepth, 0u);
+    EXPECT_EQ(stats.dropped, logcoe::getDroppedMessageCount());
+
+    logcoe::shutdown();
+    EXPECT_EQ(logcoe::getStats().queueCapacity, 0u);
+}
+
+TEST_F(LogcoeStatsTest, ReinitializedQueueHasTheNewCapacity)
+{
+    logcoe::shutdown();
+    logcoe::AsyncOptions async;
+    async.enabled = true;
+    async.queueCapacity = 4096;
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", false, false, "", async);
+    EXPECT_EQ(logcoe::getStats().queueCapacity, 4096u);
+    logcoe::shutdown();
+
+    async.queueCapacity = 64;
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", false, false, "", async);
+    EXPECT_EQ(logcoe::getStats().queueCapacity, 64u);
+    logcoe::shutdown();
+}
+
+TEST_F(LogcoeStatsTest, PeriodicReportGoesToTheChosenSink)
+{
+    std::stringstream dashboard;
+    logcoe::SinkId id = logcoe::addSink(logcoe::makeStreamSink(dashboard));
+    logcoe::disableConsoleOutput();
+    logcoe::info("before report");
+
+    // the report thread writes the stream, so only the sink's counters are read until it is stopped
+    logcoe::setStatsReport(std::chrono::milliseconds(10), id);
+    bool reported = false;
+    for (int attempt = 0; attempt < 200 && !reported; attempt++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        logcoe::LogStats stats = logcoe::getStats();
+        const logcoe::SinkStats *sink = findSink(stats, id, "");
+        reported = sink && sink->lines >= 2;
+    }
+    logcoe::setStatsReport(std::chrono::milliseconds(0));
+
+    EXPECT_TRUE(reported);
+    EXPECT_NE(dashboard.str().find("[logcoe] stats accepted="), std::string::npos);
+    EXPECT_NE(dashboard.str().find(" p99_ns="), std::string::npos);
+    EXPECT_EQ(testStream.str().find("[logcoe] stats"), std::string::npos);
+
+    logcoe::shutdown();
+}
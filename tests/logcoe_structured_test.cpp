@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include <logcoe.hpp>
+#include <cmath>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+class LogcoeStructuredTest : public ::testing::Test
+{
+protected:
+    std::stringstream testStream;
+
+    void SetUp() override
+    {
+        while(logcoe::isInitialized()) { logcoe::shutdown(); }
+
+        logcoe::initialize(logcoe::LogLevel::DEBUG, "", true, false);
+        logcoe::setConsoleOutput(testStream);
+        logcoe::setTimeFormat("%Y");
+        testStream.str("");
+    }
+
+    void TearDown() override
+    {
+        while(logcoe::isInitialized()) { logcoe::shutdown(); }
+    }
+
+    // the single line logged since the last call, without its timestamp
+    std::string takeLine(const std::string &afterTime)
+    {
+        std::string line = testStream.str();
+        testStream.str("");
+        EXPECT_FALSE(line.empty());
+        if (line.empty())
+            return line;
+
+        EXPECT_EQ(line.back(), '\n');
+        line.pop_back();
+        auto pos = line.find(afterTime);
+        return pos == std::string::npos ? line : line.substr(pos);
+    }
+};
+
+TEST_F(LogcoeStructuredTest, FieldsFollowTheMessageInTextLayout)
+{
+    logcoe::info("request done", {{"status", 200}, {"ms", 3.25}, {"user", "Ada Lovelace"}, {"cached", false}});
+    EXPECT_EQ(takeLine("[INFO]"), "[INFO]: request done status=200 ms=3.25 user=\"Ada Lovelace\" cached=false");
+
+    std::string path = "/var/log";
+    logcoe::warning("disk", {{"path", path}, {"free", std::uint64_t{42}}}, "Storage");
+    EXPECT_EQ(takeLine("[WARNING]"), "[WARNING] [Storage]: disk path=/var/log free=42");
+}
+
+TEST_F(LogcoeStructuredTest, JsonLinesEncodesTypesAndEscapes)
+{
+    logcoe::setOutputFormat(logcoe::OutputFormat::JSON);
+
+    logcoe::error("say \"hi\"\n", {{"dir", "C:\\logs"}, {"delta", -5}, {"ok", true}, {"ratio", NAN}}, "Api");
+    std::string line = takeLine("\"level\"");
+    EXPECT_EQ(line, "\"level\":\"ERROR\",\"source\":\"Api\",\"message\":\"say \\\"hi\\\"\\n\","
+                    "\"dir\":\"C:\\\\logs\",\"delta\":-5,\"ok\":true,\"ratio\":null}");
+
+    logcoe::info("plain");
+    EXPECT_EQ(takeLine("\"level\""), "\"level\":\"INFO\",\"message\":\"plain\"}");
+
+    logcoe::info("start", {});
+    EXPECT_EQ(testStream.str().rfind("{\"time\":\"", 0), 0u);
+}
+
+TEST_F(LogcoeStructuredTest, JsonEscapingFindsEveryCharacterInLongStrings)
+{
+    logcoe::setOutputFormat(logcoe::OutputFormat::JSON);
+
+    std::string value(100, 'a');
+    value[15] = '"';
+    value[16] = '\x01';
+    value[47] = '\\';
+    value[99] = '\t';
+    std::string expected(100, 'a');
+    expected.replace(99, 1, "\\t");
+    expected.replace(47, 1, "\\\\");
+    expected.replace(16, 1, "\\u0001");
+    expected.replace(15, 1, "\\\"");
+
+    logcoe::info("long", {{"value", value}});
+    EXPECT_EQ(takeLine("\"value\""), "\"value\":\"" + expected + "\"}");
+}
+
+TEST_F(LogcoeStructuredTest, LogfmtQuotesOnlyWhenNeeded)
+{
+    logcoe::setOutputFormat(logcoe::OutputFormat::LOGFMT);
+
+    logcoe::warning("slow query", {{"table", "users"}, {"ms", 12}, {"filter", "id=7"}, {"empty", ""}}, "Db");
+    EXPECT_EQ(takeLine("level="),
+              "level=WARNING source=Db msg=\"slow query\" table=users ms=12 filter=\"id=7\" empty=\"\"");
+}
+
+TEST_F(LogcoeStructuredTest, AsyncRecordsKeepTheirFields)
+{
+    logcoe::shutdown();
+    logcoe::AsyncOptions async;
+    async.enabled = true;
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", true, false, "logcoe.log", async);
+    logcoe::setConsoleOutput(testStream);
+    logcoe::setOutputFormat(logcoe::OutputFormat::JSON);
+    testStream.str("");
+
+    {
+        std::string user = "temporary";
+        logcoe::info("queued", {{"user", user}, {"attempt", 3}}, "", false);
+    }
+    logcoe::flush();
+
+    EXPECT_EQ(takeLine("\"level\""), "\"level\":\"INFO\",\"message\":\"queued\",\"user\":\"temporary\",\"attempt\":3}");
+}
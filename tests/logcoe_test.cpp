@@ -5,6 +5,9 @@
 #include <filesystem>
 #include <string>
 #include <regex>
+#include <chrono>
+#include <ctime>
+#include <thread>
 
 class LogcoeTest : public ::testing::Test
 {
@@ -192,4 +195,217 @@ TEST_F(LogcoeTest, TimeFormat)
     std::string output = testStream.str();
     std::regex timePattern("\\[\\d{2}:\\d{2}:\\d{2}\\]");
     EXPECT_TRUE(std::regex_search(output, timePattern));
-}
\ No newline at end of file
+}
+TEST_F(LogcoeTest, LevelGateTracksConfiguration)
+{
+    EXPECT_FALSE(logcoe::isEnabled(logcoe::LogLevel::ERROR));
+
+    logcoe::initialize(logcoe::LogLevel::WARNING);
+    EXPECT_FALSE(logcoe::isEnabled(logcoe::LogLevel::INFO));
+    EXPECT_TRUE(logcoe::isEnabled(logcoe::LogLevel::WARNING));
+
+    logcoe::setLogLevel(logcoe::LogLevel::DEBUG);
+    EXPECT_TRUE(logcoe::isEnabled(logcoe::LogLevel::DEBUG));
+
+    logcoe::shutdown();
+    EXPECT_FALSE(logcoe::isEnabled(logcoe::LogLevel::ERROR));
+}
+
+TEST_F(LogcoeTest, LazyMessageOnlyEvaluatedWhenEnabled)
+{
+    logcoe::initialize(logcoe::LogLevel::INFO);
+    logcoe::setConsoleOutput(testStream);
+
+    int evaluations = 0;
+    auto expensive = [&evaluations]() { evaluations++; return std::string("Lazy message"); };
+
+    logcoe::debug(expensive);
+    EXPECT_EQ(evaluations, 0);
+
+    logcoe::info(expensive, "LazySource");
+    EXPECT_EQ(evaluations, 1);
+
+    std::string output = testStream.str();
+    EXPECT_TRUE(matchesLogPattern(output, logcoe::LogLevel::INFO, "Lazy message", "LazySource"));
+    EXPECT_FALSE(matchesLogPattern(output, logcoe::LogLevel::DEBUG, "Lazy message"));
+}
+
+TEST_F(LogcoeTest, SubSecondTimePrecision)
+{
+    logcoe::initialize();
+    logcoe::setConsoleOutput(testStream);
+
+    logcoe::setTimeFormat("%H:%M:%S", logcoe::TimePrecision::MILLISECONDS);
+    logcoe::info("Millisecond message");
+    logcoe::setTimeFormat("%H:%M:%S", logcoe::TimePrecision::MICROSECONDS);
+    logcoe::info("Microsecond message");
+    logcoe::setTimeFormat("%H:%M:%S", logcoe::TimePrecision::NANOSECONDS);
+    logcoe::info("Nanosecond message");
+
+    std::string output = testStream.str();
+    EXPECT_TRUE(std::regex_search(output, std::regex("\\[\\d{2}:\\d{2}:\\d{2}\\.\\d{3}\\] \\[INFO\\]: Millisecond")));
+    EXPECT_TRUE(std::regex_search(output, std::regex("\\[\\d{2}:\\d{2}:\\d{2}\\.\\d{6}\\] \\[INFO\\]: Microsecond")));
+    EXPECT_TRUE(std::regex_search(output, std::regex("\\[\\d{2}:\\d{2}:\\d{2}\\.\\d{9}\\] \\[INFO\\]: Nanosecond")));
+}
+
+TEST_F(LogcoeTest, CachedTimestampMatchesStrftime)
+{
+    const std::string format = "%Y-%m-%d %H:%M:%S";
+    auto strftimeNow = [&format]()
+    {
+        std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+        std::tm tm_now;
+#ifdef _WIN32
+        localtime_s(&tm_now, &now);
+#else
+        localtime_r(&now, &tm_now);
+#endif
+        char buffer[64];
+        return std::string(buffer, std::strftime(buffer, sizeof(buffer), format.c_str(), &tm_now));
+    };
+
+    logcoe::initialize();
+    logcoe::setConsoleOutput(testStream);
+    logcoe::setTimeFormat(format);
+
+    // spans at least one second boundary, so the cached prefix gets rebuilt
+    auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(1200);
+    while (std::chrono::steady_clock::now() < end)
+    {
+        testStream.str("");
+
+        std::string before = strftimeNow();
+        logcoe::info("Timestamp check");
+        std::string after = strftimeNow();
+
+        std::string line = testStream.str();
+        ASSERT_GT(line.size(), format.size());
+        std::string timestamp = line.substr(1, line.find(']') - 1);
+        EXPECT_TRUE(timestamp == before || timestamp == after) << timestamp << " not in [" << before << ", " << after << "]";
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+}
+
+TEST_F(LogcoeTest, FormatStringArguments)
+{
+    logcoe::initialize();
+    logcoe::setConsoleOutput(testStream);
+
+    std::string user = "alice";
+    logcoe::info("user={} latency={}us ratio={} ok={}", 42, 1250u, 0.5, true);
+    logcoe::warning(LOGCOE_FMT("name={} id={}"), user, -7);
+    logcoe::error("braces {{}} {} {}", 'x', std::string_view("view"));
+
+    std::string output = testStream.str();
+    EXPECT_NE(output.find("[INFO]: user=42 latency=1250us ratio=0.5 ok=true"), std::string::npos) << output;
+    EXPECT_NE(output.find("[WARNING]: name=alice id=-7"), std::string::npos) << output;
+    EXPECT_NE(output.find("[ERROR]: braces {} x view"), std::string::npos) << output;
+}
+
+TEST_F(LogcoeTest, FormatKeepsSourceOverload)
+{
+    logcoe::initialize();
+    logcoe::setConsoleOutput(testStream);
+
+    std::string source = "SourceString";
+    logcoe::info("Plain message {}", source);
+    logcoe::info("Flushed message {}", "SourceLiteral", false);
+    logcoe::flush();
+
+    std::string output = testStream.str();
+    EXPECT_TRUE(matchesLogPattern(output, logcoe::LogLevel::INFO, "Plain message \\{\\}", "SourceString"));
+    EXPECT_TRUE(matchesLogPattern(output, logcoe::LogLevel::INFO, "Flushed message \\{\\}", "SourceLiteral"));
+
+    // reported once per message, the second call writes no new warning
+    EXPECT_NE(output.find("[logcoe] WARNING: Message \"Plain message {}\" was logged from source \"SourceString\""),
+              std::string::npos) << output;
+    EXPECT_NE(output.find("[logcoe] WARNING: Message \"Flushed message {}\""), std::string::npos) << output;
+
+    testStream.str("");
+    logcoe::info("Plain message {}", source);
+    logcoe::info("Escaped {{}}", source);
+    logcoe::flush();
+    EXPECT_EQ(testStream.str().find("[logcoe] WARNING"), std::string::npos) << testStream.str();
+}
+
+TEST_F(LogcoeTest, FormatWarnsOnceWhenArgumentsDoNotMatch)
+{
+    logcoe::initialize();
+    logcoe::setConsoleOutput(testStream);
+
+    logcoe::info("missing {} and {}", 1);
+    logcoe::info("extra {}", 1, 2);
+    logcoe::info("missing {} and {}", 3);
+    logcoe::info("exact {} {}", 1, 2);
+    logcoe::flush();
+
+    std::string output = testStream.str();
+    EXPECT_NE(output.find("missing 1 and {}"), std::string::npos) << output;
+    EXPECT_NE(output.find("extra 1"), std::string::npos) << output;
+
+    const std::string missing = "[logcoe] WARNING: Format \"missing {} and {}\" has 2 placeholders for 1 arguments";
+    std::size_t first = output.find(missing);
+    ASSERT_NE(first, std::string::npos) << output;
+    EXPECT_EQ(output.find(missing, first + 1), std::string::npos) << output;
+    EXPECT_NE(output.find("[logcoe] WARNING: Format \"extra {}\" has 1 placeholders for 2 arguments"),
+              std::string::npos) << output;
+    EXPECT_EQ(output.find("Format \"exact"), std::string::npos) << output;
+}
+
+TEST_F(LogcoeTest, FormatFunctionsNeverTakeASource)
+{
+    logcoe::initialize();
+    logcoe::setConsoleOutput(testStream);
+
+    std::string name = "alice";
+    const char *role = "admin";
+    logcoe::infof("user={}", name);
+    logcoe::warningf("role={} flush={}", role, false);
+    logcoe::errorf(LOGCOE_FMT("{} of {}"), name, role);
+    logcoe::debugf("debug {}", name);
+
+    std::string output = testStream.str();
+    EXPECT_NE(output.find("[INFO]: user=alice"), std::string::npos) << output;
+    EXPECT_NE(output.find("[WARNING]: role=admin flush=false"), std::string::npos) << output;
+    EXPECT_NE(output.find("[ERROR]: alice of admin"), std::string::npos) << output;
+    EXPECT_NE(output.find("[DEBUG]: debug alice"), std::string::npos) << output;
+    EXPECT_EQ(output.find("[alice]"), std::string::npos) << output;
+}
+
+namespace
+{
+    // formatting it logs a line of its own
+    struct Chatty
+    {
+        int id;
+    };
+
+    std::ostream &operator<<(std::ostream &out, const Chatty &value)
+    {
+        logcoe::infof("formatting chatty {} of {}", value.id, std::string("the inner call"));
+        return out << "chatty#" << value.id;
+    }
+}
+
+TEST_F(LogcoeTest, ArgumentThatLogsDoesNotClobberTheMessage)
+{
+    logcoe::initialize();
+    logcoe::setConsoleOutput(testStream);
+
+    logcoe::infof("outer {} then {} done", std::string("first"), Chatty{7});
+
+    std::string output = testStream.str();
+    EXPECT_NE(output.find("[INFO]: formatting chatty 7 of the inner call\n"), std::string::npos) << output;
+    EXPECT_NE(output.find("[INFO]: outer first then chatty#7 done\n"), std::string::npos) << output;
+}
+
+TEST_F(LogcoeTest, FormatHelper)
+{
+    int value = 5;
+    EXPECT_EQ(logcoe::format("{} + {} = {}", 2, 3u, 5LL), "2 + 3 = 5");
+    EXPECT_EQ(logcoe::format("{} {}", 1.25f, static_cast<const char *>(nullptr)), "1.25 (null)");
+    EXPECT_EQ(logcoe::format("missing {} {}", 1), "missing 1 {}");
+    EXPECT_EQ(logcoe::format("{}", &value).rfind("0x", 0), 0u);
+    EXPECT_EQ(logcoe::format("{}", logcoe::LogLevel::ERROR), "3");
+}
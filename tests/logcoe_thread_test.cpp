@@ -282,4 +282,94 @@ TEST_F(LogcoeThreadTest, ConcurrentOutputConfigChange)
 
     for (auto &thread : threads)
         thread.join();
-}
\ No newline at end of file
+}
+TEST_F(LogcoeThreadTest, ReconfigurationKeepsEveryLine)
+{
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", false, false);
+    std::stringstream kept;
+    logcoe::addSink(logcoe::makeStreamSink(kept));
+
+    std::atomic<int> running(NUM_THREADS);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < NUM_THREADS; i++)
+    {
+        threads.emplace_back([this, &running]()
+                             {
+            for (int j = 0; j < MESSAGES_PER_THREAD * 5; j++)
+                logcoe::info("Reconfigured " + std::to_string(j), "", false);
+            running--; });
+    }
+
+    // loggers read the configuration from snapshots, so none of this stops them or loses a line
+    int changes = 0;
+    while (running.load() > 0 || changes < 10)
+    {
+        std::stringstream extra;
+        logcoe::SinkId id = logcoe::addSink(logcoe::makeStreamSink(extra));
+        logcoe::setTimeFormat(changes % 2 ? "%H:%M:%S" : "%Y-%m-%d %H:%M:%S", logcoe::TimePrecision::MICROSECONDS);
+        logcoe::setLogLevel(changes % 2 ? logcoe::LogLevel::DEBUG : logcoe::LogLevel::INFO);
+        logcoe::removeSink(id);
+        changes++;
+    }
+
+    for (auto &thread : threads)
+        thread.join();
+    logcoe::flush();
+
+    std::string content = kept.str();
+    std::size_t lines = 0;
+    for (auto pos = content.find("Reconfigured "); pos != std::string::npos; pos = content.find("Reconfigured ", pos + 1))
+        lines++;
+    EXPECT_EQ(lines, static_cast<std::size_t>(NUM_THREADS * MESSAGES_PER_THREAD * 5));
+
+    logcoe::shutdown();
+}
+
+TEST_F(LogcoeThreadTest, FlushPublishesStagedLinesInThreadOrder)
+{
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", false, true, testFilename);
+
+    std::atomic<int> finished(0);
+    std::atomic<bool> release(false);
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < NUM_THREADS; i++)
+    {
+        threads.emplace_back([this, i, &finished, &release]()
+                             {
+            std::string thread_name = "Staged-" + std::to_string(i);
+            for (int j = 0; j < MESSAGES_PER_THREAD; j++)
+                logcoe::info("Message " + std::to_string(j), thread_name, false);
+
+            finished++;
+            while (!release.load())
+                std::this_thread::sleep_for(std::chrono::milliseconds(1)); });
+    }
+
+    while (finished.load() < NUM_THREADS)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    // the producers are still alive, so their staged lines can only reach the file through flush()
+    logcoe::flush();
+
+    std::ifstream file(testFilename);
+    std::vector<int> next(NUM_THREADS, 0);
+    std::string line;
+    while (std::getline(file, line))
+    {
+        auto pos = line.find("[Staged-");
+        if (pos == std::string::npos)
+            continue;
+
+        int thread = std::stoi(line.substr(pos + 8));
+        int message = std::stoi(line.substr(line.find("Message ") + 8));
+        EXPECT_EQ(message, next[thread]++) << line;
+    }
+
+    release = true;
+    for (auto &thread : threads)
+        thread.join();
+
+    for (int i = 0; i < NUM_THREADS; i++)
+        EXPECT_EQ(next[i], MESSAGES_PER_THREAD) << "Thread " << i;
+}
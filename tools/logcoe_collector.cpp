@@ -0,0 +1,35 @@
+#include <logcoe.hpp>
+#include <csignal>
+#include <iostream>
+
+// Writes the lines that worker processes log through logcoe::setSharedOutput() to stdout or a log file, until
+// SIGINT or SIGTERM
+int main(int argc, char **argv)
+{
+    if (argc != 2 && argc != 3)
+    {
+        std::cerr << "usage: logcoe-collector <shared log name> [log file]" << std::endl;
+        return 2;
+    }
+
+    // blocked before the collector thread starts, so only sigwait() below receives them
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    bool toFile = argc == 3;
+    logcoe::initialize(logcoe::LogLevel::DEBUG, "", !toFile, toFile, toFile ? argv[2] : "logcoe.log");
+    if (!logcoe::startCollector(argv[1]))
+    {
+        std::cerr << "logcoe-collector: failed to create " << argv[1] << std::endl;
+        logcoe::shutdown();
+        return 1;
+    }
+
+    int signal = 0;
+    sigwait(&signals, &signal);
+    logcoe::shutdown();
+    return 0;
+}
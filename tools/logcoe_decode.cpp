@@ -0,0 +1,20 @@
+#include <logcoe.hpp>
+#include <iostream>
+
+// Converts a file written by logcoe::setBinaryOutput back to text lines on stdout
+int main(int argc, char **argv)
+{
+    if (argc != 2)
+    {
+        std::cerr << "usage: logcoe-decode <binary log file>" << std::endl;
+        return 2;
+    }
+
+    if (!logcoe::decodeBinaryLog(argv[1], std::cout))
+    {
+        std::cerr << "logcoe-decode: failed to decode " << argv[1] << std::endl;
+        return 1;
+    }
+
+    return 0;
+}